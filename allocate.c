@@ -43,6 +43,19 @@
 #include "expression.h"
 #include "linearize.h"
 
+struct allocator_struct *allocator_list;
+
+/* The number of bytes in blobs for all the allocators. */
+unsigned long get_allocator_bytes(void)
+{
+	struct allocator_struct *desc;
+	unsigned long total = 0;
+
+	for (desc = allocator_list; desc; desc = desc->next)
+		total += desc->total_bytes;
+	return total;
+}
+
 void protect_allocations(struct allocator_struct *desc)
 {
 	desc->blobs = NULL;
@@ -106,6 +119,13 @@ void *allocate(struct allocator_struct *desc, unsigned int size)
 		if (size > chunking)
 			die("alloc too big");
 		desc->total_bytes += chunking;
+		if (desc->total_bytes > desc->peak_bytes)
+			desc->peak_bytes = desc->total_bytes;
+		if (!desc->listed) {
+			desc->listed = 1;
+			desc->next = allocator_list;
+			allocator_list = desc;
+		}
 		newblob->next = blob;
 		blob = newblob;
 		desc->blobs = newblob;
@@ -17,6 +17,10 @@ struct allocator_struct {
 	void *freelist;
 	/* statistics */
 	unsigned long allocations, total_bytes, useful_bytes;
+	unsigned long peak_bytes;
+	/* all the allocators which have been used, see allocator_list */
+	struct allocator_struct *next;
+	int listed;
 };
 
 struct allocator_stats {
@@ -25,6 +29,9 @@ struct allocator_stats {
 	unsigned long total_bytes, useful_bytes;
 };
 
+extern struct allocator_struct *allocator_list;
+extern unsigned long get_allocator_bytes(void);
+
 extern void protect_allocations(struct allocator_struct *desc);
 extern void drop_all_allocations(struct allocator_struct *desc);
 extern void *allocate(struct allocator_struct *desc, unsigned int size);
@@ -43,6 +43,7 @@ static bool checkOrder(struct stree *avl);
 static size_t countNode(AvlNode *node);
 
 int unfree_stree;
+unsigned long avl_node_count;
 
 /*
  * Utility macros for converting between
@@ -88,6 +89,7 @@ void free_stree(struct stree **avl)
 	unfree_stree--;
 
 	freeNode((*avl)->root);
+	free((*avl)->has_states);
 	free(*avl);
 	*avl = NULL;
 }
@@ -112,6 +114,50 @@ AvlNode *avl_lookup_node(const struct stree *avl, const struct sm_state *sm)
 	return lookup(avl, avl->root, sm);
 }
 
+struct sm_state *avl_lower_bound(const struct stree *avl, int owner, const char *name)
+{
+	const struct sm_state *found = NULL;
+	AvlNode *node;
+	int cmp;
+
+	if (!avl)
+		return NULL;
+
+	node = avl->root;
+	while (node) {
+		cmp = owner - node->sm->owner;
+		if (cmp == 0)
+			cmp = strcmp(name, node->sm->name);
+		if (cmp <= 0) {
+			found = node->sm;
+			node = node->lr[0];
+		} else {
+			node = node->lr[1];
+		}
+	}
+	return (struct sm_state *)found;
+}
+
+struct sm_state *avl_next(const struct stree *avl, const struct sm_state *sm)
+{
+	const struct sm_state *found = NULL;
+	AvlNode *node;
+
+	if (!avl)
+		return NULL;
+
+	node = avl->root;
+	while (node) {
+		if (cmp_tracker(sm, node->sm) < 0) {
+			found = node->sm;
+			node = node->lr[0];
+		} else {
+			node = node->lr[1];
+		}
+	}
+	return (struct sm_state *)found;
+}
+
 size_t stree_count(const struct stree *avl)
 {
 	if (!avl)
@@ -119,18 +165,49 @@ size_t stree_count(const struct stree *avl)
 	return avl->count;
 }
 
+/*
+ * The nodes are reference counted and shared between strees.  A new stree
+ * starts out pointing to the same root and the nodes are copied when they
+ * are changed.  An insert or remove only copies the nodes on the path it
+ * takes, which is O(log n).
+ */
 static struct stree *clone_stree_real(struct stree *orig)
 {
 	struct stree *new = avl_new();
-	AvlIter i;
-
-	avl_foreach(i, orig)
-		avl_insert(&new, i.sm);
 
+	new->root = orig->root;
+	if (new->root)
+		new->root->references++;
+	new->count = orig->count;
+	memcpy(new->has_states, orig->has_states, num_checks + 1);
 	new->base_stree = orig->base_stree;
 	return new;
 }
 
+/* Make *p a node which only this stree uses so it can be changed. */
+static AvlNode *own_node(AvlNode **p)
+{
+	AvlNode *node = *p;
+	AvlNode *copy;
+
+	if (node->references == 1)
+		return node;
+
+	copy = malloc(sizeof(*copy));
+	assert(copy != NULL);
+	avl_node_count++;
+	*copy = *node;
+	copy->references = 1;
+	if (copy->lr[0])
+		copy->lr[0]->references++;
+	if (copy->lr[1])
+		copy->lr[1]->references++;
+
+	node->references--;
+	*p = copy;
+	return copy;
+}
+
 bool avl_insert(struct stree **avl, const struct sm_state *sm)
 {
 	size_t old_count;
@@ -149,13 +226,113 @@ bool avl_insert(struct stree **avl, const struct sm_state *sm)
 	return (*avl)->count != old_count;
 }
 
+static AvlNode *build_nodes(struct sm_state **sms, int nr, int *height)
+{
+	AvlNode *node;
+	int mid = nr / 2;
+	int h0, h1;
+
+	if (nr == 0) {
+		*height = 0;
+		return NULL;
+	}
+
+	node = mkNode(sms[mid]);
+	node->lr[0] = build_nodes(sms, mid, &h0);
+	node->lr[1] = build_nodes(sms + mid + 1, nr - mid - 1, &h1);
+	/* the two halves are the same size, give or take one */
+	node->balance = h1 - h0;
+	*height = (h0 > h1 ? h0 : h1) + 1;
+	return node;
+}
+
+struct stree *avl_from_sorted(struct sm_state **sms, int nr)
+{
+	struct stree *avl;
+	int height;
+	int i;
+
+	if (nr == 0)
+		return NULL;
+
+	avl = avl_new();
+	for (i = 0; i < nr; i++) {
+		if (sms[i]->owner != USHRT_MAX)
+			avl->has_states[sms[i]->owner] = 1;
+	}
+	avl->root = build_nodes(sms, nr, &height);
+	avl->count = nr;
+	return avl;
+}
+
+void avl_insert_sorted(struct stree **avl, struct sm_state **sms, int nr)
+{
+	struct sm_state **merged;
+	struct stree *new;
+	size_t count;
+	int log = 0;
+	int i, j, cmp;
+	AvlIter iter;
+
+	if (nr == 0)
+		return;
+	if (!*avl) {
+		*avl = avl_from_sorted(sms, nr);
+		return;
+	}
+
+	/* a few inserts are cheaper than building a new tree */
+	count = (*avl)->count;
+	while ((1UL << log) <= count)
+		log++;
+	if ((size_t)nr * log < count) {
+		for (i = 0; i < nr; i++)
+			avl_insert(avl, sms[i]);
+		return;
+	}
+
+	merged = malloc((count + nr) * sizeof(*merged));
+	assert(merged != NULL);
+
+	i = j = 0;
+	avl_iter_begin(&iter, *avl, FORWARD);
+	while (iter.sm || j < nr) {
+		if (!iter.sm)
+			cmp = 1;
+		else if (j == nr)
+			cmp = -1;
+		else
+			cmp = cmp_tracker(iter.sm, sms[j]);
+
+		if (cmp < 0) {
+			merged[i++] = iter.sm;
+			avl_iter_next(&iter);
+		} else {
+			merged[i++] = sms[j++];
+			if (cmp == 0)
+				avl_iter_next(&iter);
+		}
+	}
+
+	new = avl_from_sorted(merged, i);
+	free(merged);
+
+	new->base_stree = (*avl)->base_stree;
+	if ((*avl)->references == 1)
+		new->stree_id = (*avl)->stree_id;
+	free_stree(avl);
+	*avl = new;
+}
+
 bool avl_remove(struct stree **avl, const struct sm_state *sm)
 {
 	AvlNode *node = NULL;
 
 	if (!*avl)
 		return false;
-	/* it's fairly rare for smatch to call avl_remove */
+	/* don't copy anything if there is nothing to remove */
+	if (!lookup(*avl, (*avl)->root, sm))
+		return false;
 	if ((*avl)->references > 1) {
 		(*avl)->references--;
 		*avl = clone_stree_real(*avl);
@@ -170,6 +347,7 @@ bool avl_remove(struct stree **avl, const struct sm_state *sm)
 		return false;
 	} else {
 		free(node);
+		avl_node_count--;
 		return true;
 	}
 }
@@ -179,20 +357,23 @@ static AvlNode *mkNode(const struct sm_state *sm)
 	AvlNode *node = malloc(sizeof(*node));
 
 	assert(node != NULL);
+	avl_node_count++;
 
 	node->sm = sm;
 	node->lr[0] = NULL;
 	node->lr[1] = NULL;
 	node->balance = 0;
+	node->references = 1;
 	return node;
 }
 
 static void freeNode(AvlNode *node)
 {
-	if (node) {
+	if (node && --node->references == 0) {
 		freeNode(node->lr[0]);
 		freeNode(node->lr[1]);
 		free(node);
+		avl_node_count--;
 	}
 }
 
@@ -228,10 +409,12 @@ static bool insert_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm)
 		int      cmp  = cmp_tracker(sm, node->sm);
 
 		if (cmp == 0) {
-			node->sm = sm;
+			if (node->sm != sm)
+				own_node(p)->sm = sm;
 			return false;
 		}
 
+		node = own_node(p);
 		if (!insert_sm(avl, &node->lr[side(cmp)], sm))
 			return false;
 
@@ -252,7 +435,7 @@ static bool remove_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm,
 	if (p == NULL || *p == NULL) {
 		return false;
 	} else {
-		AvlNode *node = *p;
+		AvlNode *node = own_node(p);
 		int      cmp  = cmp_tracker(sm, node->sm);
 
 		if (cmp == 0) {
@@ -312,7 +495,7 @@ static bool remove_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm,
  */
 static bool removeExtremum(AvlNode **p, int side, AvlNode **ret)
 {
-	AvlNode *node = *p;
+	AvlNode *node = own_node(p);
 
 	if (node->lr[side] == NULL) {
 		*ret = node;
@@ -354,8 +537,8 @@ static int sway(AvlNode **p, int sway)
  */
 static void balance(AvlNode **p, int side)
 {
-	AvlNode  *node  = *p,
-	         *child = node->lr[side];
+	AvlNode  *node  = own_node(p),
+	         *child = own_node(&node->lr[side]);
 	int opposite    = 1 - side;
 	int bal         = bal(side);
 
@@ -370,7 +553,7 @@ static void balance(AvlNode **p, int side)
 
 	} else {
 		/* Left-right (side == 0) or right-left (side == 1) */
-		AvlNode *grandchild = child->lr[opposite];
+		AvlNode *grandchild = own_node(&child->lr[opposite]);
 
 		node->lr[side]           = grandchild->lr[opposite];
 		child->lr[opposite]      = grandchild->lr[side];
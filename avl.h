@@ -46,6 +46,18 @@ void free_stree(struct stree **avl);
 struct sm_state *avl_lookup(const struct stree *avl, const struct sm_state *sm);
 	/* O(log n). Lookup a sm.  Return NULL if the sm is not present. */
 
+struct sm_state *avl_lower_bound(const struct stree *avl, int owner, const char *name);
+	/*
+	 * O(log n). Return the first sm for owner with a name which is >= name,
+	 * or the first sm of the next owner.  NULL if there isn't one.
+	 */
+
+struct sm_state *avl_next(const struct stree *avl, const struct sm_state *sm);
+	/*
+	 * O(log n). Return the first sm after "sm".  "sm" doesn't have to be
+	 * in the tree.
+	 */
+
 #define avl_member(avl, sm) (!!avl_lookup_node(avl, sm))
 	/* O(log n). See if a sm is present. */
 
@@ -59,6 +71,18 @@ bool avl_insert(struct stree **avl, const struct sm_state *sm);
 	 * Return false if the insertion replaced an existing sm.
 	 */
 
+struct stree *avl_from_sorted(struct sm_state **sms, int nr);
+	/*
+	 * O(n). Build a balanced stree from an array which is sorted by
+	 * cmp_tracker() and has no duplicates.  Returns NULL if nr is zero.
+	 */
+
+void avl_insert_sorted(struct stree **avl, struct sm_state **sms, int nr);
+	/*
+	 * Insert a sorted array of sms, replacing the ones which are already
+	 * present.  It's O(nr log n) if nr is small and O(n + nr) otherwise.
+	 */
+
 bool avl_remove(struct stree **avl, const struct sm_state *sm);
 	/*
 	 * O(log n). Remove an sm (if present).
@@ -131,6 +155,7 @@ struct AvlNode {
 
 	AvlNode    *lr[2];
 	int         balance; /* -1, 0, or 1 */
+	int         references;
 };
 
 AvlNode *avl_lookup_node(const struct stree *avl, const struct sm_state *sm);
@@ -136,10 +136,10 @@ int rl_is_larger_or_equal(struct range_list *rl, sval_t sval)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (sval_cmp(tmp->max, sval) >= 0)
 			return 1;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
@@ -147,11 +147,11 @@ int rl_range_has_min_value(struct range_list *rl, sval_t sval)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (!sval_cmp(tmp->min, sval)) {
 			return 1;
 		}
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
@@ -32,8 +32,6 @@ static void match_condition(struct expression *expr)
 	struct symbol *type;
 	char *str;
 
-	if (expr->type != EXPR_DEREF)
-		return;
 	type = get_type(expr);
 	if (!type || type->type != SYM_ARRAY)
 		return;
@@ -48,5 +46,5 @@ static void match_condition(struct expression *expr)
 void check_array_condition(int id)
 {
 	my_id = id;
-	add_hook(&match_condition, CONDITION_HOOK);
+	add_filtered_hook(&match_condition, CONDITION_HOOK, EXPR_DEREF);
 }
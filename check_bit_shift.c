@@ -55,8 +55,6 @@ static void match_assign(struct expression *expr)
 {
 	const char *name;
 
-	if (expr->op != SPECIAL_OR_ASSIGN)
-		return;
 	if (positions_eq(expr->pos, expr->right->pos))
 		return;
 	name = get_shifter(expr->right);
@@ -73,8 +71,6 @@ static void match_binop(struct expression *expr)
 
 	if (positions_eq(expr->pos, expr->right->pos))
 		return;
-	if (expr->op != '&')
-		return;
 	name = get_shifter(expr->right);
 	if (!name)
 		return;
@@ -119,8 +115,6 @@ static void match_binop_info(struct expression *expr)
 
 	if (positions_eq(expr->pos, expr->right->pos))
 		return;
-	if (expr->op != SPECIAL_LEFTSHIFT)
-		return;
 	if (expr->right->type != EXPR_VALUE)
 		return;
 	name = pos_ident(expr->right->pos);
@@ -156,11 +150,11 @@ void check_bit_shift(int id)
 	shifters = create_function_hashtable(5000);
 	register_shifters();
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
-	add_hook(&match_binop, BINOP_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, SPECIAL_OR_ASSIGN);
+	add_filtered_hook(&match_binop, BINOP_HOOK, '&');
 
 	if (option_info) {
-		add_hook(&match_binop_info, BINOP_HOOK);
+		add_filtered_hook(&match_binop_info, BINOP_HOOK, SPECIAL_LEFTSHIFT);
 		if (option_project == PROJ_KERNEL) {
 			add_function_hook("set_bit", &match_call, INT_PTR(0));
 			add_function_hook("test_bit", &match_call, INT_PTR(0));
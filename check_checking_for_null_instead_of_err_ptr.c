@@ -89,12 +89,12 @@ static void match_condition2(struct expression *expr)
 	if (!get_implied_rl(expr, &rl))
 		return;
 
-	FOR_EACH_PTR(rl, drange) {
+	FOR_EACH_RANGE(rl, drange) {
 		if (sval_cmp(drange->min, drange->max) != 0)
 			continue;
 		if (drange->min.value >= -4095 && drange->min.value < 0)
 			goto warn;
-	} END_FOR_EACH_PTR(drange);
+	} END_FOR_EACH_RANGE(drange);
 
 	return;
 
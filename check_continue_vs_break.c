@@ -73,9 +73,6 @@ static int loop_is_macro(void)
 
 static void match_stmt(struct statement *stmt)
 {
-	if (stmt->type != STMT_ITERATOR)
-		return;
-
 	if (is_do_while_zero(stmt)) {
 		push_statement(&iterator_stack, stmt);
 	} else
@@ -84,9 +81,6 @@ static void match_stmt(struct statement *stmt)
 
 static void match_stmt_after(struct statement *stmt)
 {
-	if (stmt->type != STMT_ITERATOR)
-		return;
-
 	pop_statement(&iterator_stack);
 }
 
@@ -102,9 +96,6 @@ static void match_inline_end(struct expression *expr)
 
 static void match_continue(struct statement *stmt)
 {
-	if (stmt->type != STMT_GOTO)
-		return;
-
 	if (!stmt->goto_label || stmt->goto_label->type != SYM_NODE)
 		return;
 	if (strcmp(stmt->goto_label->ident->name, "continue") != 0)
@@ -119,10 +110,10 @@ static void match_continue(struct statement *stmt)
 void check_continue_vs_break(int id)
 {
 	my_id = id;
-	add_hook(&match_stmt, STMT_HOOK);
-	add_hook(&match_stmt_after, STMT_HOOK_AFTER);
+	add_filtered_hook(&match_stmt, STMT_HOOK, STMT_ITERATOR);
+	add_filtered_hook(&match_stmt_after, STMT_HOOK_AFTER, STMT_ITERATOR);
 	add_hook(&match_inline_start, INLINE_FN_START);
 	add_hook(&match_inline_end, INLINE_FN_END);
 
-	add_hook(&match_continue, STMT_HOOK);
+	add_filtered_hook(&match_continue, STMT_HOOK, STMT_GOTO);
 }
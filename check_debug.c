@@ -24,7 +24,7 @@
 void show_sname_alloc(void);
 void show_data_range_alloc(void);
 void show_ptrlist_alloc(void);
-void show_rl_ptrlist_alloc(void);
+void show_range_list_alloc(void);
 void show_sm_state_alloc(void);
 
 int local_debug;
@@ -796,7 +796,7 @@ static void match_mem(const char *fn, struct expression *expr, void *info)
 {
 	show_sname_alloc();
 	show_data_range_alloc();
-	show_rl_ptrlist_alloc();
+	show_range_list_alloc();
 	show_ptrlist_alloc();
 	sm_msg("%lu pools", get_pool_count());
 	sm_msg("%d strees", unfree_stree);
@@ -804,6 +804,11 @@ static void match_mem(const char *fn, struct expression *expr, void *info)
 	show_sm_state_alloc();
 }
 
+static void match_implied_pools(const char *fn, struct expression *expr, void *info)
+{
+	show_implied_pool_stats();
+}
+
 static void match_exit(const char *fn, struct expression *expr, void *info)
 {
 	exit(0);
@@ -893,6 +898,7 @@ void check_debug(int id)
 	add_function_hook("__smatch_expr", &match_expr, NULL);
 	add_function_hook("__smatch_state_count", &match_state_count, NULL);
 	add_function_hook("__smatch_mem", &match_mem, NULL);
+	add_function_hook("__smatch_implied_pools", &match_implied_pools, NULL);
 	add_function_hook("__smatch_exit", &match_exit, NULL);
 	add_function_hook("__smatch_container", &match_container, NULL);
 	add_function_hook("__smatch_timer_start", &match_timer_start, NULL);
@@ -380,8 +380,6 @@ static void match_condition(struct expression *expr)
 {
 	struct statement *stmt;
 
-	if (expr->type != EXPR_COMPARE)
-		return;
 	if (expr->op != '<' && expr->op != SPECIAL_UNSIGNED_LT)
 		return;
 
@@ -402,7 +400,7 @@ void check_index_overflow_loop_marker(int id)
 {
 	loop_id = id;
 
-	add_hook(&match_condition, CONDITION_HOOK);
+	add_filtered_hook(&match_condition, CONDITION_HOOK, EXPR_COMPARE);
 	add_modification_hook(loop_id, &set_undefined);
 }
 
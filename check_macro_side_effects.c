@@ -96,9 +96,6 @@ static void match_unop(struct expression *raw_expr)
 	struct expression *expr;
 	char *macro, *name;
 
-	if (raw_expr->op != SPECIAL_INCREMENT && raw_expr->op != SPECIAL_DECREMENT)
-		return;
-
 	macro = get_macro_name(raw_expr->pos);
 	if (!macro)
 		return;
@@ -164,7 +161,8 @@ void check_macro_side_effects(int id)
 		return;
 
 	set_dynamic_states(my_id);
-	add_hook(&match_unop, OP_HOOK);
+	add_filtered_hook(&match_unop, OP_HOOK, SPECIAL_INCREMENT);
+	add_filtered_hook(&match_unop, OP_HOOK, SPECIAL_DECREMENT);
 	add_hook(&match_stmt, STMT_HOOK);
 	register_ignored_macros();
 }
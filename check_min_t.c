@@ -25,9 +25,6 @@ static void match_assign(struct expression *expr)
 	sval_t max_left, max_right;
 	char *name;
 
-	if (expr->op != '=')
-		return;
-
 	macro = get_macro_name(expr->pos);
 	if (!macro)
 		return;
@@ -52,5 +49,5 @@ void check_min_t(int id)
 	my_id = id;
 	if (option_project != PROJ_KERNEL)
 		return;
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 }
@@ -81,8 +81,6 @@ static void match_assign(struct expression *expr)
 {
 	struct expression *left;
 
-	if (expr->op != '=')
-		return;
 	if (!get_switch_expr())
 		return;
 	left = strip_expr(expr->left);
@@ -136,9 +134,6 @@ static void match_stmt(struct statement *stmt)
 
 static void match_switch(struct statement *stmt)
 {
-	if (stmt->type != STMT_SWITCH)
-		return;
-
 	in_switch_stmt++;
 }
 
@@ -178,10 +173,6 @@ static void match_fallthrough(struct statement *stmt)
 
 static void match_switch_end(struct statement *stmt)
 {
-
-	if (stmt->type != STMT_SWITCH)
-		return;
-
 	in_switch_stmt--;
 
 	if (!in_switch_stmt)
@@ -199,10 +190,10 @@ void check_missing_break(int id)
 	add_unmatched_state_hook(my_id, &unmatched_state);
 	add_merge_hook(my_id, &merge_hook);
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 	add_hook(&match_symbol, SYM_HOOK);
 	add_hook(&match_stmt, STMT_HOOK);
 	add_hook(&match_fallthrough, STMT_HOOK);
-	add_hook(&match_switch, STMT_HOOK);
-	add_hook(&match_switch_end, STMT_HOOK_AFTER);
+	add_filtered_hook(&match_switch, STMT_HOOK, STMT_SWITCH);
+	add_filtered_hook(&match_switch_end, STMT_HOOK_AFTER, STMT_SWITCH);
 }
@@ -48,8 +48,6 @@ static bool set_label;
 
 static void match_goto(struct statement *stmt)
 {
-	if (stmt->type != STMT_GOTO)
-		return;
 	set_state(my_id, "goto", NULL, &yup);
 }
 
@@ -57,8 +55,6 @@ static void match_label(struct statement *stmt)
 {
 	sval_t sval;
 
-	if (stmt->type != STMT_LABEL)
-		return;
 	if (get_state(my_id, "cleanup", NULL) == &yup) {
 		/* The second label in a cleanup block is still cleanup. */
 		set_label = true;
@@ -82,8 +78,6 @@ static void match_label(struct statement *stmt)
 
 static void match_label_after(struct statement *stmt)
 {
-	if (stmt->type != STMT_LABEL)
-		return;
 	if (set_label) {
 		set_state(my_id, "cleanup", NULL, &yup);
 		set_label = false;
@@ -196,8 +190,8 @@ void check_missing_error_code(int id)
 
 	my_id = id;
 
-	add_hook(&match_goto, STMT_HOOK);
-	add_hook(&match_label, STMT_HOOK);
-	add_hook(&match_label_after, STMT_HOOK_AFTER);
+	add_filtered_hook(&match_goto, STMT_HOOK, STMT_GOTO);
+	add_filtered_hook(&match_label, STMT_HOOK, STMT_LABEL);
+	add_filtered_hook(&match_label_after, STMT_HOOK_AFTER, STMT_LABEL);
 	add_hook(&match_return, STMT_HOOK);
 }
@@ -35,8 +35,6 @@ static void match_stmt(struct statement *stmt)
 {
 	struct expression *expr;
 
-	if (stmt->type != STMT_EXPRESSION)
-		return;
 	expr = stmt->expression;
 	if (!expr)
 		return;
@@ -67,6 +65,6 @@ static void match_stmt(struct statement *stmt)
 void check_no_effect(int id)
 {
 	my_id = id;
-	add_hook(&match_stmt, STMT_HOOK);
+	add_filtered_hook(&match_stmt, STMT_HOOK, STMT_EXPRESSION);
 	ignored_macros = load_strings_from_file(option_project_str, "ignore_no_effect");
 }
@@ -23,8 +23,6 @@ static void match_if_stmt(struct statement *stmt)
 {
 	if (__inline_fn)
 		return;
-	if (stmt->type != STMT_IF)
-		return;
 	if (stmt->if_true->type == STMT_COMPOUND)
 		return;
 	if (get_macro_name(stmt->pos))
@@ -38,8 +36,6 @@ static void match_for_stmt(struct statement *stmt)
 {
 	if (__inline_fn)
 		return;
-	if (stmt->type != STMT_ITERATOR)
-		return;
 	if (stmt->iterator_statement->type == STMT_COMPOUND)
 		return;
 	if (get_macro_name(stmt->pos))
@@ -53,6 +49,6 @@ void check_no_if_block(int id)
 {
 	my_id = id;
 
-	add_hook(&match_if_stmt, STMT_HOOK);
-	add_hook(&match_for_stmt, STMT_HOOK);
+	add_filtered_hook(&match_if_stmt, STMT_HOOK, STMT_IF);
+	add_filtered_hook(&match_for_stmt, STMT_HOOK, STMT_ITERATOR);
 }
@@ -142,8 +142,6 @@ static void match_condition(struct expression *expr)
 {
 	sval_t sval;
 
-	if (expr->type != EXPR_BINOP)
-		return;
 	if (expr->op == '|') {
 		if (get_value(expr->left, &sval) || get_value(expr->right, &sval))
 			sm_warning("suspicious bitop condition");
@@ -167,8 +165,6 @@ static void match_binop(struct expression *expr)
 {
 	sval_t left, right, sval;
 
-	if (expr->op != '&')
-		return;
 	if (!get_value(expr, &sval) || sval.value != 0)
 		return;
 	if (get_macro_name(expr->pos))
@@ -186,7 +182,7 @@ void check_or_vs_and(int id)
 	load_strings("unconstant_macros", unconstant_macros);
 
 	add_hook(&match_logic, LOGIC_HOOK);
-	add_hook(&match_condition, CONDITION_HOOK);
+	add_filtered_hook(&match_condition, CONDITION_HOOK, EXPR_BINOP);
 	if (option_spammy)
-		add_hook(&match_binop, BINOP_HOOK);
+		add_filtered_hook(&match_binop, BINOP_HOOK, '&');
 }
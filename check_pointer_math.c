@@ -70,8 +70,6 @@ static void match_binop(struct expression *expr)
 	char *name;
 	int size;
 
-	if (expr->op != '+')
-		return;
 	type = get_pointer_type(expr->left);
 	if (!type)
 		return;
@@ -98,9 +96,6 @@ static void match_binop(struct expression *expr)
 
 static void match_assign(struct expression *expr)
 {
-	if (expr->op != '=')
-		return;
-
 	if (!is_size_in_bytes(expr->right))
 		return;
 	set_state_expr(my_id, expr->left, &size_in_bytes);
@@ -111,9 +106,6 @@ static void check_assign(struct expression *expr)
 	struct symbol *type;
 	char *name;
 
-	if (expr->op != SPECIAL_ADD_ASSIGN && expr->op != SPECIAL_SUB_ASSIGN)
-		return;
-
 	type = get_pointer_type(expr->left);
 	if (!type)
 		return;
@@ -130,8 +122,9 @@ static void check_assign(struct expression *expr)
 void check_pointer_math(int id)
 {
 	my_id = id;
-	add_hook(&match_binop, BINOP_HOOK);
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
-	add_hook(&check_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_binop, BINOP_HOOK, '+');
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
+	add_filtered_hook(&check_assign, ASSIGNMENT_HOOK, SPECIAL_ADD_ASSIGN);
+	add_filtered_hook(&check_assign, ASSIGNMENT_HOOK, SPECIAL_SUB_ASSIGN);
 	add_modification_hook(my_id, &set_undefined);
 }
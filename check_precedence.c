@@ -102,16 +102,12 @@ static void match_condition(struct expression *expr)
 
 static void match_binop(struct expression *expr)
 {
-	if (expr->op != '&')
-		return;
 	if (expr->left->op == '!')
 		sm_warning("add some parenthesis here?");
 }
 
 static void match_mask(struct expression *expr)
 {
-	if (expr->op != '&')
-		return;
 	if (expr->right->type != EXPR_BINOP)
 		return;
 	if (expr->right->op != SPECIAL_RIGHTSHIFT)
@@ -122,8 +118,6 @@ static void match_mask(struct expression *expr)
 
 static void match_mask_compare(struct expression *expr)
 {
-	if (expr->op != '&')
-		return;
 	if (expr->right->type != EXPR_COMPARE)
 		return;
 
@@ -132,8 +126,6 @@ static void match_mask_compare(struct expression *expr)
 
 static void match_subtract_shift(struct expression *expr)
 {
-	if (expr->op != SPECIAL_LEFTSHIFT)
-		return;
 	if (expr->right->type != EXPR_BINOP)
 		return;
 	if (expr->right->op != '-')
@@ -146,8 +138,8 @@ void check_precedence(int id)
 	my_id = id;
 
 	add_hook(&match_condition, CONDITION_HOOK);
-	add_hook(&match_binop, BINOP_HOOK);
-	add_hook(&match_mask, BINOP_HOOK);
-	add_hook(&match_mask_compare, BINOP_HOOK);
-	add_hook(&match_subtract_shift, BINOP_HOOK);
+	add_filtered_hook(&match_binop, BINOP_HOOK, '&');
+	add_filtered_hook(&match_mask, BINOP_HOOK, '&');
+	add_filtered_hook(&match_mask_compare, BINOP_HOOK, '&');
+	add_filtered_hook(&match_subtract_shift, BINOP_HOOK, SPECIAL_LEFTSHIFT);
 }
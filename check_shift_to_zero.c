@@ -24,9 +24,6 @@ static void match_binop(struct expression *expr)
 	struct symbol *type;
 	sval_t bits;
 
-	if (expr->op != SPECIAL_RIGHTSHIFT)
-		return;
-
 	if (!get_implied_value(expr->right, &bits))
 		return;
 
@@ -46,9 +43,6 @@ static void match_binop2(struct expression *expr)
 	struct expression *tmp;
 	sval_t mask, shift;
 
-	if (expr->op != SPECIAL_RIGHTSHIFT)
-		return;
-
 	left = strip_expr(expr->left);
 	tmp = get_assigned_expr(left);
 	if (tmp)
@@ -72,9 +66,6 @@ static void match_assign(struct expression *expr)
 	struct symbol *type;
 	sval_t bits;
 
-	if (expr->op != SPECIAL_SHR_ASSIGN)
-		return;
-
 	if (!get_implied_value(expr->right, &bits))
 		return;
 	type = get_type(expr->left);
@@ -89,9 +80,9 @@ void check_shift_to_zero(int id)
 {
 	my_id = id;
 
-	add_hook(&match_binop, BINOP_HOOK);
-	add_hook(&match_binop2, BINOP_HOOK);
+	add_filtered_hook(&match_binop, BINOP_HOOK, SPECIAL_RIGHTSHIFT);
+	add_filtered_hook(&match_binop2, BINOP_HOOK, SPECIAL_RIGHTSHIFT);
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, SPECIAL_SHR_ASSIGN);
 
 }
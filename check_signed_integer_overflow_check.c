@@ -69,9 +69,6 @@ static void match_binop(struct expression *expr)
 	sval_t left_val, right_min;
 	char *str;
 
-	if (expr->op != '-')
-		return;
-
 	if (!get_value(expr->left, &left_val))
 		return;
 
@@ -106,6 +103,6 @@ void check_signed_integer_overflow_check(int id)
 	}
 
 	add_hook(&match_condition, CONDITION_HOOK);
-	add_hook(&match_binop, BINOP_HOOK);
+	add_filtered_hook(&match_binop, BINOP_HOOK, '-');
 }
 
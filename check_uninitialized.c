@@ -221,6 +221,7 @@ static int param_used_callback(void *found, int argc, char **argv, char **azColN
 
 static int member_is_used(struct expression *call, int param, char *printed_name)
 {
+	char sql[256];
 	int found;
 
 	/* for function pointers assume everything is used */
@@ -228,9 +229,11 @@ static int member_is_used(struct expression *call, int param, char *printed_name
 		return 0;
 
 	found = 0;
-	run_sql(&param_used_callback, &found,
-		"select * from return_implies where %s and type = %d and parameter = %d and key = '%s';",
-		get_static_filter(call->fn->symbol), PARAM_USED, param, printed_name);
+	snprintf(sql, sizeof(sql),
+		 "select * from return_implies where %s and type = ? and parameter = ? and key = ?;",
+		 get_static_filter_bind(call->fn->symbol));
+	run_sql_bind(&param_used_callback, &found, sql, "Fdds",
+		     call->fn->symbol, PARAM_USED, param, printed_name);
 	return found;
 }
 
@@ -60,8 +60,8 @@ static struct assignment_list *assignment_list;
 static struct expression *skip_this;
 static int assign_id;
 
-static DEFINE_HASHTABLE_INSERT(insert_func, char, int);
-static DEFINE_HASHTABLE_SEARCH(search_func, char, int);
+static DEFINE_HASHTABLE_INSERT(insert_func, struct ident, int);
+static DEFINE_HASHTABLE_SEARCH(search_func, struct ident, int);
 static struct hashtable *ignored_funcs;
 
 static const char *kernel_ignored[] = {
@@ -84,16 +84,12 @@ static char *get_fn_name(struct expression *expr)
 
 static int ignored_function(struct expression *expr)
 {
-	char *func;
-	int ret = 0;
-
-	func = get_fn_name(expr);
-	if (!func)
+	if (expr->type != EXPR_CALL || expr->fn->type != EXPR_SYMBOL ||
+	    !expr->fn->symbol_name)
 		return 0;
-	if (search_func(ignored_funcs, func))
-		ret = 1;
-	free_string(func);
-	return ret;
+	if (search_func(ignored_funcs, expr->fn->symbol_name))
+		return 1;
+	return 0;
 }
 
 static void match_assign_call(struct expression *expr)
@@ -133,8 +129,6 @@ static void match_assign(struct expression *expr)
 {
 	struct expression *left;
 
-	if (expr->op != '=')
-		return;
 	left = strip_expr(expr->left);
 	if (!left || left->type != EXPR_SYMBOL)
 		return;
@@ -205,15 +199,15 @@ void check_unused_ret(int id)
 	if (!option_two_passes)
 		return;
 	add_hook(&match_assign_call, CALL_ASSIGNMENT_HOOK);
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 	add_hook(&match_symbol, SYM_HOOK);
 	add_hook(&match_end_func, END_FUNC_HOOK);
 	add_hook(&match_after_func, AFTER_FUNC_HOOK);
-	ignored_funcs = create_function_hashtable(100);
+	ignored_funcs = create_ident_hashtable(100);
 	if (option_project == PROJ_KERNEL) {
 		int i;
 
 		for (i = 0; i < ARRAY_SIZE(kernel_ignored); i++)
-			insert_func(ignored_funcs, (char *)kernel_ignored[i], (int *)1);
+			insert_func(ignored_funcs, built_in_ident(kernel_ignored[i]), (int *)1);
 	}
 }
@@ -79,7 +79,7 @@ static int is_non_zero_int(struct range_list *rl)
 	struct data_range *tmp;
 	int cnt = -1;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		cnt++;
 
 		if (cnt == 0) {
@@ -92,7 +92,7 @@ static int is_non_zero_int(struct range_list *rl)
 				return 1;
 		}
 		return 0;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
@@ -112,10 +112,10 @@ static int has_distinct_zero(struct range_list *rl)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (tmp->min.value == 0 || tmp->max.value == 0)
 			return 1;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
@@ -138,6 +138,7 @@ static void do_warn(const char *type, struct position pos, const char * fmt, va_
 		return;
 
 	vsprintf(buffer, fmt, args);	
+	snapshot_diagnostic(type, pos, buffer);
 
 	fflush(stdout);
 	fprintf(stderr, "%s:%d:%d: %s%s%s\n",
@@ -158,10 +159,14 @@ void info(struct position pos, const char * fmt, ...)
 	va_end(args);
 }
 
+unsigned int nr_diagnostics;
+
 static void do_error(struct position pos, const char * fmt, va_list args)
 {
 	static int errors = 0;
 
+	nr_diagnostics++;
+
 	parse_error = 1;
         die_if_error = 1;
 	show_info = 1;
@@ -187,6 +192,8 @@ void warning(struct position pos, const char * fmt, ...)
 {
 	va_list args;
 
+	nr_diagnostics++;
+
 	if (Wsparse_error) {
 		va_start(args, fmt);
 		do_error(pos, fmt, args);
@@ -299,12 +306,22 @@ static void create_builtin_stream(void)
 	add_pre_buffer("#define __builtin_va_arg_pack()\n");
 }
 
+static struct symbol_list *sparse_parse(struct token *token)
+{
+	// Parse the resulting C code
+	while (!eof_token(token))
+		token = external_declaration(token, &translation_unit_used_list, NULL);
+	return translation_unit_used_list;
+}
+
 static struct symbol_list *sparse_tokenstream(struct token *token)
 {
 	int builtin = token && !token->pos.stream;
 
 	// Preprocess the stream
 	token = preprocess(token);
+	if (!builtin)
+		finish_snapshot(token);
 
 	if (dump_macro_defs || dump_macros_only) {
 		if (!builtin)
@@ -334,10 +351,7 @@ static struct symbol_list *sparse_tokenstream(struct token *token)
 		return NULL;
 	}
 
-	// Parse the resulting C code
-	while (!eof_token(token))
-		token = external_declaration(token, &translation_unit_used_list, NULL);
-	return translation_unit_used_list;
+	return sparse_parse(token);
 }
 
 static struct symbol_list *sparse_file(const char *filename)
@@ -345,6 +359,11 @@ static struct symbol_list *sparse_file(const char *filename)
 	int fd;
 	struct token *token;
 
+	if (load_snapshot_file) {
+		base_filename = filename;
+		return sparse_parse(load_snapshot(filename));
+	}
+
 	if (strcmp(filename, "-") == 0) {
 		fd = 0;
 	} else {
@@ -353,10 +372,13 @@ static struct symbol_list *sparse_file(const char *filename)
 			die("No such file: %s", filename);
 	}
 	base_filename = filename;
+	if (save_snapshot_file)
+		start_snapshot();
 
 	// Tokenize the input stream
 	token = tokenize(NULL, filename, fd, NULL, includepath);
 	store_all_tokens(token);
+	snapshot_raw_tokens(token);
 
 	close(fd);
 
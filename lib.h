@@ -105,6 +105,7 @@ extern void info(struct position, const char *, ...) FORMAT_ATTR(2);
 extern void warning(struct position, const char *, ...) FORMAT_ATTR(2);
 extern void sparse_error(struct position, const char *, ...) FORMAT_ATTR(2);
 extern void expression_error(struct expression *, const char *, ...) FORMAT_ATTR(2);
+extern unsigned int nr_diagnostics;
 
 #define	ERROR_CURR_PHASE	(1 << 0)
 #define	ERROR_PREV_PHASE	(1 << 1)
@@ -135,6 +136,8 @@ extern void predefine_nostd(const char *name);
 extern void predefined_macros(void);
 
 extern void dump_macro_definitions(void);
+extern void for_each_object_macro(void (*fn)(struct symbol *sym));
+extern void define_object_macro(struct position pos, struct ident *name, struct token *expansion);
 extern struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list **files);
 extern struct symbol_list *__sparse(char *filename);
 extern struct symbol_list *sparse_keep_tokens(char *filename);
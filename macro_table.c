@@ -66,6 +66,7 @@ void store_macro_pos(struct token *token)
 	insert_macro_string(&list, token->ident->name);
 
 	do_insert_macro(macro_table, &token->pos, list);
+	snapshot_macro_pos(token);
 }
 
 char *get_macro_name(struct position pos)
@@ -2511,3 +2511,24 @@ void dump_macro_definitions(void)
 			dump_macro(sym);
 	} END_FOR_EACH_PTR(name);
 }
+
+///
+// call @fn for each object-like macro which is still defined
+void for_each_object_macro(void (*fn)(struct symbol *sym))
+{
+	struct ident *name;
+
+	FOR_EACH_PTR(macros, name) {
+		struct symbol *sym = lookup_macro(name);
+		if (sym && !sym->arglist)
+			fn(sym);
+	} END_FOR_EACH_PTR(name);
+}
+
+///
+// define an object-like macro without going through the preprocessor
+// @expansion: the tokens of the definition, ending with &eof_token_entry
+void define_object_macro(struct position pos, struct ident *name, struct token *expansion)
+{
+	do_define(pos, NULL, name, NULL, expansion, SYM_ATTR_NORMAL);
+}
@@ -30,7 +30,6 @@
 
 __DECLARE_ALLOCATOR(struct ptr_list, ptrlist);
 __ALLOCATOR(struct ptr_list, "ptr list", ptrlist);
-__ALLOCATOR(struct ptr_list, "rl ptr list", rl_ptrlist);
 
 ///
 // get the size of a ptrlist
@@ -250,7 +249,6 @@ void split_ptr_list_head(struct ptr_list *head)
 	memset(head->list + old, 0xf0, nr * sizeof(void *));
 }
 
-int rl_ptrlist_hack;
 ///
 // add an entry to a ptrlist
 // @listp: a pointer to the list
@@ -269,10 +267,7 @@ void **__add_ptr_list(struct ptr_list **listp, void *ptr)
 	if (!list || (nr = (last = list->prev)->nr) >= LIST_NODE_NR) {
 		struct ptr_list *newlist;
 
-		if (rl_ptrlist_hack)
-			newlist = __alloc_rl_ptrlist(0);
-		else
-			newlist = __alloc_ptrlist(0);
+		newlist = __alloc_ptrlist(0);
 		if (!list) {
 			newlist->next = newlist;
 			newlist->prev = newlist;
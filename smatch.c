@@ -40,9 +40,14 @@ int option_no_db = 0;
 int option_enable = 0;
 int option_disable = 0;
 int option_file_output;
+int option_info_binary;
+int option_info_db;
 int option_time;
 int option_time_stmt;
 int option_mem;
+int option_jobs = 1;
+static char *option_server;
+static char *option_client;
 char *option_datadir_str;
 int option_fatal_checks;
 int option_succeed;
@@ -50,6 +55,7 @@ int option_succeed;
 FILE *sm_outfd;
 FILE *sql_outfd;
 FILE *caller_info_fd;
+FILE *sql_bin_fd;
 
 int sm_nr_errors;
 int sm_nr_checks;
@@ -148,6 +154,17 @@ static void help(void)
 	printf("--assume-loops:  assume loops always go through at least once.\n");
 	printf("--two-passes:  use a two pass system for each function.\n");
 	printf("--file-output:  instead of printing stdout, print to \"file.c.smatch_out\".\n");
+	printf("--info-binary:  with --info and --file-output, write the SQL to \"file.c.smatch.sqlb\".\n");
+	printf("--info-db:  with --info and --file-output, write the SQL to the \"file.c.smatch.db\" database.\n");
+	printf("--mem:  print the peak memory and how much each allocator used.\n");
+	printf("--profile:  print how much time and how many states each check used.\n");
+	printf("--profile=json:  print the --profile report as JSON.\n");
+	printf("--jobs=<n>:  split the functions of each file between n processes.\n");
+	printf("--token-cache=<dir>:  save the tokens for the headers in <dir> and reuse them.\n");
+	printf("--save-snapshot=<file>:  save the preprocessed file to <file>.\n");
+	printf("--snapshot=<file>:  load the preprocessed file from --save-snapshot.\n");
+	printf("--server=<socket>:  do the setup once and check the files sent by --client.\n");
+	printf("--client=<socket>:  have the --server check the files.\n");
 	printf("--fatal-checks: check output is treated as an error.\n");
 	printf("--help:  print this helpful message.\n");
 	exit(1);
@@ -211,11 +228,48 @@ void parse_args(int *argcp, char ***argvp)
 			(*argvp)[1] = (*argvp)[0];
 			found = 1;
 		}
+		if (!found && !strncmp((*argvp)[1], "--jobs=", 7)) {
+			option_jobs = atoi((*argvp)[1] + 7);
+			if (option_jobs < 1 || option_jobs > MAX_JOBS)
+				sm_fatal("--jobs has to be between 1 and %d", MAX_JOBS);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--token-cache=", 14)) {
+			token_cache_dir = (*argvp)[1] + 14;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--server=", 9)) {
+			option_server = (*argvp)[1] + 9;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--client=", 9)) {
+			option_client = (*argvp)[1] + 9;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--save-snapshot=", 16)) {
+			save_snapshot_file = (*argvp)[1] + 16;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--snapshot=", 11)) {
+			load_snapshot_file = (*argvp)[1] + 11;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
 		if (!found && !strncmp((*argvp)[1], "--debug=", 8)) {
 			option_debug_check = (*argvp)[1] + 8;
 			(*argvp)[1] = (*argvp)[0];
 			found = 1;
 		}
+		if (!found && !strcmp((*argvp)[1], "--profile=json")) {
+			option_profile = PROFILE_JSON;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
 		if (!found && strncmp((*argvp)[1], "--trace=", 8) == 0) {
 			trace_variable = (*argvp)[1] + 8;
 			(*argvp)[1] = (*argvp)[0];
@@ -246,9 +300,12 @@ void parse_args(int *argcp, char ***argvp)
 		OPTION(full_path);
 		OPTION(call_tree);
 		OPTION(file_output);
+		OPTION(info_binary);
+		OPTION(info_db);
 		OPTION(time);
 		OPTION(time_stmt);
 		OPTION(mem);
+		OPTION(profile);
 		OPTION(no_db);
 		OPTION(succeed);
 		OPTION(print_names);
@@ -332,19 +389,78 @@ static char *get_data_dir(char *arg0)
 	return NULL;
 }
 
-int main(int argc, char **argv)
+/*
+ * check_locking() looks for CONFIG_SMP when it is registered so it has to
+ * wait for sparse_initialize().  The --server registers everything else
+ * before it has the command line for a file.
+ */
+static bool needs_command_line(const char *name)
+{
+	return strcmp(name, "check_locking") == 0;
+}
+
+enum {
+	ALL_CHECKS,
+	EARLY_CHECKS,
+	LATE_CHECKS,
+};
+
+static void register_checks(int which)
 {
-	struct string_list *filelist = NULL;
-	int i;
 	reg_func func;
+	bool late;
+	int i;
 
+	for (i = 1; i < ARRAY_SIZE(reg_funcs); i++) {
+		late = needs_command_line(reg_funcs[i].name);
+		if ((which == EARLY_CHECKS && late) ||
+		    (which == LATE_CHECKS && !late))
+			continue;
+		func = reg_funcs[i].func;
+		/* The script IDs start at 1.
+		   0 is used for internal stuff. */
+		if (!option_enable || reg_funcs[i].enabled == 1 ||
+		    (option_disable && reg_funcs[i].enabled != -1) ||
+		    strncmp(reg_funcs[i].name, "register_", 9) == 0) {
+			registering_check = i;
+			func(i);
+		}
+	}
+	registering_check = 0;
+}
+
+int check_files(int argc, char **argv)
+{
+	struct string_list *filelist = NULL;
+
+	sparse_initialize(argc, argv, &filelist);
+	alloc_valid_ptr_rl();
+	register_checks(option_server ? LATE_CHECKS : ALL_CHECKS);
+
+	smatch(filelist);
+	free_string(data_dir);
+
+	if (option_succeed)
+		return 0;
+	if (sm_nr_errors > 0)
+		return 1;
+	if (sm_nr_checks > 0 && option_fatal_checks)
+		return 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
 	sm_outfd = stdout;
 	sql_outfd = stdout;
 	caller_info_fd = stdout;
 
 	parse_args(&argc, &argv);
 
-	if (argc < 2)
+	if (option_client)
+		return smatch_client(option_client, argc, argv);
+
+	if (argc < 2 && !option_server)
 		help();
 
 	/* this gets set back to zero when we parse the first function */
@@ -358,27 +474,16 @@ int main(int argc, char **argv)
 	allocate_tracker_array(num_checks);
 	create_function_hook_hash();
 	open_smatch_db(option_db_file);
-	sparse_initialize(argc, argv, &filelist);
-	alloc_valid_ptr_rl();
 
-	for (i = 1; i < ARRAY_SIZE(reg_funcs); i++) {
-		func = reg_funcs[i].func;
-		/* The script IDs start at 1.
-		   0 is used for internal stuff. */
-		if (!option_enable || reg_funcs[i].enabled == 1 ||
-		    (option_disable && reg_funcs[i].enabled != -1) ||
-		    strncmp(reg_funcs[i].name, "register_", 9) == 0)
-			func(i);
+	if (option_server) {
+		/*
+		 * The hooks are looked up by ident so the idents from
+		 * ident-list.h have to be hashed before the checks ask for them.
+		 */
+		init_symbols();
+		register_checks(EARLY_CHECKS);
+		smatch_server(option_server);
 	}
 
-	smatch(filelist);
-	free_string(data_dir);
-
-	if (option_succeed)
-		return 0;
-	if (sm_nr_errors > 0)
-		return 1;
-	if (sm_nr_checks > 0 && option_fatal_checks)
-		return 1;
-	return 0;
+	return check_files(argc, argv);
 }
@@ -163,6 +163,7 @@ DECLARE_PTR_LIST(sym_fn_list, sym_func);
 DECLARE_PTR_LIST(name_sym_fn_list, name_sym_hook);
 
 void add_hook(void *func, enum hook_type type);
+void add_filtered_hook(void *func, enum hook_type type, int key);
 typedef struct smatch_state *(merge_func_t)(struct smatch_state *s1, struct smatch_state *s2);
 typedef struct smatch_state *(unmatched_func_t)(struct sm_state *state);
 void add_merge_hook(int client_id, merge_func_t *func);
@@ -225,6 +226,8 @@ struct modification_data {
 
 typedef void (modification_hook)(struct sm_state *sm, struct expression *mod_expr);
 bool is_sub_member(const char *name, struct symbol *sym, struct sm_state *sm);
+struct sm_state *next_sub_member(int owner, const char *name, struct symbol *sym,
+				 struct sm_state *prev);
 void add_modification_hook(int owner, modification_hook *call_back);
 void add_modification_hook_late(int owner, modification_hook *call_back);
 struct smatch_state *get_modification_state(struct expression *expr);
@@ -261,6 +264,7 @@ void set_path_impossible(void);
 extern FILE *sm_outfd;
 extern FILE *sql_outfd;
 extern FILE *caller_info_fd;
+extern FILE *sql_bin_fd;
 extern int sm_nr_checks;
 extern int sm_nr_errors;
 
@@ -625,8 +629,19 @@ extern int option_assume_loops;
 extern int option_two_passes;
 extern int option_no_db;
 extern int option_file_output;
+extern int option_info_binary;
+extern int option_info_db;
 extern int option_time;
 extern int option_time_stmt;
+#define MAX_JOBS 64
+extern int option_jobs;
+extern FILE *worker_data_fd;
+typedef void (worker_data_fn)(FILE *fp);
+void save_worker_data(worker_data_fn *load);
+void save_worker_bytes(const void *buf, size_t len);
+void load_worker_bytes(FILE *fp, void *buf, size_t len);
+void save_worker_string(const char *str);
+char *load_worker_string(FILE *fp);
 extern struct expression_list *big_expression_stack;
 extern struct expression_list *big_condition_stack;
 extern struct statement_list *big_statement_stack;
@@ -643,7 +658,20 @@ extern struct statement *__cur_stmt;
 extern struct statement *__next_stmt;
 void init_fake_env(void);
 void end_fake_env(void);
-int time_parsing_function(void);
+/*
+ * The limits on how long we spend on a function are counted in work units
+ * instead of seconds so the results don't depend on how fast or busy the
+ * machine is.  A unit is a statement, an sm_state or a step in the
+ * implications code.  WORK_PER_SECOND is roughly how many we do in a
+ * second so that the limits can still be written as seconds.
+ */
+#define WORK_PER_SECOND 100000
+extern unsigned long long work_units;
+static inline void add_work(int units)
+{
+	work_units += units;
+}
+int work_parsing_function(void);
 bool taking_too_long(void);
 struct statement *get_last_stmt(void);
 int is_last_stmt(struct statement *cur_stmt);
@@ -653,7 +681,7 @@ struct expression *get_faked_expression(void);
 void __fake_struct_member_assignments(struct expression *expr);
 
 /* smatch_project.c */
-int is_no_inline_function(const char *function);
+int is_no_inline_function(struct ident *function);
 
 /* smatch_conditions */
 void __split_whole_condition(struct expression *expr);
@@ -671,6 +699,7 @@ struct stree *__implied_case_stree(struct expression *switch_expr,
 				   struct range_list_stack **remaining_cases,
 				   struct stree **raw_stree);
 void overwrite_states_using_pool(struct sm_state *gate_sm, struct sm_state *pool_sm);
+void show_implied_pool_stats(void);
 int assume(struct expression *expr);
 void end_assume(void);
 int impossible_assumption(struct expression *left, int op, sval_t sval);
@@ -915,6 +944,7 @@ enum info_type {
 extern struct sqlite3 *smatch_db;
 extern struct sqlite3 *mem_db;
 extern struct sqlite3 *cache_db;
+extern struct sqlite3 *info_db;
 
 bool db_incomplete(void);
 void db_ignore_states(int id);
@@ -975,6 +1005,31 @@ do {										\
 #define cache_sql(call_back, data, sql...)					\
 	sql_helper(cache_db, call_back, data, sql)
 
+void sql_exec_bind(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), void *data, const char *sql, const char *types, ...);
+void print_sql_stats(void);
+void sql_insert_binary_text(const char *table, int ignore, int late, const char *fmt, ...);
+void open_info_db(const char *filename);
+void close_info_db(void);
+void open_worker_info_db(int worker);
+void merge_worker_info_db(int worker);
+void start_worker_db(int worker, int nr_workers);
+void save_worker_db(void);
+void forget_sqlb_tables(void);
+void sql_insert_info_db(const char *table, int ignore, const char *fmt, ...);
+
+#define run_sql_bind(call_back, data, sql, types...)				\
+do {										\
+	if (option_no_db)							\
+		break;								\
+	sql_exec_bind(smatch_db, call_back, data, sql, types);			\
+} while (0)
+
+#define mem_sql_bind(call_back, data, sql, types...)				\
+	sql_exec_bind(mem_db, call_back, data, sql, types)
+
+#define cache_sql_bind(call_back, data, sql, types...)				\
+	sql_exec_bind(cache_db, call_back, data, sql, types)
+
 #define sql_insert_helper(table, db, ignore, late, values...)			\
 do {										\
 	struct sqlite3 *_db = db;						\
@@ -1000,6 +1055,14 @@ do {										\
 		}								\
 		break;								\
 	}									\
+	if (option_info && info_db) {						\
+		sql_insert_info_db(#table, ignore, values);			\
+		break;								\
+	}									\
+	if (option_info && sql_bin_fd) {					\
+		sql_insert_binary_text(#table, ignore, late, values);		\
+		break;								\
+	}									\
 	if (option_info) {							\
 		FILE *tmp_fd = sm_outfd;					\
 		sm_outfd = sql_outfd;						\
@@ -1018,6 +1081,7 @@ do {										\
 #define sql_insert_cache(table, values...) sql_insert_helper(table, cache_db, 1, 0, values);
 
 char *get_static_filter(struct symbol *sym);
+const char *get_static_filter_bind(struct symbol *sym);
 
 void sql_insert_return_states(int return_id, const char *return_ranges,
 		int type, int param, const char *key, const char *value);
@@ -1369,10 +1433,33 @@ struct bit_info *rl_to_binfo(struct range_list *rl);
 struct bit_info *get_bit_info(struct expression *expr);
 struct bit_info *get_bit_info_var_sym(const char *name, struct symbol *sym);
 
+/* smatch.c */
+int check_files(int argc, char **argv);
+
+/* smatch_server.c */
+int smatch_client(const char *path, int argc, char **argv);
+void __attribute__((noreturn)) smatch_server(const char *path);
+
 /* smatch_mem_tracker.c */
 extern int option_mem;
 unsigned long get_mem_kb(void);
+unsigned long get_mem_kb_cheap(void);
 unsigned long get_max_memory(void);
+void show_mem_report(void);
+
+/* smatch_profile.c */
+#define PROFILE_JSON 2
+extern int option_profile;
+extern int registering_check;
+struct profile_frame {
+	unsigned long long start;
+	unsigned long long saved_child;
+};
+void profile_enter(struct profile_frame *frame);
+void profile_exit(struct profile_frame *frame, int owner);
+void profile_sm_state(int owner);
+void profile_db_callback(struct profile_frame *frame, int owner);
+void show_profile_report(void);
 
 /* check_is_nospec.c */
 bool is_nospec(struct expression *expr);
@@ -124,13 +124,13 @@ int get_array_rl(struct expression *expr, struct range_list **rl)
 		return 0;
 
 	if (is_file_local(array)) {
-		run_sql(&get_vals, &db_info,
-			"select value from sink_info where file = '%s' and static = 1 and sink_name = '%s' and type = %d;",
-			get_filename(), name, DATA_VALUE);
+		run_sql_bind(&get_vals, &db_info,
+			     "select value from sink_info where file = ? and static = 1 and sink_name = ? and type = ?;",
+			     "ssd", get_filename(), name, DATA_VALUE);
 	} else {
-		run_sql(&get_vals, &db_info,
-			"select value from sink_info where sink_name = '%s' and type = %d limit 10;",
-			name, DATA_VALUE);
+		run_sql_bind(&get_vals, &db_info,
+			     "select value from sink_info where sink_name = ? and type = ? limit 10;",
+			     "sd", name, DATA_VALUE);
 	}
 	if (!db_info.rl || db_info.count >= 10)
 		return 0;
@@ -143,23 +143,55 @@ static struct range_list *get_saved_rl(struct symbol *type, char *name)
 {
 	struct db_info db_info = {.type = type};
 
-	cache_sql(&get_vals, &db_info, "select value from sink_info where sink_name = '%s' and type = %d;",
-		  name, DATA_VALUE);
+	cache_sql_bind(&get_vals, &db_info, "select value from sink_info where sink_name = ? and type = ?;",
+		       "sd", name, DATA_VALUE);
 	return db_info.rl;
 }
 
-static void update_cache(char *name, int is_static, struct range_list *rl)
+static void load_sink_info(FILE *fp);
+
+/* if there is a type then rl is added to the saved values for that type */
+static void update_cache(char *name, int is_static, struct symbol *type,
+			 struct range_list *rl)
 {
-	cache_sql(NULL, NULL, "delete from sink_info where sink_name = '%s' and type = %d;",
-		  name, DATA_VALUE);
-	cache_sql(NULL, NULL, "insert into sink_info values ('%s', %d, '%s', %d, '', '%s');",
-		  get_filename(), is_static, name, DATA_VALUE, show_rl(rl));
+	/* the parent redoes this after the --jobs worker is finished */
+	if (worker_data_fd) {
+		save_worker_data(&load_sink_info);
+		save_worker_string(name);
+		save_worker_bytes(&is_static, sizeof(is_static));
+		/* it's a base type so the pointer is the same in the parent */
+		save_worker_bytes(&type, sizeof(type));
+		save_worker_rl(rl);
+	}
+
+	if (type)
+		rl = rl_union(get_saved_rl(type, name), rl);
+
+	cache_sql_bind(NULL, NULL, "delete from sink_info where sink_name = ? and type = ?;",
+		       "sd", name, DATA_VALUE);
+	cache_sql_bind(NULL, NULL, "insert into sink_info values (?, ?, ?, ?, '', ?);",
+		       "sdsds", get_filename(), is_static, name, DATA_VALUE, show_rl(rl));
+}
+
+static void load_sink_info(FILE *fp)
+{
+	struct symbol *type;
+	struct range_list *rl;
+	int is_static;
+	char *name;
+
+	name = load_worker_string(fp);
+	load_worker_bytes(fp, &is_static, sizeof(is_static));
+	load_worker_bytes(fp, &type, sizeof(type));
+	rl = load_worker_rl(fp);
+	update_cache(name, is_static, type, rl);
+	free(name);
 }
 
 static void match_assign(struct expression *expr)
 {
 	struct expression *left, *array;
-	struct range_list *orig_rl, *rl;
+	struct range_list *rl;
 	struct symbol *type;
 	char *name;
 
@@ -178,14 +210,12 @@ static void match_assign(struct expression *expr)
 	if (expr->op != '=') {
 		rl = alloc_whole_rl(get_type(expr->right));
 		rl = cast_rl(type, rl);
+		update_cache(name, is_file_local(array), NULL, rl);
 	} else {
 		get_absolute_rl(expr->right, &rl);
 		rl = cast_rl(type, rl);
-		orig_rl = get_saved_rl(type, name);
-		rl = rl_union(orig_rl, rl);
+		update_cache(name, is_file_local(array), type, rl);
 	}
-
-	update_cache(name, is_file_local(array), rl);
 }
 
 static void mark_strings_unknown(const char *fn, struct expression *expr, void *_arg)
@@ -204,7 +234,7 @@ static void mark_strings_unknown(const char *fn, struct expression *expr, void *
 	type = get_type(dest);
 	if (type_is_ptr(type))
 		type = get_real_base_type(type);
-	update_cache(name, is_file_local(dest), alloc_whole_rl(type));
+	update_cache(name, is_file_local(dest), NULL, alloc_whole_rl(type));
 }
 
 void register_array_values(int id)
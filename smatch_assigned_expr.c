@@ -97,8 +97,6 @@ static void match_assignment(struct expression *expr)
 	char *left_name = NULL;
 	char *right_name = NULL;
 
-	if (expr->op != '=')
-		return;
 	if (is_fake_call(expr->right))
 		return;
 	if (__in_fake_struct_assign) {
@@ -177,7 +175,7 @@ void register_assigned_expr(int id)
 {
 	my_id = check_assigned_expr_id = id;
 	set_dynamic_states(check_assigned_expr_id);
-	add_hook(&match_assignment, ASSIGNMENT_HOOK_AFTER);
+	add_filtered_hook(&match_assignment, ASSIGNMENT_HOOK_AFTER, '=');
 	add_modification_hook(my_id, &undef);
 	select_return_states_hook(PARAM_SET, &record_param_assignment);
 }
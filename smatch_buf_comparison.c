@@ -742,9 +742,6 @@ static void set_used(struct expression *expr)
 	struct sm_state *tmp;
 	int limit_type;
 
-	if (expr->op != SPECIAL_INCREMENT)
-		return;
-
 	limit_type = USED_LAST;
 	if (expr->type == EXPR_POSTOP)
 		limit_type = USED_COUNT;
@@ -808,9 +805,6 @@ static int match_assign_size(struct expression *expr)
 
 static void match_assign(struct expression *expr)
 {
-	if (expr->op != '=')
-		return;
-
 	if (match_assign_array(expr))
 		return;
 	match_assign_size(expr);
@@ -877,12 +871,12 @@ void register_buf_comparison(int id)
 
 	add_hook(&array_check, OP_HOOK);
 	add_hook(&array_check_data_info, OP_HOOK);
-	add_hook(&set_used, OP_HOOK);
+	add_filtered_hook(&set_used, OP_HOOK, SPECIAL_INCREMENT);
 
 	add_hook(&match_call, FUNCTION_CALL_HOOK);
 	add_hook(&munge_start_states, AFTER_DEF_HOOK);
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 
 	for (i = BYTE_COUNT; i <= USED_COUNT; i++) {
 		select_call_implies_hook(i, &set_implied);
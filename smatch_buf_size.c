@@ -27,36 +27,23 @@
 
 static int my_size_id;
 
-static DEFINE_HASHTABLE_INSERT(insert_func, char, int);
-static DEFINE_HASHTABLE_SEARCH(search_func, char, int);
+static DEFINE_HASHTABLE_INSERT(insert_func, struct ident, int);
+static DEFINE_HASHTABLE_SEARCH(search_func, struct ident, int);
 static struct hashtable *allocation_funcs;
 
-static char *get_fn_name(struct expression *expr)
-{
-	if (expr->type != EXPR_CALL)
-		return NULL;
-	if (expr->fn->type != EXPR_SYMBOL)
-		return NULL;
-	return expr_to_var(expr->fn);
-}
-
 static int is_allocation_function(struct expression *expr)
 {
-	char *func;
-	int ret = 0;
-
-	func = get_fn_name(expr);
-	if (!func)
+	if (expr->type != EXPR_CALL || expr->fn->type != EXPR_SYMBOL ||
+	    !expr->fn->symbol_name)
 		return 0;
-	if (search_func(allocation_funcs, func))
-		ret = 1;
-	free_string(func);
-	return ret;
+	if (search_func(allocation_funcs, expr->fn->symbol_name))
+		return 1;
+	return 0;
 }
 
 static void add_allocation_function(const char *func, void *call_back, int param)
 {
-	insert_func(allocation_funcs, (char *)func, (int *)1);
+	insert_func(allocation_funcs, built_in_ident(func), (int *)1);
 	add_function_assign_hook(func, call_back, INT_PTR(param));
 }
 
@@ -647,7 +634,7 @@ int get_array_size_bytes_min(struct expression *expr)
 	if (!rl)
 		return 0;
 
-	FOR_EACH_PTR(rl, range) {
+	FOR_EACH_RANGE(rl, range) {
 		if (range->min.value <= 0)
 			return 0;
 		if (range->max.value <= 0)
@@ -655,7 +642,7 @@ int get_array_size_bytes_min(struct expression *expr)
 		if (range->min.uvalue >= INT_MAX)
 			return 0;
 		return range->min.value;
-	} END_FOR_EACH_PTR(range);
+	} END_FOR_EACH_RANGE(range);
 
 	return 0;
 }
@@ -748,9 +735,6 @@ static void match_array_assignment(struct expression *expr)
 	struct range_list *rl;
 	sval_t sval;
 
-	if (expr->op != '=')
-		return;
-
 	left = strip_expr(expr->left);
 	right = strip_expr(expr->right);
 	right = strip_ampersands(right);
@@ -989,7 +973,7 @@ void register_buf_size(int id)
 	select_return_states_hook(BUF_SIZE, &db_returns_buf_size);
 	add_split_return_callback(print_returned_allocations);
 
-	allocation_funcs = create_function_hashtable(100);
+	allocation_funcs = create_ident_hashtable(100);
 	add_allocation_function("malloc", &match_alloc, 0);
 	add_allocation_function("calloc", &match_calloc, 0);
 	add_allocation_function("memdup", &match_alloc, 1);
@@ -1044,7 +1028,7 @@ void register_buf_size(int id)
 void register_buf_size_late(int id)
 {
 	/* has to happen after match_alloc() */
-	add_hook(&match_array_assignment, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_array_assignment, ASSIGNMENT_HOOK, '=');
 
 	add_hook(&match_call, FUNCTION_CALL_HOOK);
 	add_member_info_callback(my_size_id, struct_member_callback);
@@ -1690,8 +1690,6 @@ static void match_assign(struct expression *expr)
 {
 	struct expression *right;
 
-	if (expr->op != '=')
-		return;
 	if (__in_fake_assign || outside_of_function())
 		return;
 
@@ -2720,7 +2718,7 @@ void register_comparison(int id)
 
 void register_comparison_late(int id)
 {
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 }
 
 void register_comparison_links(int id)
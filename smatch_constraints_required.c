@@ -283,8 +283,6 @@ static void match_assign_has_buf_comparison(struct expression *expr)
 	struct expression *size;
 	int limit_type;
 
-	if (expr->op != '=')
-		return;
 	if (expr->right->type == EXPR_CALL)
 		return;
 	size = get_size_variable(expr->right, &limit_type);
@@ -302,9 +300,6 @@ static void match_assign_data(struct expression *expr)
 	int size_arg;
 	int size_arg2 = -1;
 
-	if (expr->op != '=')
-		return;
-
 	/* Direct calls are handled else where (for now at least) */
 	tmp = get_assigned_expr(expr->right);
 	if (!tmp)
@@ -397,8 +392,6 @@ static void match_assign_buf_comparison(struct expression *expr)
 {
 	struct expression *pointer;
 
-	if (expr->op != '=')
-		return;
 	pointer = get_array_variable(expr->right);
 	if (!pointer)
 		return;
@@ -435,8 +428,6 @@ static void match_assign_constraint(struct expression *expr)
 
 	if (__in_fake_struct_assign)
 		return;
-	if (expr->op != '=')
-		return;
 
 	type = get_type(expr->left);
 	if (!type || type->type != SYM_BASETYPE)
@@ -462,13 +453,13 @@ void register_constraints_required(int id)
 
 	set_dynamic_states(my_id);
 	add_hook(&match_assign_size, ASSIGNMENT_HOOK);
-	add_hook(&match_assign_data, ASSIGNMENT_HOOK);
-	add_hook(&match_assign_has_buf_comparison, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign_data, ASSIGNMENT_HOOK, '=');
+	add_filtered_hook(&match_assign_has_buf_comparison, ASSIGNMENT_HOOK, '=');
 
 	add_hook(&match_assign_ARRAY_SIZE, ASSIGNMENT_HOOK);
 	add_hook(&match_assign_ARRAY_SIZE, GLOBAL_ASSIGNMENT_HOOK);
-	add_hook(&match_assign_buf_comparison, ASSIGNMENT_HOOK);
-	add_hook(&match_assign_constraint, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign_buf_comparison, ASSIGNMENT_HOOK, '=');
+	add_filtered_hook(&match_assign_constraint, ASSIGNMENT_HOOK, '=');
 
 	add_allocation_function("malloc", &match_alloc, 0);
 	add_allocation_function("memdup", &match_alloc, 1);
@@ -23,16 +23,35 @@ done
 
 ${bin_dir}/init_constraints.pl "$PROJ" $info_file $db_file
 ${bin_dir}/init_constraints_required.pl "$PROJ" $info_file $db_file
-${bin_dir}/fill_db_sql.pl "$PROJ" $info_file $db_file
-if [ -e ${info_file}.sql ] ; then
-    ${bin_dir}/fill_db_sql.pl "$PROJ" ${info_file}.sql $db_file
+db_build=${bin_dir}/../../smatch_db_build
+if [ ! -x $db_build ] ; then
+    db_build=$(command -v smatch_db_build)
 fi
-${bin_dir}/fill_db_caller_info.pl "$PROJ" $info_file $db_file
-if [ -e ${info_file}.caller_info ] ; then
-    ${bin_dir}/fill_db_caller_info.pl "$PROJ" ${info_file}.caller_info $db_file
+if [ "$db_build" != "" ] ; then
+    files=$info_file
+    for ext in sql caller_info sqlb ; do
+        if [ -e ${info_file}.$ext ] ; then
+            files="$files ${info_file}.$ext"
+        fi
+    done
+    shards=""
+    if [ -e ${info_file}.shards ] ; then
+        shards="--files-from=${info_file}.shards"
+    fi
+    $db_build --common-functions=${bin_dir}/../${PROJ}.common_functions $shards $db_file $files || exit 1
+else
+    ${bin_dir}/fill_db_sql.pl "$PROJ" $info_file $db_file
+    if [ -e ${info_file}.sql ] ; then
+        ${bin_dir}/fill_db_sql.pl "$PROJ" ${info_file}.sql $db_file
+    fi
+    ${bin_dir}/fill_db_caller_info.pl "$PROJ" $info_file $db_file
+    if [ -e ${info_file}.caller_info ] ; then
+        ${bin_dir}/fill_db_caller_info.pl "$PROJ" ${info_file}.caller_info $db_file
+    fi
 fi
 ${bin_dir}/build_early_index.sh $db_file
 
+# These read the finished tables, not the warns file.
 ${bin_dir}/fill_db_type_value.pl "$PROJ" $info_file $db_file
 ${bin_dir}/fill_db_type_size.pl "$PROJ" $info_file $db_file
 ${bin_dir}/copy_required_constraints.pl "$PROJ" $info_file $db_file
@@ -197,7 +197,8 @@ delete from return_states where function = 'bus_for_each_dev' and return = '1';
 
 EOF
 
-for i in $(echo "select distinct return from return_states where function = 'clear_user';" | sqlite3 $db_file ) ; do
+# update_db.sh runs this again on rows which have already been fixed
+for i in $(echo "select distinct return from return_states where function = 'clear_user' and instr(return, '[<=\$1]') = 0;" | sqlite3 $db_file ) ; do
     echo "update return_states set return = \"$i[<=\$1]\" where return = \"$i\" and function = 'clear_user';" | sqlite3 $db_file
 done
 
@@ -233,8 +234,15 @@ EOF
 
 done
 
-# it's easiest to pretend that invalid kobjects don't exist
-ID=$(echo "select distinct(return_id) from return_states where function = 'kobject_init' order by return_id desc limit 1;" | sqlite3 $db_file)
-echo "delete from return_states where function = 'kobject_init' and return_id = '$ID';" | sqlite3 $db_file
+# it's easiest to pretend that invalid kobjects don't exist.  After an
+# update_db.sh only the rows of the files in update_files are new.
+fresh=""
+if [ "$(echo "select count(*) from sqlite_master where name = 'update_files';" | sqlite3 $db_file)" = "1" ] ; then
+    fresh="and file in (select file from update_files where fixed = 0)"
+fi
+ID=$(echo "select distinct(return_id) from return_states where function = 'kobject_init' $fresh order by return_id desc limit 1;" | sqlite3 $db_file)
+if [ "$ID" != "" ] ; then
+    echo "delete from return_states where function = 'kobject_init' and return_id = '$ID' $fresh;" | sqlite3 $db_file
+fi
 
 
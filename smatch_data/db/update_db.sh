@@ -0,0 +1,69 @@
+#!/bin/bash
+
+#
+# Update smatch_db.sqlite in place from the --info-db shards.  Only the
+# shards which are newer than the database are copied in.  The steps after
+# the load are the same as in create_db.sh.  They run on the whole database
+# so they have to be safe to run twice.  The fixups which aren't only look
+# at the rows of the files listed in update_files which aren't fixed yet.
+# The files which have to be checked again because a function they use
+# changed are written to <file with smatch messages>.rerun.
+#
+
+if echo $1 | grep -q '^-p' ; then
+    PROJ=$(echo $1 | cut -d = -f 2)
+    shift
+fi
+
+info_file=$1
+
+if [[ "$info_file" = "" ]] || [ ! -e ${info_file}.shards ] ; then
+    echo "Usage:  $0 -p=<project> <file with smatch messages>"
+    echo "The --info-db shards are listed in <file with smatch messages>.shards"
+    exit 1
+fi
+
+bin_dir=$(dirname $0)
+db_file=smatch_db.sqlite
+
+if [ ! -e $db_file ] || \
+   ! echo "select count(*) from file_deps;" | sqlite3 $db_file > /dev/null 2>&1 ; then
+    exec ${bin_dir}/create_db.sh -p=$PROJ $info_file
+fi
+
+db_build=${bin_dir}/../../smatch_db_build
+if [ ! -x $db_build ] ; then
+    db_build=$(command -v smatch_db_build)
+fi
+if [ "$db_build" = "" ] ; then
+    echo "$0: smatch_db_build not found."
+    exit 1
+fi
+
+$db_build --update --common-functions=${bin_dir}/../${PROJ}.common_functions \
+    --files-from=${info_file}.shards $db_file || exit 1
+
+${bin_dir}/fill_db_type_value.pl "$PROJ" $info_file $db_file
+${bin_dir}/fill_db_type_size.pl "$PROJ" $info_file $db_file
+${bin_dir}/copy_required_constraints.pl "$PROJ" $info_file $db_file
+
+${bin_dir}/fixup_all.sh $db_file
+if [ "$PROJ" != "" ] ; then
+    ${bin_dir}/fixup_${PROJ}.sh $db_file
+fi
+
+${bin_dir}/copy_function_pointers.pl $db_file
+${bin_dir}/remove_mixed_up_pointer_params.pl $db_file
+${bin_dir}/delete_too_common_fn_ptr.sh $db_file
+${bin_dir}/mark_function_ptrs_searchable.pl $db_file
+
+echo "delete from function_ptr where rowid not in (select min(rowid) from function_ptr group by file, function, ptr, searchable);" | sqlite3 $db_file
+
+${bin_dir}/apply_return_fixes.sh -p=${PROJ} $db_file
+if [ "$PROJ" != "" ] ; then
+    ${bin_dir}/insert_manual_states.pl ${PROJ} $db_file
+fi
+
+# compare the fixed rows with the fixed rows from before
+echo "update update_files set fixed = 1;" | sqlite3 $db_file
+$db_build --changed=${info_file}.rerun $db_file || exit 1
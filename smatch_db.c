@@ -19,13 +19,21 @@
 #include <errno.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <openssl/md5.h>
 #include "smatch.h"
 #include "smatch_slist.h"
 #include "smatch_extra.h"
+#include "smatch_function_hashtable.h"
+#include "smatch_db_binary.h"
 
 struct sqlite3 *smatch_db;
 struct sqlite3 *mem_db;
 struct sqlite3 *cache_db;
+struct sqlite3 *info_db;
+static char *info_db_file;
+static unsigned long info_db_call_id;
 
 int debug_db;
 
@@ -33,14 +41,17 @@ STATE(incomplete);
 static int my_id;
 
 static int return_id;
+static int return_id_step = 1;
 
 static void call_return_state_hooks(struct expression *expr);
 static void call_return_states_callbacks(const char *return_ranges, struct expression *expr);
+static bool is_local(struct symbol *sym);
 
 #define SQLITE_CACHE_PAGES 1000
 
 struct def_callback {
 	int hook_type;
+	int owner;
 	void (*callback)(const char *name, struct symbol *sym, char *key, char *value);
 };
 ALLOCATOR(def_callback, "definition db hook callbacks");
@@ -49,6 +60,7 @@ static struct callback_list *select_caller_info_callbacks;
 
 struct def_name_sym_callback {
 	int hook_type;
+	int owner;
 	void (*callback)(const char *name, struct symbol *sym, char *value);
 };
 ALLOCATOR(def_name_sym_callback, "definition db hook callbacks");
@@ -93,6 +105,7 @@ static struct returned_member_cb_list *returned_member_callbacks;
 
 struct db_implies_callback {
 	int type;
+	int owner;
 	void (*callback)(struct expression *call, struct expression *arg, char *key, char *value);
 };
 ALLOCATOR(db_implies_callback, "return_implies callbacks");
@@ -172,6 +185,250 @@ void sql_exec(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), v
 	}
 }
 
+/*
+ * The hot queries are run millions of times with only the parameters
+ * changing so we keep them around as prepared statements instead of
+ * having SQLite parse and plan the same text over and over.  The SQL is
+ * written with '?' placeholders and the types string says how to bind
+ * the remaining arguments:
+ *
+ *	's' const char *	'd' int
+ *	'l' long long		'u' unsigned long
+ *	'U' unsigned long long
+ *	'F' struct symbol *, expands to the get_static_filter_bind() params
+ */
+struct prepared_sql {
+	struct sqlite3 *db;
+	const char *sql;
+	sqlite3_stmt *stmt;
+	int busy;
+	unsigned long calls;
+	unsigned long rows;
+	unsigned long long usec;
+};
+ALLOCATOR(prepared_sql, "prepared sql statements");
+DECLARE_PTR_LIST(prepared_sql_list, struct prepared_sql);
+DEFINE_FUNCTION_HASHTABLE_STATIC(prepared, struct prepared_sql, struct prepared_sql_list);
+static struct hashtable *prepared_hash;
+static struct prepared_sql_list *prepared_list;
+
+static struct prepared_sql *get_prepared_sql(struct sqlite3 *db, const char *sql)
+{
+	struct prepared_sql_list *list;
+	struct prepared_sql *tmp;
+
+	if (!prepared_hash)
+		prepared_hash = create_function_hashtable(100);
+
+	list = search_prepared(prepared_hash, (char *)sql);
+	FOR_EACH_PTR(list, tmp) {
+		if (tmp->db == db)
+			return tmp;
+	} END_FOR_EACH_PTR(tmp);
+
+	tmp = __alloc_prepared_sql(0);
+	tmp->db = db;
+	tmp->sql = alloc_string(sql);
+	if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &tmp->stmt, NULL) != SQLITE_OK)
+		tmp->stmt = NULL;
+	add_prepared(prepared_hash, sql, tmp);
+	add_ptr_list(&prepared_list, tmp);
+	return tmp;
+}
+
+const char *get_static_filter_bind(struct symbol *sym)
+{
+	/* This can only happen on buggy code.  Return invalid SQL. */
+	if (!sym)
+		return "";
+	if (is_local(sym))
+		return "file = ? and function = ? and static = '1'";
+	return "function = ? and static = '0'";
+}
+
+static int bind_params(sqlite3_stmt *stmt, const char *types, va_list args)
+{
+	unsigned long long uval;
+	struct symbol *sym;
+	const char *str;
+	int idx = 1;
+	int rc = SQLITE_OK;
+
+	for (; *types && rc == SQLITE_OK; types++) {
+		switch (*types) {
+		case 's':
+			/* '%s' printed NULL as an empty string so do the same */
+			str = va_arg(args, const char *);
+			rc = sqlite3_bind_text(stmt, idx++, str ?: "", -1, SQLITE_STATIC);
+			break;
+		case 'd':
+			rc = sqlite3_bind_int(stmt, idx++, va_arg(args, int));
+			break;
+		case 'l':
+			rc = sqlite3_bind_int64(stmt, idx++, va_arg(args, long long));
+			break;
+		case 'u':
+			rc = sqlite3_bind_int64(stmt, idx++, va_arg(args, unsigned long));
+			break;
+		case 'U':
+			/* SQLite stores integers which don't fit in 64 bits as floats */
+			uval = va_arg(args, unsigned long long);
+			if (uval > LLONG_MAX)
+				rc = sqlite3_bind_double(stmt, idx++, uval);
+			else
+				rc = sqlite3_bind_int64(stmt, idx++, uval);
+			break;
+		case 'F':
+			sym = va_arg(args, struct symbol *);
+			if (!sym)
+				break;
+			if (is_local(sym))
+				rc = sqlite3_bind_text(stmt, idx++, get_base_file(), -1, SQLITE_STATIC);
+			if (rc == SQLITE_OK)
+				rc = sqlite3_bind_text(stmt, idx++, sym->ident->name, -1, SQLITE_STATIC);
+			break;
+		default:
+			sm_ierror("unknown SQL bind type '%c'", *types);
+			return SQLITE_ERROR;
+		}
+	}
+	return rc;
+}
+
+static void sql_prepared_error(struct sqlite3 *db, const char *sql)
+{
+	if (parse_error)
+		return;
+	sm_ierror("%s:%d SQL error #2: %s\n", get_filename(), get_lineno(), sqlite3_errmsg(db));
+	sm_ierror("%s:%d SQL: '%s'\n", get_filename(), get_lineno(), sql);
+	parse_error = 1;
+}
+
+void sql_exec_bind(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), void *data, const char *sql, const char *types, ...)
+{
+	struct prepared_sql *prep;
+	struct timeval start, stop;
+	sqlite3_stmt *stmt;
+	char *argv[32], *cols[32];
+	char *expanded;
+	va_list args;
+	int argc, i;
+	int rc;
+
+	if (!db)
+		return;
+
+	if (option_time)
+		gettimeofday(&start, NULL);
+
+	prep = get_prepared_sql(db, sql);
+	if (!prep->stmt) {
+		sql_prepared_error(db, sql);
+		return;
+	}
+
+	/*
+	 * The callbacks can recurse into the same query so if the cached
+	 * statement is already running then use a temporary one.
+	 */
+	stmt = prep->stmt;
+	if (prep->busy &&
+	    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+		sql_prepared_error(db, sql);
+		return;
+	}
+	prep->busy++;
+
+	va_start(args, types);
+	rc = bind_params(stmt, types, args);
+	va_end(args);
+	if (rc != SQLITE_OK) {
+		sql_prepared_error(db, sql);
+		goto done;
+	}
+
+	if (option_debug || debug_db) {
+		expanded = sqlite3_expanded_sql(stmt);
+		sm_msg("%s", expanded ? expanded : sql);
+		sqlite3_free(expanded);
+	}
+
+	argc = sqlite3_column_count(stmt);
+	if (argc > ARRAY_SIZE(argv))
+		argc = ARRAY_SIZE(argv);
+	for (i = 0; i < argc; i++)
+		cols[i] = (char *)sqlite3_column_name(stmt, i);
+
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		prep->rows++;
+		for (i = 0; i < argc; i++)
+			argv[i] = (char *)sqlite3_column_text(stmt, i);
+		if (option_debug || debug_db)
+			print_sql_output(NULL, argc, argv, cols);
+		if (callback && callback(data, argc, argv, cols)) {
+			rc = SQLITE_DONE;
+			break;
+		}
+	}
+	if (rc != SQLITE_DONE)
+		sql_prepared_error(db, sql);
+
+done:
+	prep->busy--;
+	if (stmt == prep->stmt) {
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+	} else {
+		sqlite3_finalize(stmt);
+	}
+
+	prep->calls++;
+	if (option_time) {
+		gettimeofday(&stop, NULL);
+		prep->usec += (stop.tv_sec - start.tv_sec) * 1000000ULL +
+			      stop.tv_usec - start.tv_usec;
+	}
+}
+
+static int cmp_prepared_time(const void *_a, const void *_b)
+{
+	const struct prepared_sql *a = _a;
+	const struct prepared_sql *b = _b;
+
+	if (a->usec != b->usec)
+		return a->usec > b->usec ? -1 : 1;
+	if (a->calls != b->calls)
+		return a->calls > b->calls ? -1 : 1;
+	return 0;
+}
+
+static const char *db_name(struct sqlite3 *db)
+{
+	if (db == smatch_db)
+		return "smatch_db";
+	if (db == mem_db)
+		return "mem_db";
+	if (db == cache_db)
+		return "cache_db";
+	if (db && db == info_db)
+		return "info_db";
+	return "unknown";
+}
+
+static void print_return_states_cache_stats(void);
+void print_sql_stats(void)
+{
+	struct prepared_sql *prep;
+
+	sort_list((struct ptr_list **)&prepared_list, cmp_prepared_time);
+	FOR_EACH_PTR(prepared_list, prep) {
+		sm_msg("sql: %s calls=%lu rows=%lu time=%llu.%06llu '%s'",
+		       db_name(prep->db), prep->calls, prep->rows,
+		       prep->usec / 1000000, prep->usec % 1000000, prep->sql);
+	} END_FOR_EACH_PTR(prep);
+	print_return_states_cache_stats();
+}
+
 static int replace_count;
 static char **replace_table;
 static const char *replace_return_ranges(const char *return_ranges)
@@ -283,6 +540,182 @@ static void set_fn_mtag(struct symbol *sym)
 	__fn_mtag = str_to_mtag(buf);
 }
 
+static char *sqlb_buf;
+static int sqlb_len, sqlb_alloced;
+
+static void sqlb_add(const void *data, int len)
+{
+	if (sqlb_len + len > sqlb_alloced) {
+		sqlb_alloced = (sqlb_len + len) * 2;
+		sqlb_buf = realloc(sqlb_buf, sqlb_alloced);
+	}
+	memcpy(sqlb_buf + sqlb_len, data, len);
+	sqlb_len += len;
+}
+
+static void sqlb_add_u8(int val)
+{
+	unsigned char c = val;
+
+	sqlb_add(&c, 1);
+}
+
+static void sqlb_start(int kind)
+{
+	unsigned int len = 0;
+
+	sqlb_len = 0;
+	sqlb_add(&len, sizeof(len));
+	sqlb_add_u8(kind);
+}
+
+static void sqlb_finish(void)
+{
+	unsigned int len = sqlb_len - sizeof(len);
+
+	memcpy(sqlb_buf, &len, sizeof(len));
+	fwrite(sqlb_buf, sqlb_len, 1, sql_bin_fd);
+}
+
+static FILE *sqlb_tables_fd;
+
+/*
+ * The output from the --jobs workers is copied into the file and it starts
+ * its own list of tables so we have to start over as well.
+ */
+void forget_sqlb_tables(void)
+{
+	sqlb_tables_fd = NULL;
+}
+
+static int get_sqlb_table_id(const char *table)
+{
+	static const char *tables[SQLB_MAX_TABLES];
+	static int nr_tables;
+	int i;
+
+	/* each output file starts over */
+	if (sqlb_tables_fd != sql_bin_fd) {
+		sqlb_tables_fd = sql_bin_fd;
+		nr_tables = 0;
+		sqlb_start(SQLB_VERSION);
+		sqlb_add(SQLB_MAGIC, strlen(SQLB_MAGIC));
+		sqlb_finish();
+	}
+
+	for (i = 0; i < nr_tables; i++) {
+		if (strcmp(tables[i], table) == 0)
+			return i;
+	}
+	if (nr_tables == SQLB_MAX_TABLES)
+		sm_fatal("too many tables for --info-binary");
+
+	tables[nr_tables] = table;
+	sqlb_start(SQLB_TABLE);
+	sqlb_add_u8(nr_tables);
+	sqlb_add(table, strlen(table));
+	sqlb_finish();
+	return nr_tables++;
+}
+
+static bool sqlb_printing(void)
+{
+	return final_pass || option_debug || local_debug || debug_db;
+}
+
+static void sqlb_start_row(int kind, const char *table, int ignore, int nr_fields)
+{
+	int id = get_sqlb_table_id(table);
+
+	sqlb_start(kind);
+	sqlb_add_u8(id);
+	sqlb_add_u8(ignore ? SQLB_IGNORE : 0);
+	sqlb_add_u8(nr_fields);
+}
+
+void sql_insert_binary_text(const char *table, int ignore, int late, const char *fmt, ...)
+{
+	va_list args;
+	char buf[4096];
+	int len;
+
+	if (!sqlb_printing())
+		return;
+
+	va_start(args, fmt);
+	len = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (len >= sizeof(buf))
+		len = sizeof(buf) - 1;
+
+	sqlb_start_row(late ? SQLB_LATE : SQLB_SQL, table, ignore, 0);
+	sqlb_add(buf, len);
+	sqlb_finish();
+}
+
+/*
+ * The types are the same as sql_exec_bind() except that 'u' is an unsigned
+ * long long and 'c' is the %CALL_ID% which doesn't take an argument.
+ */
+static void sql_insert_binary(int kind, const char *table, const char *types, ...)
+{
+	unsigned long long uval;
+	long long val;
+	const char *str;
+	unsigned int len;
+	va_list args;
+	int i;
+
+	if (!sqlb_printing())
+		return;
+
+	sqlb_start_row(kind, table, 0, strlen(types));
+
+	va_start(args, types);
+	for (i = 0; types[i]; i++) {
+		sqlb_add_u8(types[i]);
+		switch (types[i]) {
+		case 'd':
+			val = va_arg(args, int);
+			sqlb_add(&val, sizeof(val));
+			break;
+		case 'l':
+			val = va_arg(args, long long);
+			sqlb_add(&val, sizeof(val));
+			break;
+		case 'u':
+			uval = va_arg(args, unsigned long long);
+			sqlb_add(&uval, sizeof(uval));
+			break;
+		case 's':
+			str = va_arg(args, const char *);
+			if (!str)
+				str = "";
+			len = strlen(str);
+			sqlb_add(&len, sizeof(len));
+			sqlb_add(str, len + 1);
+			break;
+		case 'c':
+			break;
+		default:
+			sm_fatal("%s: unknown type '%c'", __func__, types[i]);
+		}
+	}
+	va_end(args);
+
+	sqlb_finish();
+}
+
+static struct sqlite3 *get_info_db(void);
+
+#define run_info_db_bind(sql, types...)						\
+do {										\
+	struct sqlite3 *_db = get_info_db();					\
+										\
+	if (_db)								\
+		sql_exec_bind(_db, NULL, NULL, sql, types);			\
+} while (0)
+
 void sql_insert_return_states(int return_id, const char *return_ranges,
 		int type, int param, const char *key, const char *value)
 {
@@ -296,6 +729,20 @@ void sql_insert_return_states(int return_id, const char *return_ranges,
 	else
 		id = __fn_mtag;
 
+	if (option_info && info_db && !__inline_fn) {
+		run_info_db_bind("insert into return_states values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+				 "ssUdsdddss", get_base_file(), get_function(), id, return_id,
+				 return_ranges, is_local(cur_func_sym), type, param, key, value);
+		return;
+	}
+
+	if (option_info && sql_bin_fd && !__inline_fn) {
+		sql_insert_binary(SQLB_SQL, "return_states", "ssudsdddss",
+				  get_base_file(), get_function(), id, return_id,
+				  return_ranges, is_local(cur_func_sym), type, param, key, value);
+		return;
+	}
+
 	sql_insert(return_states, "'%s', '%s', %llu, %d, '%s', %d, %d, %d, '%s', '%s'",
 		   get_base_file(), get_function(), id, return_id,
 		   return_ranges, is_local(cur_func_sym), type, param, key, value);
@@ -344,10 +791,10 @@ void sql_insert_caller_info(struct expression *call, int type,
 		return;
 
 	if (__inline_call) {
-		mem_sql(NULL, NULL,
-			"insert into caller_info values ('%s', '%s', '%s', %lu, %d, %d, %d, '%s', '%s');",
-			get_base_file(), get_function(), fn, (unsigned long)call,
-			is_static(call->fn), type, param, key, value);
+		mem_sql_bind(NULL, NULL,
+			     "insert into caller_info values (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+			     "sssudddss", get_base_file(), get_function(), fn, (unsigned long)call,
+			     is_static(call->fn), type, param, key, value);
 	}
 
 	if (!option_info)
@@ -358,6 +805,27 @@ void sql_insert_caller_info(struct expression *call, int type,
 	if (type != INTERNAL && is_common_function(fn))
 		return;
 
+	if (info_db) {
+		if (key && strcmp(key, "%call_marker%") == 0)
+			info_db_call_id++;
+		if (!__silence_warnings_for_stmt || option_debug || local_debug)
+			run_info_db_bind("insert into caller_info values (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+					 "sssudddss", get_base_file(), get_function(), fn,
+					 info_db_call_id, is_static(call->fn), type, param,
+					 key, value);
+		free_string(fn);
+		return;
+	}
+
+	if (sql_bin_fd) {
+		if (!__silence_warnings_for_stmt || option_debug || local_debug)
+			sql_insert_binary(SQLB_CALLER_INFO, "caller_info", "ssscdddss",
+					  get_base_file(), get_function(), fn,
+					  is_static(call->fn), type, param, key, value);
+		free_string(fn);
+		return;
+	}
+
 	sm_outfd = caller_info_fd;
 	sm_msg("SQL_caller_info: insert into caller_info values ("
 	       "'%s', '%s', '%s', %%CALL_ID%%, %d, %d, %d, '%s', '%s');",
@@ -449,6 +917,11 @@ void sql_save_constraint(const char *con)
 	if (!option_info)
 		return;
 
+	if (info_db) {
+		sql_insert_info_db("constraints (str)", 1, "'%s'", escape_newlines(con));
+		return;
+	}
+
         sm_msg("SQL: insert or ignore into constraints (str) values('%s');", escape_newlines(con));
 }
 
@@ -525,9 +998,9 @@ int mtag_map_select_container(mtag_t tag, int container_offset, mtag_t *containe
 {
 	mtag_t tmp = 0;
 
-	run_sql(save_mtag, &tmp,
-		"select container from mtag_map where tag = %lld and container_offset = %d and tag_offset = 0;",
-		tag, container_offset);
+	run_sql_bind(save_mtag, &tmp,
+		     "select container from mtag_map where tag = ? and container_offset = ? and tag_offset = 0;",
+		     "ld", tag, container_offset);
 
 	if (tmp == 0 || tmp == -1ULL)
 		return 0;
@@ -539,9 +1012,9 @@ int mtag_map_select_tag(mtag_t container, int offset, mtag_t *tag)
 {
 	mtag_t tmp = 0;
 
-	run_sql(save_mtag, &tmp,
-		"select tag from mtag_map where container = %lld and container_offset = %d;",
-		container, offset);
+	run_sql_bind(save_mtag, &tmp,
+		     "select tag from mtag_map where container = ? and container_offset = ?;",
+		     "ld", container, offset);
 
 	if (tmp == 0 || tmp == -1ULL)
 		return 0;
@@ -571,17 +1044,207 @@ char *get_static_filter(struct symbol *sym)
 	return sql_filter;
 }
 
-static int get_row_count(void *_row_count, int argc, char **argv, char **azColName)
+/*
+ * The return_states lookups used to run a "select count(*)" and then the
+ * real query which meant scanning the biggest table twice.  Instead, run
+ * the query once and buffer the rows.  If we hit the limits then throw
+ * the rows away otherwise pass them to the callback.
+ */
+struct return_states_buf {
+	int max_rows;
+	int max_internal;
+	int type_col;
+	int internal;
+	bool too_many;
+	int argc;
+	char **cols;
+	char ***rows;
+	int nr;
+	int alloced;
+
+	/* for the return_states_cache */
+	char *key;
+	int busy;
+	struct return_states_buf *prev, *next;
+};
+
+static char **copy_row(int argc, char **argv)
 {
-	int *row_count = _row_count;
+	char **row, *p;
+	size_t size;
+	int i;
 
-	*row_count = 0;
-	if (argc != 1)
-		return 0;
-	*row_count = atoi(argv[0]);
+	size = argc * sizeof(char *);
+	for (i = 0; i < argc; i++) {
+		if (argv[i])
+			size += strlen(argv[i]) + 1;
+	}
+
+	row = malloc(size);
+	p = (char *)(row + argc);
+	for (i = 0; i < argc; i++) {
+		if (!argv[i]) {
+			row[i] = NULL;
+			continue;
+		}
+		row[i] = p;
+		p = stpcpy(p, argv[i]) + 1;
+	}
+	return row;
+}
+
+static int buffer_return_state(void *_buf, int argc, char **argv, char **azColName)
+{
+	struct return_states_buf *buf = _buf;
+	int i;
+
+	if (!buf->cols) {
+		buf->argc = argc;
+		buf->cols = copy_row(argc, azColName);
+		buf->type_col = -1;
+		for (i = 0; i < argc; i++) {
+			if (strcmp(azColName[i], "type") == 0)
+				buf->type_col = i;
+		}
+	}
+
+	if (buf->max_internal && buf->type_col >= 0 &&
+	    argv[buf->type_col] && atoi(argv[buf->type_col]) == INTERNAL &&
+	    ++buf->internal > buf->max_internal) {
+		buf->too_many = true;
+		return 1;
+	}
+	if (buf->max_rows && buf->nr >= buf->max_rows) {
+		buf->too_many = true;
+		return 1;
+	}
+
+	if (buf->nr == buf->alloced) {
+		buf->alloced = buf->alloced ? buf->alloced * 2 : 64;
+		buf->rows = realloc(buf->rows, buf->alloced * sizeof(*buf->rows));
+	}
+	buf->rows[buf->nr++] = copy_row(argc, argv);
 	return 0;
 }
 
+static void replay_return_states(struct return_states_buf *buf,
+	int (*callback)(void*, int, char**, char**), void *info)
+{
+	int i;
+
+	if (buf->too_many)
+		return;
+
+	for (i = 0; i < buf->nr; i++) {
+		if (callback(info, buf->argc, buf->rows[i], buf->cols))
+			break;
+	}
+}
+
+static void free_return_states_buf(struct return_states_buf *buf)
+{
+	int i;
+
+	for (i = 0; i < buf->nr; i++)
+		free(buf->rows[i]);
+	free(buf->rows);
+	free(buf->cols);
+}
+
+/*
+ * The same functions (kmalloc(), mutex_lock() etc) get looked up at every
+ * call site so keep the most recently used return_states rows around.
+ * The DB is opened read only so the rows never go stale.  The limit is in
+ * rows instead of functions because some functions have thousands.
+ */
+#define RETURN_STATES_CACHE_ROWS 100000
+
+DEFINE_HASHTABLE_INSERT(insert_return_states_buf, char, struct return_states_buf);
+DEFINE_HASHTABLE_SEARCH(search_return_states_buf, char, struct return_states_buf);
+DEFINE_HASHTABLE_REMOVE(remove_return_states_buf, char, struct return_states_buf);
+static struct hashtable *return_states_cache;
+static struct return_states_buf lru = { .prev = &lru, .next = &lru };
+static int cached_rows;
+static unsigned long cache_hits, cache_misses;
+
+static void lru_del(struct return_states_buf *buf)
+{
+	buf->prev->next = buf->next;
+	buf->next->prev = buf->prev;
+}
+
+static void lru_add(struct return_states_buf *buf)
+{
+	buf->next = lru.next;
+	buf->prev = &lru;
+	lru.next->prev = buf;
+	lru.next = buf;
+}
+
+static void shrink_return_states_cache(void)
+{
+	struct return_states_buf *buf, *prev;
+
+	for (buf = lru.prev; buf != &lru && cached_rows > RETURN_STATES_CACHE_ROWS; buf = prev) {
+		prev = buf->prev;
+		if (buf->busy)
+			continue;
+		lru_del(buf);
+		remove_return_states_buf(return_states_cache, buf->key);
+		cached_rows -= buf->nr;
+		free_return_states_buf(buf);
+		free(buf);
+	}
+}
+
+static struct return_states_buf *get_return_states_buf(const char *cols, struct symbol *sym)
+{
+	struct return_states_buf *buf;
+	const char *file;
+	char sql[1024];
+	char *key;
+	int len;
+
+	/* kernel paths and function names can be long so don't truncate */
+	file = is_local(sym) ? get_base_file() : "";
+	len = snprintf(NULL, 0, "%s|%s|%s", cols, file, sym->ident->name);
+	key = malloc(len + 1);
+	snprintf(key, len + 1, "%s|%s|%s", cols, file, sym->ident->name);
+
+	if (!return_states_cache)
+		return_states_cache = create_function_hashtable(1000);
+
+	buf = search_return_states_buf(return_states_cache, key);
+	if (buf) {
+		cache_hits++;
+		lru_del(buf);
+		lru_add(buf);
+		free(key);
+		return buf;
+	}
+	cache_misses++;
+
+	buf = calloc(1, sizeof(*buf));
+	buf->max_rows = 3000;
+	snprintf(sql, sizeof(sql), "select %s from return_states where %s order by file, return_id, type;",
+		 cols, get_static_filter_bind(sym));
+	run_sql_bind(buffer_return_state, buf, sql, "F", sym);
+
+	buf->key = key;
+	insert_return_states_buf(return_states_cache, buf->key, buf);
+	lru_add(buf);
+	cached_rows += buf->nr;
+	shrink_return_states_cache();
+
+	return buf;
+}
+
+static void print_return_states_cache_stats(void)
+{
+	sm_msg("return_states cache: hits=%lu misses=%lu rows=%d",
+	       cache_hits, cache_misses, cached_rows);
+}
+
 static void mark_call_params_untracked(struct expression *call)
 {
 	struct expression *arg;
@@ -595,29 +1258,26 @@ static void mark_call_params_untracked(struct expression *call)
 static void sql_select_return_states_pointer(const char *cols,
 	struct expression *call, int (*callback)(void*, int, char**, char**), void *info)
 {
+	/* The magic number 100 is just from testing on the kernel. */
+	struct return_states_buf buf = { .max_internal = 100 };
+	char sql[1024];
 	char *ptr;
-	int return_count = 0;
 
 	ptr = get_fnptr_name(call->fn);
 	if (!ptr)
 		return;
 
-	run_sql(get_row_count, &return_count,
-		"select count(*) from return_states join function_ptr "
-		"where return_states.function == function_ptr.function and "
-		"ptr = '%s' and searchable = 1 and type = %d;", ptr, INTERNAL);
-	/* The magic number 100 is just from testing on the kernel. */
-	if (return_count > 100) {
+	snprintf(sql, sizeof(sql),
+		 "select %s from return_states join function_ptr where "
+		 "return_states.function == function_ptr.function and ptr = ? "
+		 "and searchable = 1 "
+		 "order by function_ptr.file, return_states.file, return_id, type;",
+		 cols);
+	run_sql_bind(buffer_return_state, &buf, sql, "s", ptr);
+	if (buf.too_many)
 		mark_call_params_untracked(call);
-		return;
-	}
-
-	run_sql(callback, info,
-		"select %s from return_states join function_ptr where "
-		"return_states.function == function_ptr.function and ptr = '%s' "
-		"and searchable = 1 "
-		"order by function_ptr.file, return_states.file, return_id, type;",
-		cols, ptr);
+	replay_return_states(&buf, callback, info);
+	free_return_states_buf(&buf);
 }
 
 static int is_local_symbol(struct expression *expr)
@@ -644,8 +1304,9 @@ bool is_fn_ptr(struct expression *fn)
 void sql_select_return_states(const char *cols, struct expression *call,
 	int (*callback)(void*, int, char**, char**), void *info)
 {
+	struct return_states_buf *buf;
 	struct expression *fn;
-	int row_count = 0;
+	char sql[1024];
 
 	if (is_fake_call(call))
 		return;
@@ -657,21 +1318,23 @@ void sql_select_return_states(const char *cols, struct expression *call,
 	}
 
 	if (inlinable(fn)) {
-		mem_sql(callback, info,
-			"select %s from return_states where call_id = '%lu' order by return_id, type;",
-			cols, (unsigned long)call);
+		snprintf(sql, sizeof(sql),
+			 "select %s from return_states where call_id = ? order by return_id, type;",
+			 cols);
+		mem_sql_bind(callback, info, sql, "u", (unsigned long)call);
 		return;
 	}
 
-	run_sql(get_row_count, &row_count, "select count(*) from return_states where %s;",
-		get_static_filter(fn->symbol));
-	if (row_count == 0 && fn->symbol && fn->symbol->definition)
-		set_state(my_id, "db_incomplete", NULL, &incomplete);
-	if (row_count > 3000)
+	/* This can only happen on buggy code. */
+	if (!fn->symbol)
 		return;
 
-	run_sql(callback, info, "select %s from return_states where %s order by file, return_id, type;",
-		cols, get_static_filter(fn->symbol));
+	buf = get_return_states_buf(cols, fn->symbol);
+	if (buf->nr == 0 && fn->symbol->definition)
+		set_state(my_id, "db_incomplete", NULL, &incomplete);
+	buf->busy++;
+	replay_return_states(buf, callback, info);
+	buf->busy--;
 }
 
 bool db_incomplete(void)
@@ -692,22 +1355,25 @@ struct implies_info {
 void sql_select_implies(const char *cols, struct implies_info *info,
 	int (*callback)(void*, int, char**, char**))
 {
+	char sql[1024];
+
 	if (info->type == RETURN_IMPLIES && inlinable(info->expr->fn)) {
-		mem_sql(callback, info,
-			"select %s from return_implies where call_id = '%lu';",
-			cols, (unsigned long)info->expr);
+		snprintf(sql, sizeof(sql),
+			 "select %s from return_implies where call_id = ?;", cols);
+		mem_sql_bind(callback, info, sql, "u", (unsigned long)info->expr);
 		return;
 	}
 
-	run_sql(callback, info, "select %s from %s_implies where %s;",
-		cols,
-		info->type == CALL_IMPLIES ? "call" : "return",
-		get_static_filter(info->sym));
+	snprintf(sql, sizeof(sql), "select %s from %s_implies where %s;",
+		 cols,
+		 info->type == CALL_IMPLIES ? "call" : "return",
+		 get_static_filter_bind(info->sym));
+	run_sql_bind(callback, info, sql, "F", info->sym);
 }
 
 struct select_caller_info_data {
 	struct stree *final_states;
-	struct timeval start_time;
+	unsigned long long start_work;
 	int prev_func_id;
 	int ignore;
 	int results;
@@ -718,24 +1384,28 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 static void sql_select_caller_info(struct select_caller_info_data *data,
 	const char *cols, struct symbol *sym)
 {
+	char sql[1024];
+
 	if (__inline_fn) {
-		mem_sql(caller_info_callback, data,
-			"select %s from caller_info where call_id = %lu;",
-			cols, (unsigned long)__inline_fn);
+		snprintf(sql, sizeof(sql),
+			 "select %s from caller_info where call_id = ?;", cols);
+		mem_sql_bind(caller_info_callback, data, sql, "u", (unsigned long)__inline_fn);
 		return;
 	}
 
 	if (sym->ident->name && is_common_function(sym->ident->name))
 		return;
-	run_sql(caller_info_callback, data,
-		"select %s from common_caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+	snprintf(sql, sizeof(sql),
+		 "select %s from common_caller_info where %s order by call_id;",
+		 cols, get_static_filter_bind(sym));
+	run_sql_bind(caller_info_callback, data, sql, "F", sym);
 	if (data->results)
 		return;
 
-	run_sql(caller_info_callback, data,
-		"select %s from caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+	snprintf(sql, sizeof(sql),
+		 "select %s from caller_info where %s order by call_id;",
+		 cols, get_static_filter_bind(sym));
+	run_sql_bind(caller_info_callback, data, sql, "F", sym);
 }
 
 void select_caller_info_hook(void (*callback)(const char *name, struct symbol *sym, char *key, char *value), int type)
@@ -743,6 +1413,7 @@ void select_caller_info_hook(void (*callback)(const char *name, struct symbol *s
 	struct def_callback *def_callback = __alloc_def_callback(0);
 
 	def_callback->hook_type = type;
+	def_callback->owner = registering_check;
 	def_callback->callback = callback;
 	add_ptr_list(&select_caller_info_callbacks, def_callback);
 }
@@ -752,6 +1423,7 @@ void select_caller_name_sym(void (*fn)(const char *name, struct symbol *sym, cha
 	struct def_name_sym_callback *callback = __alloc_def_name_sym_callback(0);
 
 	callback->hook_type = type;
+	callback->owner = registering_check;
 	callback->callback = fn;
 	add_ptr_list(&select_caller_name_sym_callbacks, callback);
 }
@@ -815,6 +1487,7 @@ void select_call_implies_hook(int type, void (*callback)(struct expression *call
 	struct db_implies_callback *cb = __alloc_db_implies_callback(0);
 
 	cb->type = type;
+	cb->owner = registering_check;
 	cb->callback = callback;
 	add_ptr_list(&call_implies_cb_list, cb);
 }
@@ -824,6 +1497,7 @@ void select_return_implies_hook(int type, void (*callback)(struct expression *ca
 	struct db_implies_callback *cb = __alloc_db_implies_callback(0);
 
 	cb->type = type;
+	cb->owner = registering_check;
 	cb->callback = callback;
 	add_ptr_list(&return_implies_cb_list, cb);
 }
@@ -851,6 +1525,7 @@ struct range_list *db_return_vals(struct expression *expr)
 {
 	struct return_info ret_info = {};
 	struct sm_state *sm;
+	char sql[256];
 
 	if (is_fake_call(expr))
 		return NULL;
@@ -868,13 +1543,14 @@ struct range_list *db_return_vals(struct expression *expr)
 
 	ret_info.return_range_list = NULL;
 	if (inlinable(expr->fn)) {
-		mem_sql(db_return_callback, &ret_info,
-			"select distinct return from return_states where call_id = '%lu';",
-			(unsigned long)expr);
+		mem_sql_bind(db_return_callback, &ret_info,
+			     "select distinct return from return_states where call_id = ?;",
+			     "u", (unsigned long)expr);
 	} else {
-		run_sql(db_return_callback, &ret_info,
-			"select distinct return from return_states where %s;",
-			get_static_filter(expr->fn->symbol));
+		snprintf(sql, sizeof(sql),
+			 "select distinct return from return_states where %s;",
+			 get_static_filter_bind(expr->fn->symbol));
+		run_sql_bind(db_return_callback, &ret_info, sql, "F", expr->fn->symbol);
 	}
 	return ret_info.return_range_list;
 }
@@ -887,9 +1563,9 @@ struct range_list *db_return_vals_from_str(const char *fn_name)
 	ret_info.return_type = &llong_ctype;
 	ret_info.return_range_list = NULL;
 
-	run_sql(db_return_callback, &ret_info,
-		"select distinct return from return_states where function = '%s';",
-		fn_name);
+	run_sql_bind(db_return_callback, &ret_info,
+		     "select distinct return from return_states where function = ?;",
+		     "s", fn_name);
 	return ret_info.return_range_list;
 }
 
@@ -903,6 +1579,7 @@ struct range_list *db_return_vals_from_str(const char *fn_name)
 struct range_list *db_return_vals_no_args(struct expression *expr)
 {
 	struct return_info ret_info = {};
+	char sql[256];
 
 	if (!expr || expr->type != EXPR_SYMBOL)
 		return NULL;
@@ -913,9 +1590,10 @@ struct range_list *db_return_vals_no_args(struct expression *expr)
 	if (!ret_info.return_type)
 		return NULL;
 
-	run_sql(db_return_callback, &ret_info,
-		"select distinct return from return_states where %s;",
-		get_static_filter(expr->symbol));
+	snprintf(sql, sizeof(sql),
+		 "select distinct return from return_states where %s;",
+		 get_static_filter_bind(expr->symbol));
+	run_sql_bind(db_return_callback, &ret_info, sql, "F", expr->symbol);
 
 	return ret_info.return_range_list;
 }
@@ -1217,8 +1895,8 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 	struct symbol *sym = NULL;
 	struct def_callback *def_callback;
 	struct def_name_sym_callback *ns_callback;
+	struct profile_frame frame;
 	struct stree *stree;
-	struct timeval cur_time;
 	char fullname[256];
 	char *p;
 
@@ -1227,8 +1905,8 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 	if (argc != 5)
 		return 0;
 
-	gettimeofday(&cur_time, NULL);
-	if (cur_time.tv_sec - data->start_time.tv_sec > 10)
+	add_work(1);
+	if (work_units - data->start_work > 10 * WORK_PER_SECOND)
 		return 0;
 
 	func_id = atoi(argv[0]);
@@ -1265,8 +1943,13 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 		return 0;
 
 	FOR_EACH_PTR(select_caller_info_callbacks, def_callback) {
-		if (def_callback->hook_type == type)
-			def_callback->callback(name, sym, key, value);
+		if (def_callback->hook_type != type)
+			continue;
+		if (option_profile)
+			profile_enter(&frame);
+		def_callback->callback(name, sym, key, value);
+		if (option_profile)
+			profile_db_callback(&frame, def_callback->owner);
 	} END_FOR_EACH_PTR(def_callback);
 
 	p = strchr(key, '$');
@@ -1276,8 +1959,13 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 		snprintf(fullname, sizeof(fullname), "%s", key);
 
 	FOR_EACH_PTR(select_caller_name_sym_callbacks, ns_callback) {
-		if (ns_callback->hook_type == type)
-			ns_callback->callback(fullname, sym, value);
+		if (ns_callback->hook_type != type)
+			continue;
+		if (option_profile)
+			profile_enter(&frame);
+		ns_callback->callback(fullname, sym, value);
+		if (option_profile)
+			profile_db_callback(&frame, ns_callback->owner);
 	} END_FOR_EACH_PTR(ns_callback);
 
 	return 0;
@@ -1306,22 +1994,20 @@ static char *get_next_ptr_name(void)
 
 static void get_ptr_names(const char *file, const char *name)
 {
-	char sql_filter[1024];
 	int before, after;
 
+	before = ptr_list_size((struct ptr_list *)ptr_names);
+
 	if (file) {
-		snprintf(sql_filter, 1024, "file = '%s' and function = '%s';",
-			 file, name);
+		run_sql_bind(get_ptr_name, NULL,
+			     "select distinct ptr from function_ptr where file = ? and function = ?;",
+			     "ss", file, name);
 	} else {
-		snprintf(sql_filter, 1024, "function = '%s';", name);
+		run_sql_bind(get_ptr_name, NULL,
+			     "select distinct ptr from function_ptr where function = ?;",
+			     "s", name);
 	}
 
-	before = ptr_list_size((struct ptr_list *)ptr_names);
-
-	run_sql(get_ptr_name, NULL,
-		"select distinct ptr from function_ptr where %s",
-		sql_filter);
-
 	after = ptr_list_size((struct ptr_list *)ptr_names);
 	if (before == after)
 		return;
@@ -1335,13 +2021,12 @@ static void match_data_from_db(struct symbol *sym)
 	struct select_caller_info_data data = { .prev_func_id = -1 };
 	struct sm_state *sm;
 	struct stree *stree;
-	struct timeval end_time;
 
 	if (!sym || !sym->ident)
 		return;
 
 	set_fn_mtag(sym);
-	gettimeofday(&data.start_time, NULL);
+	data.start_work = work_units;
 
 	__push_fake_cur_stree();
 	__unnullify_path();
@@ -1377,10 +2062,10 @@ static void match_data_from_db(struct symbol *sym)
 		data.results = 0;
 
 		FOR_EACH_PTR(ptr_names, ptr) {
-			run_sql(caller_info_callback, &data,
-				"select call_id, type, parameter, key, value"
-				" from common_caller_info where function = '%s' order by call_id",
-				ptr);
+			run_sql_bind(caller_info_callback, &data,
+				     "select call_id, type, parameter, key, value"
+				     " from common_caller_info where function = ? order by call_id",
+				     "s", ptr);
 		} END_FOR_EACH_PTR(ptr);
 
 		if (data.results) {
@@ -1391,10 +2076,10 @@ static void match_data_from_db(struct symbol *sym)
 		}
 
 		FOR_EACH_PTR(ptr_names, ptr) {
-			run_sql(caller_info_callback, &data,
-				"select call_id, type, parameter, key, value"
-				" from caller_info where function = '%s' order by call_id",
-				ptr);
+			run_sql_bind(caller_info_callback, &data,
+				     "select call_id, type, parameter, key, value"
+				     " from caller_info where function = ? order by call_id",
+				     "s", ptr);
 			free_string(ptr);
 		} END_FOR_EACH_PTR(ptr);
 
@@ -1412,8 +2097,7 @@ free_ptr_names:
 		merge_stree(&data.final_states, stree);
 	free_stree(&stree);
 
-	gettimeofday(&end_time, NULL);
-	if (end_time.tv_sec - data.start_time.tv_sec <= 10) {
+	if (work_units - data.start_work <= 10 * WORK_PER_SECOND) {
 		FOR_EACH_SM(data.final_states, sm) {
 			__set_sm(sm);
 		} END_FOR_EACH_SM(sm);
@@ -1427,6 +2111,7 @@ static int return_implies_callbacks(void *_info, int argc, char **argv, char **a
 	struct implies_info *info = _info;
 	struct db_implies_callback *cb;
 	struct expression *arg = NULL;
+	struct profile_frame frame;
 	int type;
 	int param;
 
@@ -1444,7 +2129,11 @@ static int return_implies_callbacks(void *_info, int argc, char **argv, char **a
 			if (!arg)
 				continue;
 		}
+		if (option_profile)
+			profile_enter(&frame);
 		cb->callback(info->expr, arg, argv[3], argv[4]);
+		if (option_profile)
+			profile_db_callback(&frame, cb->owner);
 	} END_FOR_EACH_PTR(cb);
 
 	return 0;
@@ -1454,6 +2143,7 @@ static int call_implies_callbacks(void *_info, int argc, char **argv, char **azC
 {
 	struct implies_info *info = _info;
 	struct db_implies_callback *cb;
+	struct profile_frame frame;
 	struct expression *arg;
 	struct symbol *sym;
 	char *name;
@@ -1475,7 +2165,11 @@ static int call_implies_callbacks(void *_info, int argc, char **argv, char **azC
 	FOR_EACH_PTR(info->cb_list, cb) {
 		if (cb->type != type)
 			continue;
+		if (option_profile)
+			profile_enter(&frame);
 		cb->callback(info->expr, arg, argv[3], argv[4]);
+		if (option_profile)
+			profile_db_callback(&frame, cb->owner);
 	} END_FOR_EACH_PTR(cb);
 
 	return 0;
@@ -1734,7 +2428,7 @@ static void call_return_states_callbacks(const char *return_ranges, struct expre
 	if (handle_forced_split(return_ranges, expr))
 		return;
 
-	return_id++;
+	return_id += return_id_step;
 	FOR_EACH_PTR(returned_state_callbacks, cb) {
 		cb->callback(return_id, (char *)return_ranges, expr);
 	} END_FOR_EACH_PTR(cb);
@@ -2375,7 +3069,7 @@ vanilla:
 
 	nr_states = get_db_state_count();
 	if (nr_states >= 10000) {
-		return_id++;
+		return_id += return_id_step;
 		match_return_info(return_id, (char *)return_ranges, expr);
 		print_limited_param_set(return_id, (char *)return_ranges, expr);
 		mark_all_params_untracked(return_id, (char *)return_ranges, expr);
@@ -2489,50 +3183,46 @@ static void match_after_func(struct symbol *sym)
 		reset_memdb(sym);
 }
 
-static void init_memdb(void)
+static const char *memdb_schema_files[] = {
+	"db/db.schema",
+	"db/caller_info.schema",
+	"db/common_caller_info.schema",
+	"db/return_states.schema",
+	"db/function_type_size.schema",
+	"db/type_size.schema",
+	"db/function_type_info.schema",
+	"db/type_info.schema",
+	"db/call_implies.schema",
+	"db/return_implies.schema",
+	"db/function_ptr.schema",
+	"db/local_values.schema",
+	"db/function_type_value.schema",
+	"db/type_value.schema",
+	"db/function_type.schema",
+	"db/data_info.schema",
+	"db/parameter_name.schema",
+	"db/constraints.schema",
+	"db/constraints_required.schema",
+	"db/fn_ptr_data_link.schema",
+	"db/fn_data_link.schema",
+	"db/mtag_about.schema",
+	"db/mtag_info.schema",
+	"db/mtag_map.schema",
+	"db/mtag_data.schema",
+	"db/mtag_alias.schema",
+	"db/file_deps.schema",
+};
+
+static void load_schema_files(struct sqlite3 *db, const char **schema_files, int nr)
 {
-	char *err = NULL;
-	int rc;
-	const char *schema_files[] = {
-		"db/db.schema",
-		"db/caller_info.schema",
-		"db/common_caller_info.schema",
-		"db/return_states.schema",
-		"db/function_type_size.schema",
-		"db/type_size.schema",
-		"db/function_type_info.schema",
-		"db/type_info.schema",
-		"db/call_implies.schema",
-		"db/return_implies.schema",
-		"db/function_ptr.schema",
-		"db/local_values.schema",
-		"db/function_type_value.schema",
-		"db/type_value.schema",
-		"db/function_type.schema",
-		"db/data_info.schema",
-		"db/parameter_name.schema",
-		"db/constraints.schema",
-		"db/constraints_required.schema",
-		"db/fn_ptr_data_link.schema",
-		"db/fn_data_link.schema",
-		"db/mtag_about.schema",
-		"db/mtag_info.schema",
-		"db/mtag_map.schema",
-		"db/mtag_data.schema",
-		"db/mtag_alias.schema",
-	};
 	static char buf[4096];
+	char *err = NULL;
 	int fd;
 	int ret;
+	int rc;
 	int i;
 
-	rc = sqlite3_open(":memory:", &mem_db);
-	if (rc != SQLITE_OK) {
-		sm_ierror("starting In-Memory database.");
-		return;
-	}
-
-	for (i = 0; i < ARRAY_SIZE(schema_files); i++) {
+	for (i = 0; i < nr; i++) {
 		fd = open_schema_file(schema_files[i]);
 		if (fd < 0)
 			continue;
@@ -2548,7 +3238,7 @@ static void init_memdb(void)
 			continue;
 		}
 		buf[ret] = '\0';
-		rc = sqlite3_exec(mem_db, buf, NULL, NULL, &err);
+		rc = sqlite3_exec(db, buf, NULL, NULL, &err);
 		if (rc != SQLITE_OK) {
 			sm_ierror("SQL error #2: %s", err);
 			sm_ierror("%s", buf);
@@ -2556,9 +3246,21 @@ static void init_memdb(void)
 	}
 }
 
+static void init_memdb(void)
+{
+	int rc;
+
+	rc = sqlite3_open(":memory:", &mem_db);
+	if (rc != SQLITE_OK) {
+		sm_ierror("starting In-Memory database.");
+		return;
+	}
+
+	load_schema_files(mem_db, memdb_schema_files, ARRAY_SIZE(memdb_schema_files));
+}
+
 static void init_cachedb(void)
 {
-	char *err = NULL;
 	int rc;
 	const char *schema_files[] = {
 		"db/call_implies.schema",
@@ -2569,10 +3271,6 @@ static void init_cachedb(void)
 		"db/mtag_info.schema",
 		"db/sink_info.schema",
 	};
-	static char buf[4096];
-	int fd;
-	int ret;
-	int i;
 
 	rc = sqlite3_open(":memory:", &cache_db);
 	if (rc != SQLITE_OK) {
@@ -2580,39 +3278,171 @@ static void init_cachedb(void)
 		return;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(schema_files); i++) {
-		fd = open_schema_file(schema_files[i]);
-		if (fd < 0)
-			continue;
-		ret = read(fd, buf, sizeof(buf));
-		if (ret < 0) {
-			sm_ierror("failed to read: %s", schema_files[i]);
-			continue;
-		}
-		close(fd);
-		if (ret == sizeof(buf)) {
-			sm_ierror("Schema file too large:  %s (limit %zd bytes)",
-			       schema_files[i], sizeof(buf));
+	load_schema_files(cache_db, schema_files, ARRAY_SIZE(schema_files));
+}
+
+/*
+ * With --info-db each file gets its own small database, "file.c.smatch.db",
+ * instead of the SQL text in "file.c.smatch.sql" and ".caller_info".  The
+ * smatch_db_build program merges them into the real database.  The
+ * caller_info call_ids are numbered from 1 in each shard and the
+ * '%call_marker%' keys are left for smatch_db_build to deal with.
+ */
+static void forget_prepared_sql(struct sqlite3 *db)
+{
+	struct prepared_sql *prep;
+
+	FOR_EACH_PTR(prepared_list, prep) {
+		if (prep->db != db)
 			continue;
-		}
-		buf[ret] = '\0';
-		rc = sqlite3_exec(cache_db, buf, NULL, NULL, &err);
-		if (rc != SQLITE_OK) {
-			sm_ierror("SQL error #2: %s", err);
-			sm_ierror("%s", buf);
-		}
-	}
+		sqlite3_finalize(prep->stmt);
+		prep->stmt = NULL;
+		prep->db = NULL;
+	} END_FOR_EACH_PTR(prep);
 }
 
-static int save_cache_data(void *_table, int argc, char **argv, char **azColName)
+void close_info_db(void)
+{
+	if (!info_db)
+		return;
+
+	sql_exec(info_db, NULL, NULL, "commit;");
+	forget_prepared_sql(info_db);
+	sqlite3_close(info_db);
+	info_db = NULL;
+}
+
+void open_info_db(const char *filename)
+{
+	const char *schema_files[] = {
+		"db/sink_info.schema",
+	};
+
+	close_info_db();
+
+	free_string(info_db_file);
+	info_db_file = alloc_string(filename);
+	unlink(filename);
+	if (sqlite3_open(filename, &info_db) != SQLITE_OK)
+		sm_fatal("Error:  Cannot open %s", filename);
+
+	sql_exec(info_db, NULL, NULL, "PRAGMA journal_mode = OFF;");
+	sql_exec(info_db, NULL, NULL, "PRAGMA synchronous = OFF;");
+	load_schema_files(info_db, memdb_schema_files, ARRAY_SIZE(memdb_schema_files));
+	load_schema_files(info_db, schema_files, ARRAY_SIZE(schema_files));
+	sql_exec(info_db, NULL, NULL, "begin transaction;");
+	info_db_call_id = 0;
+}
+
+/*
+ * With --jobs each worker process writes to its own "file.c.smatch.db.N".
+ * The parent's handle was opened before the fork() so the worker leaves
+ * it alone.  The call_ids are offset so they stay unique after the merge.
+ */
+void open_worker_info_db(int worker)
+{
+	char buf[PATH_MAX];
+
+	if (!info_db)
+		return;
+
+	info_db = NULL;
+	snprintf(buf, sizeof(buf), "%s.%d", info_db_file, worker);
+	open_info_db(buf);
+	info_db_call_id = (unsigned long)(worker + 1) << 32;
+}
+
+static int get_table_name(void *_list, int argc, char **argv, char **azColName)
+{
+	struct string_list **list = _list;
+
+	insert_string(list, alloc_string(argv[0]));
+	return 0;
+}
+
+void merge_worker_info_db(int worker)
+{
+	struct string_list *tables = NULL;
+	char buf[PATH_MAX];
+	char sql[256];
+	char *table;
+
+	if (!info_db)
+		return;
+
+	/* attach and detach aren't allowed inside a transaction */
+	snprintf(buf, sizeof(buf), "%s.%d", info_db_file, worker);
+	sql_exec(info_db, NULL, NULL, "commit;");
+	sql_exec_bind(info_db, NULL, NULL, "attach ? as worker;", "s", buf);
+	sql_exec(info_db, get_table_name, &tables,
+		 "select name from worker.sqlite_master where type = 'table';");
+	sql_exec(info_db, NULL, NULL, "begin transaction;");
+	FOR_EACH_PTR(tables, table) {
+		snprintf(sql, sizeof(sql),
+			 "insert or ignore into main.%s select * from worker.%s;",
+			 table, table);
+		sql_exec(info_db, NULL, NULL, sql);
+		free_string(table);
+	} END_FOR_EACH_PTR(table);
+	free_ptr_list(&tables);
+	sql_exec(info_db, NULL, NULL, "commit;");
+	forget_prepared_sql(info_db);
+	sql_exec(info_db, NULL, NULL, "detach worker;");
+	sql_exec(info_db, NULL, NULL, "begin transaction;");
+	unlink(buf);
+}
+
+/* The rows are only saved on the final pass, the same as the --info text. */
+static struct sqlite3 *get_info_db(void)
+{
+	if (!info_db)
+		return NULL;
+	if (!final_pass && !option_debug && !local_debug && !debug_db)
+		return NULL;
+	return info_db;
+}
+
+void sql_insert_info_db(const char *table, int ignore, const char *fmt, ...)
+{
+	struct sqlite3 *db = get_info_db();
+	va_list args;
+	char *sql, *p;
+	int len;
+
+	if (!db)
+		return;
+
+	/* the callers use printf() formats, not the sqlite3_mprintf() ones */
+	va_start(args, fmt);
+	len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+
+	len += strlen(table) + 64;
+	sql = malloc(len);
+	p = sql;
+	p += snprintf(p, sql + len - p, "insert %sinto %s values (",
+		      ignore ? "or ignore " : "", table);
+	va_start(args, fmt);
+	p += vsnprintf(p, sql + len - p, fmt, args);
+	va_end(args);
+	snprintf(p, sql + len - p, ");");
+
+	sql_exec(db, NULL, NULL, sql);
+	free(sql);
+}
+
+static const char *cache_tables[] = {
+	"type_info", "return_implies", "call_implies", "mtag_data",
+	"mtag_info", "mtag_about", "sink_info",
+};
+
+static char *cache_row_sql(const char *table, int argc, char **argv)
 {
 	static char buf[4096];
 	char tmp[256];
 	char *p = buf;
-	char *table = _table;
 	int i;
 
-
 	p += snprintf(p, 4096 - (p - buf), "insert or ignore into %s values (", table);
 	for (i = 0; i < argc; i++) {
 		if (i)
@@ -2623,18 +3453,160 @@ static int save_cache_data(void *_table, int argc, char **argv, char **azColName
 	}
 	p += snprintf(p, 4096 - (p - buf), ");");
 	if (p - buf > 4096)
+		return NULL;
+	return buf;
+}
+
+static int save_cache_data(void *_table, int argc, char **argv, char **azColName)
+{
+	char *buf;
+
+	buf = cache_row_sql(_table, argc, argv);
+	if (!buf)
+		return 0;
+
+	if (info_db) {
+		sql_exec(get_info_db(), NULL, NULL, buf);
 		return 0;
+	}
 
 	sm_msg("SQL: %s", buf);
 	return 0;
 }
 
+/*
+ * The --jobs workers number their returns base + worker + 1, then
+ * + nr_workers each time, so the return_ids don't clash.  Afterwards the
+ * parent carries on from the highest one.
+ *
+ * The cache_db rows which a worker adds are passed back to the parent so
+ * dump_cache() has the whole file.  The sink_info rows are merged with the
+ * rows from the other slices so smatch_array_values.c does those.
+ */
+static long long worker_cache_rowid[ARRAY_SIZE(cache_tables)];
+
+static int get_max_rowid(void *_rowid, int argc, char **argv, char **azColName)
+{
+	long long *rowid = _rowid;
+
+	if (argc == 1 && argv[0])
+		*rowid = strtoll(argv[0], NULL, 10);
+	return 0;
+}
+
+void start_worker_db(int worker, int nr_workers)
+{
+	int i;
+
+	return_id += worker + 1 - nr_workers;
+	return_id_step = nr_workers;
+
+	for (i = 0; i < ARRAY_SIZE(cache_tables); i++)
+		cache_sql(&get_max_rowid, &worker_cache_rowid[i],
+			  "select max(rowid) from %s;", cache_tables[i]);
+}
+
+static void load_return_id(FILE *fp)
+{
+	int id;
+
+	load_worker_bytes(fp, &id, sizeof(id));
+	if (id > return_id)
+		return_id = id;
+}
+
+static void load_cache_row(FILE *fp)
+{
+	char *sql;
+
+	sql = load_worker_string(fp);
+	sql_exec(cache_db, NULL, NULL, sql);
+	free(sql);
+}
+
+static int save_worker_cache_row(void *_table, int argc, char **argv, char **azColName)
+{
+	char *sql;
+
+	sql = cache_row_sql(_table, argc, argv);
+	if (!sql)
+		return 0;
+	save_worker_data(&load_cache_row);
+	save_worker_string(sql);
+	return 0;
+}
+
+void save_worker_db(void)
+{
+	int i;
+
+	save_worker_data(&load_return_id);
+	save_worker_bytes(&return_id, sizeof(return_id));
+
+	for (i = 0; i < ARRAY_SIZE(cache_tables); i++) {
+		if (strcmp(cache_tables[i], "sink_info") == 0)
+			continue;
+		cache_sql(&save_worker_cache_row, (char *)cache_tables[i],
+			  "select * from %s where rowid > %lld;",
+			  cache_tables[i], worker_cache_rowid[i]);
+	}
+}
+
+static bool hash_file(const char *name, char *hex)
+{
+	unsigned char c[EVP_MAX_MD_SIZE];
+	EVP_MD_CTX *ctx;
+	char buf[65536];
+	int fd, len, i;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	/* update_kernel_data.sh checks these with "md5sum -c" */
+	ctx = EVP_MD_CTX_new();
+	EVP_DigestInit_ex(ctx, EVP_md5(), NULL);
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		EVP_DigestUpdate(ctx, buf, len);
+	EVP_DigestFinal_ex(ctx, c, NULL);
+	EVP_MD_CTX_free(ctx);
+	close(fd);
+	if (len < 0)
+		return false;
+
+	for (i = 0; i < MD5_DIGEST_LENGTH; i++)
+		sprintf(hex + i * 2, "%02x", c[i]);
+	return true;
+}
+
+/*
+ * Record the md5sum of every file that went into this translation unit so
+ * that update_db.sh can tell which files have to be checked again.  If
+ * there is more than one file on the command line then this lists the
+ * headers of the earlier files as well, which is harmless.
+ */
+static void save_file_deps(struct symbol_list *sym_list)
+{
+	char hex[MD5_DIGEST_LENGTH * 2 + 1];
+	const char *name;
+	int i;
+
+	if (!option_info)
+		return;
+
+	for (i = 0; i < input_stream_nr; i++) {
+		name = input_streams[i].name;
+		if (!name || name[0] == '<')
+			continue;
+		if (!hash_file(name, hex))
+			continue;
+		sql_insert_or_ignore(file_deps, "'%s', '%s', '%s'",
+				     get_base_file(), name, hex);
+	}
+}
+
 static void dump_cache(struct symbol_list *sym_list)
 {
-	const char *cache_tables[] = {
-		"type_info", "return_implies", "call_implies", "mtag_data",
-		"mtag_info", "mtag_about", "sink_info",
-	};
 	char buf[64];
 	int i;
 
@@ -2880,6 +3852,7 @@ void register_definition_db_callbacks(int id)
 	register_forced_return_splits();
 
 	add_hook(&dump_cache, END_FILE_HOOK);
+	add_hook(&save_file_deps, END_FILE_HOOK);
 }
 
 void register_db_call_marker(int id)
@@ -0,0 +1,41 @@
+#ifndef SMATCH_DB_BINARY_H
+#define SMATCH_DB_BINARY_H
+
+/*
+ * The format of the "file.c.smatch.sqlb" files written by --info-binary and
+ * read by smatch_db_build.  It is only meant to be read on the same machine
+ * so everything is in native byte order.
+ *
+ * The file is a list of records.  Each record is a 32bit length which
+ * doesn't include itself and a kind byte.  The files can be concatenated.
+ *
+ * SQLB_VERSION: SQLB_MAGIC.  This starts each file and resets the table ids.
+ * SQLB_TABLE:   u8 id, then the table name.  It defines the id used by the
+ *               rows after it.
+ * SQLB_SQL, SQLB_LATE, SQLB_CALLER_INFO:
+ *               u8 table id, u8 flags, u8 nr_fields, then the fields.  If
+ *               nr_fields is zero then the rest of the record is the text
+ *               which goes inside "values (...)".
+ *
+ * A field is a type byte followed by:
+ * 'd', 'l': an int64
+ * 'u':      an uint64
+ * 's':      an u32 length and the string with a terminating NUL
+ * 'c':      nothing.  This is the %CALL_ID% placeholder.
+ */
+
+#define SQLB_MAGIC "smatch-sqlb-1"
+
+enum sqlb_kind {
+	SQLB_VERSION,
+	SQLB_TABLE,
+	SQLB_SQL,
+	SQLB_LATE,
+	SQLB_CALLER_INFO,
+};
+
+#define SQLB_IGNORE 1
+
+#define SQLB_MAX_TABLES 256
+
+#endif
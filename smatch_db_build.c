@@ -0,0 +1,1450 @@
+/*
+ * Copyright (C) 2021 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * This replaces fill_db_sql.pl and fill_db_caller_info.pl.  It reads the
+ * smatch --info output once and loads the "SQL:", "SQL_late:" and
+ * "SQL_caller_info:" lines into the database.  It also reads the .sqlb files
+ * from --info-binary and merges the .db shards from --info-db.
+ *
+ * The input is read in chunks of lines.  The chunks are parsed by a pool
+ * of threads and then a single writer inserts them in the original order
+ * so the rowids come out the same as before.  Instead of running each line
+ * as a separate SQL statement, the "insert into table values (...)" lines
+ * are split up and the values are bound to a prepared insert.  Anything
+ * which doesn't look like a simple insert is passed to sqlite3_exec().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sqlite3.h>
+
+#include "smatch_db_binary.h"
+
+#define CHUNK_LINES 4096
+#define MAX_CHUNKS 64
+#define MAX_FIELDS 16
+#define TOO_COMMON 200
+
+enum line_kind {
+	LINE_SKIP,
+	LINE_CORRUPT,
+	LINE_SQL,
+	LINE_LATE,
+	LINE_CALLER_INFO,
+};
+
+enum field_type {
+	FIELD_TEXT,
+	FIELD_INT,
+	FIELD_FLOAT,
+	FIELD_NULL,
+	FIELD_CALL_ID,
+};
+
+struct field {
+	enum field_type type;
+	const char *str;
+	long long ival;
+	double fval;
+};
+
+struct parsed_line {
+	enum line_kind kind;
+	char *sql;		/* the original SQL */
+	char *buf;		/* the fields point into this copy */
+	char *stmt_key;		/* "insert [or ignore] into table [(cols)]" */
+	int nr_fields;		/* -1 means use sqlite3_exec() */
+	bool call_marker;
+	bool ignored;
+	struct field fields[MAX_FIELDS];
+};
+
+enum chunk_state {
+	CHUNK_FREE,
+	CHUNK_READ,
+	CHUNK_PARSING,
+	CHUNK_PARSED,
+};
+
+struct chunk {
+	enum chunk_state state;
+	unsigned long seq;
+	int nr;
+	char *lines[CHUNK_LINES];
+	const char *tables[CHUNK_LINES];	/* set for --info-binary records */
+	int lens[CHUNK_LINES];
+	struct parsed_line parsed[CHUNK_LINES];
+};
+
+static struct chunk chunks[MAX_CHUNKS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static bool reading_done;
+
+static sqlite3 *db;
+static unsigned long call_id;
+static unsigned long rows, errors;
+
+struct prepared {
+	char *key;
+	int nr_fields;
+	sqlite3_stmt *stmt;
+	struct prepared *next;
+};
+static struct prepared *prepared_list;
+
+struct common_func {
+	char *name;
+	int count;
+	struct common_func *next;
+};
+#define COMMON_HASH 4096
+static struct common_func *common_hash[COMMON_HASH];
+
+static char **late_sql;
+static int late_nr, late_alloced;
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage:  %s [-j <threads>] [--update] [--common-functions=<file>] [--files-from=<file>] <db_file> <smatch_warns.txt, .sqlb or .db>...\n", name);
+	fprintf(stderr, "        %s --changed=<file> <db_file>\n", name);
+	exit(1);
+}
+
+static char *skip_spaces(char *p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+static char *match_word(char *p, const char *word)
+{
+	int len = strlen(word);
+
+	p = skip_spaces(p);
+	if (strncasecmp(p, word, len) != 0)
+		return NULL;
+	if (p[len] != ' ' && p[len] != '\t' && p[len] != '(')
+		return NULL;
+	return p + len;
+}
+
+/*
+ * Parse a quoted SQL string in place.  Doubled quotes are turned back
+ * into single quotes.
+ */
+static char *parse_quoted(char *p, struct field *field)
+{
+	char *out;
+
+	p++;
+	out = p;
+	field->type = FIELD_TEXT;
+	field->str = out;
+	while (*p) {
+		if (*p == '\'') {
+			if (p[1] != '\'') {
+				*out = '\0';
+				return p + 1;
+			}
+			p++;
+		}
+		*out++ = *p++;
+	}
+	return NULL;
+}
+
+static char *parse_bare(char *p, struct field *field)
+{
+	char *start = p;
+	char *end;
+	char save;
+
+	while (*p && *p != ',' && *p != ')' && *p != ' ')
+		p++;
+	if (p == start)
+		return NULL;
+	save = *p;
+	*p = '\0';
+
+	if (strcmp(start, "%CALL_ID%") == 0) {
+		field->type = FIELD_CALL_ID;
+	} else if (strcasecmp(start, "NULL") == 0) {
+		field->type = FIELD_NULL;
+	} else {
+		errno = 0;
+		field->type = FIELD_INT;
+		field->ival = strtoll(start, &end, 10);
+		if (errno == ERANGE || *end != '\0') {
+			/* This is what SQLite does with huge integers */
+			field->type = FIELD_FLOAT;
+			field->fval = strtod(start, &end);
+			if (*end != '\0') {
+				*p = save;
+				return NULL;
+			}
+		}
+	}
+	*p = save;
+	return p;
+}
+
+/*
+ * Split up "insert [or ignore] into table [(cols)] values (a, 'b', ...);".
+ * Returns false if the SQL is anything more complicated.
+ */
+static bool parse_insert(struct parsed_line *line)
+{
+	char *sql, *p, *key_end;
+	struct field *field;
+
+	line->nr_fields = -1;
+
+	sql = strdup(line->sql);
+	p = match_word(sql, "insert");
+	if (!p)
+		goto fail;
+	if (match_word(p, "or")) {
+		p = match_word(p, "or");
+		p = match_word(p, "ignore");
+		if (!p)
+			goto fail;
+	}
+	p = match_word(p, "into");
+	if (!p)
+		goto fail;
+	p = skip_spaces(p);
+	while (*p && *p != ' ' && *p != '(')
+		p++;
+	p = skip_spaces(p);
+	if (*p == '(') {
+		p = strchr(p, ')');
+		if (!p)
+			goto fail;
+		p++;
+	}
+	key_end = p;
+	p = match_word(p, "values");
+	if (!p)
+		goto fail;
+	p = skip_spaces(p);
+	if (*p != '(')
+		goto fail;
+	p++;
+
+	line->nr_fields = 0;
+	while (1) {
+		if (line->nr_fields == MAX_FIELDS)
+			goto fail;
+		field = &line->fields[line->nr_fields++];
+
+		p = skip_spaces(p);
+		if (*p == '\'')
+			p = parse_quoted(p, field);
+		else
+			p = parse_bare(p, field);
+		if (!p)
+			goto fail;
+		p = skip_spaces(p);
+		if (*p == ')')
+			break;
+		if (*p != ',')
+			goto fail;
+		p++;
+	}
+	p = skip_spaces(p + 1);
+	if (*p == ';')
+		p = skip_spaces(p + 1);
+	if (*p != '\0' && *p != '\n')
+		goto fail;
+
+	line->stmt_key = strndup(sql, key_end - sql);
+	line->buf = sql;
+	return true;
+
+fail:
+	line->nr_fields = -1;
+	free(sql);
+	return false;
+}
+
+static const char *func_field(struct parsed_line *line)
+{
+	if (line->nr_fields < 3 || line->fields[2].type != FIELD_TEXT)
+		return NULL;
+	return line->fields[2].str;
+}
+
+static const char *ignored_funcs[] = {
+	"printk", "memset", "memcpy", "kfree", "printf", "dev_err", "writel",
+};
+
+static bool ignored_caller_info_func(const char *fn)
+{
+	int i;
+
+	if (strstr(fn, "__builtin_"))
+		return true;
+	for (i = 0; i < sizeof(ignored_funcs) / sizeof(ignored_funcs[0]); i++) {
+		if (strcmp(fn, ignored_funcs[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+static void check_caller_info(struct parsed_line *line);
+
+static void parse_line(char *buf, struct parsed_line *line)
+{
+	static const struct {
+		const char *marker;
+		enum line_kind kind;
+	} markers[] = {
+		{ "() SQL: ", LINE_SQL },
+		{ "() SQL_late: ", LINE_LATE },
+		{ "() SQL_caller_info: ", LINE_CALLER_INFO },
+	};
+	char *p = NULL;
+	int i;
+
+	memset(line, 0, sizeof(*line));
+	line->kind = LINE_SKIP;
+
+	for (i = 0; i < sizeof(markers) / sizeof(markers[0]); i++) {
+		p = strstr(buf, markers[i].marker);
+		if (p) {
+			line->kind = markers[i].kind;
+			p += strlen(markers[i].marker);
+			break;
+		}
+	}
+	if (line->kind == LINE_SKIP)
+		return;
+
+	p[strcspn(p, "\n")] = '\0';
+	line->sql = strdup(p);
+	parse_insert(line);
+	check_caller_info(line);
+}
+
+static char *parse_record_field(char *p, char *end, struct field *field)
+{
+	unsigned long long uval;
+	unsigned int len;
+
+	if (p >= end)
+		return NULL;
+	switch (*p++) {
+	case 'd':
+	case 'l':
+		if (end - p < sizeof(field->ival))
+			return NULL;
+		field->type = FIELD_INT;
+		memcpy(&field->ival, p, sizeof(field->ival));
+		return p + sizeof(field->ival);
+	case 'u':
+		if (end - p < sizeof(uval))
+			return NULL;
+		memcpy(&uval, p, sizeof(uval));
+		/* This is what SQLite does with huge integers */
+		if (uval > __LONG_LONG_MAX__) {
+			field->type = FIELD_FLOAT;
+			field->fval = uval;
+		} else {
+			field->type = FIELD_INT;
+			field->ival = uval;
+		}
+		return p + sizeof(uval);
+	case 's':
+		if (end - p < sizeof(len))
+			return NULL;
+		memcpy(&len, p, sizeof(len));
+		p += sizeof(len);
+		if (end - p < len + 1 || p[len] != '\0')
+			return NULL;
+		field->type = FIELD_TEXT;
+		field->str = p;
+		return p + len + 1;
+	case 'c':
+		field->type = FIELD_CALL_ID;
+		return p;
+	}
+	return NULL;
+}
+
+/*
+ * Parse a record from a .sqlb file.  See smatch_db_binary.h.  The fields
+ * point into the record itself.
+ */
+static void parse_record(char *rec, int len, const char *table, struct parsed_line *line)
+{
+	char *p, *end = rec + len;
+	char key[256];
+	int nr, i;
+
+	memset(line, 0, sizeof(*line));
+	switch (rec[0]) {
+	case SQLB_SQL:
+		line->kind = LINE_SQL;
+		break;
+	case SQLB_LATE:
+		line->kind = LINE_LATE;
+		break;
+	case SQLB_CALLER_INFO:
+		line->kind = LINE_CALLER_INFO;
+		break;
+	default:
+		goto corrupt;
+	}
+	if (len < 4)
+		goto corrupt;
+
+	snprintf(key, sizeof(key), "insert %sinto %s",
+		 (rec[2] & SQLB_IGNORE) ? "or ignore " : "", table);
+	nr = (unsigned char)rec[3];
+	p = rec + 4;
+
+	if (nr == 0) {
+		/* the record is NUL terminated when it's read */
+		line->sql = malloc(strlen(key) + strlen(p) + 16);
+		sprintf(line->sql, "%s values (%s);", key, p);
+		parse_insert(line);
+		check_caller_info(line);
+		return;
+	}
+
+	line->sql = strdup(key);
+	line->stmt_key = strdup(key);
+	line->nr_fields = nr;
+	if (nr > MAX_FIELDS)
+		goto corrupt;
+	for (i = 0; i < nr; i++) {
+		p = parse_record_field(p, end, &line->fields[i]);
+		if (!p)
+			goto corrupt;
+	}
+	check_caller_info(line);
+	return;
+
+corrupt:
+	fprintf(stderr, "corrupt record for %s\n", table);
+	line->kind = LINE_CORRUPT;
+}
+
+static void check_caller_info(struct parsed_line *line)
+{
+	struct field *key;
+	const char *fn;
+
+	if (line->kind != LINE_CALLER_INFO)
+		return;
+
+	fn = func_field(line);
+	if (fn && ignored_caller_info_func(fn))
+		line->ignored = true;
+
+	/* don't need this taking space in the db. */
+	key = line->nr_fields >= 8 ? &line->fields[7] : NULL;
+	if (key && key->type == FIELD_TEXT && strstr(key->str, "%call_marker%")) {
+		line->call_marker = true;
+		key->str = "";
+	}
+}
+
+static void parse_chunk(struct chunk *chunk)
+{
+	int i;
+
+	for (i = 0; i < chunk->nr; i++) {
+		if (chunk->tables[i])
+			parse_record(chunk->lines[i], chunk->lens[i], chunk->tables[i],
+				     &chunk->parsed[i]);
+		else
+			parse_line(chunk->lines[i], &chunk->parsed[i]);
+	}
+}
+
+static void *parse_thread(void *unused)
+{
+	struct chunk *chunk;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	while (1) {
+		chunk = NULL;
+		for (i = 0; i < MAX_CHUNKS; i++) {
+			if (chunks[i].state == CHUNK_READ &&
+			    (!chunk || chunks[i].seq < chunk->seq))
+				chunk = &chunks[i];
+		}
+		if (!chunk) {
+			if (reading_done)
+				break;
+			pthread_cond_wait(&cond, &lock);
+			continue;
+		}
+		chunk->state = CHUNK_PARSING;
+		pthread_mutex_unlock(&lock);
+
+		parse_chunk(chunk);
+
+		pthread_mutex_lock(&lock);
+		chunk->state = CHUNK_PARSED;
+		pthread_cond_broadcast(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+static void exec_sql(const char *sql)
+{
+	char *err = NULL;
+
+	if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+		fprintf(stderr, "SQL error: %s\nSQL: %s\n", err, sql);
+		sqlite3_free(err);
+		errors++;
+	}
+}
+
+static sqlite3_stmt *get_stmt(const char *key, int nr_fields)
+{
+	struct prepared *prep;
+	char sql[1024];
+	char *p = sql;
+	int i;
+
+	for (prep = prepared_list; prep; prep = prep->next) {
+		if (prep->nr_fields == nr_fields && strcmp(prep->key, key) == 0)
+			return prep->stmt;
+	}
+
+	p += snprintf(p, sizeof(sql), "%s values (", key);
+	for (i = 0; i < nr_fields; i++)
+		p += snprintf(p, sql + sizeof(sql) - p, "%s?", i ? ", " : "");
+	snprintf(p, sql + sizeof(sql) - p, ");");
+
+	prep = calloc(1, sizeof(*prep));
+	prep->key = strdup(key);
+	prep->nr_fields = nr_fields;
+	if (sqlite3_prepare_v2(db, sql, -1, &prep->stmt, NULL) != SQLITE_OK)
+		prep->stmt = NULL;
+	prep->next = prepared_list;
+	prepared_list = prep;
+	return prep->stmt;
+}
+
+static void insert_line(struct parsed_line *line)
+{
+	sqlite3_stmt *stmt;
+	struct field *field;
+	int i;
+
+	if (line->nr_fields < 0)
+		goto exec;
+	stmt = get_stmt(line->stmt_key, line->nr_fields);
+	if (!stmt)
+		goto exec;
+
+	for (i = 0; i < line->nr_fields; i++) {
+		field = &line->fields[i];
+		switch (field->type) {
+		case FIELD_TEXT:
+			sqlite3_bind_text(stmt, i + 1, field->str, -1, SQLITE_STATIC);
+			break;
+		case FIELD_INT:
+			sqlite3_bind_int64(stmt, i + 1, field->ival);
+			break;
+		case FIELD_FLOAT:
+			sqlite3_bind_double(stmt, i + 1, field->fval);
+			break;
+		case FIELD_NULL:
+			sqlite3_bind_null(stmt, i + 1);
+			break;
+		case FIELD_CALL_ID:
+			sqlite3_bind_int64(stmt, i + 1, call_id);
+			break;
+		}
+	}
+	if (sqlite3_step(stmt) != SQLITE_DONE) {
+		fprintf(stderr, "SQL error: %s\nSQL: %s\n", sqlite3_errmsg(db), line->sql);
+		errors++;
+	}
+	sqlite3_reset(stmt);
+	return;
+
+exec:
+	if (line->kind == LINE_CALLER_INFO) {
+		/* The fallback path needs the %CALL_ID% replaced by hand. */
+		char buf[4096];
+		char *p = strstr(line->sql, "%CALL_ID%");
+
+		if (p) {
+			snprintf(buf, sizeof(buf), "%.*s%lu%s", (int)(p - line->sql),
+				 line->sql, call_id, p + strlen("%CALL_ID%"));
+			exec_sql(buf);
+			return;
+		}
+	}
+	exec_sql(line->sql);
+}
+
+static unsigned int hash_str(const char *str)
+{
+	unsigned int hash = 5381;
+
+	while (*str)
+		hash = hash * 33 + *str++;
+	return hash;
+}
+
+static void count_call_marker(const char *fn, int count)
+{
+	struct common_func *tmp;
+	unsigned int hash = hash_str(fn) % COMMON_HASH;
+
+	for (tmp = common_hash[hash]; tmp; tmp = tmp->next) {
+		if (strcmp(tmp->name, fn) == 0) {
+			tmp->count += count;
+			return;
+		}
+	}
+	tmp = calloc(1, sizeof(*tmp));
+	tmp->name = strdup(fn);
+	tmp->count = count;
+	tmp->next = common_hash[hash];
+	common_hash[hash] = tmp;
+}
+
+static void write_line(struct parsed_line *line)
+{
+	const char *fn;
+
+	switch (line->kind) {
+	case LINE_SKIP:
+		return;
+	case LINE_CORRUPT:
+		errors++;
+		return;
+	case LINE_LATE:
+		if (late_nr == late_alloced) {
+			late_alloced = late_alloced ? late_alloced * 2 : 64;
+			late_sql = realloc(late_sql, late_alloced * sizeof(*late_sql));
+		}
+		late_sql[late_nr++] = line->sql;
+		line->sql = NULL;
+		return;
+	case LINE_CALLER_INFO:
+		if (line->call_marker) {
+			if (!line->ignored)
+				call_id++;
+			fn = func_field(line);
+			if (fn)
+				count_call_marker(fn, 1);
+		}
+		if (line->ignored)
+			return;
+		break;
+	case LINE_SQL:
+		break;
+	}
+
+	insert_line(line);
+	rows++;
+}
+
+static void write_chunk(struct chunk *chunk)
+{
+	struct parsed_line *line;
+	int i;
+
+	for (i = 0; i < chunk->nr; i++) {
+		line = &chunk->parsed[i];
+		write_line(line);
+		free(line->sql);
+		free(line->buf);
+		free(line->stmt_key);
+		free(chunk->lines[i]);
+	}
+	chunk->nr = 0;
+}
+
+/*
+ * Write all the parsed chunks which are next in line.  With "wait" set,
+ * wait until everything up to "until" has been written.
+ */
+static void write_chunks(unsigned long *next_seq, unsigned long until, bool wait)
+{
+	struct chunk *chunk;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	while (*next_seq < until) {
+		chunk = NULL;
+		for (i = 0; i < MAX_CHUNKS; i++) {
+			if (chunks[i].state != CHUNK_FREE && chunks[i].seq == *next_seq) {
+				chunk = &chunks[i];
+				break;
+			}
+		}
+		if (!chunk || chunk->state != CHUNK_PARSED) {
+			if (!wait)
+				break;
+			pthread_cond_wait(&cond, &lock);
+			continue;
+		}
+		pthread_mutex_unlock(&lock);
+		write_chunk(chunk);
+		pthread_mutex_lock(&lock);
+		chunk->state = CHUNK_FREE;
+		(*next_seq)++;
+		pthread_cond_broadcast(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+static struct chunk *get_free_chunk(unsigned long *next_seq, unsigned long seq)
+{
+	int i;
+
+	while (1) {
+		pthread_mutex_lock(&lock);
+		for (i = 0; i < MAX_CHUNKS; i++) {
+			if (chunks[i].state == CHUNK_FREE) {
+				chunks[i].seq = seq;
+				pthread_mutex_unlock(&lock);
+				return &chunks[i];
+			}
+		}
+		pthread_mutex_unlock(&lock);
+		/* all full, so the writer needs to catch up */
+		write_chunks(next_seq, *next_seq + 1, true);
+	}
+}
+
+static void queue_chunk(struct chunk *chunk)
+{
+	pthread_mutex_lock(&lock);
+	chunk->state = CHUNK_READ;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+static unsigned long read_seq, write_seq;
+static struct chunk *cur_chunk;
+
+static void add_line(char *line, int len, const char *table)
+{
+	if (!cur_chunk)
+		cur_chunk = get_free_chunk(&write_seq, read_seq++);
+	cur_chunk->lines[cur_chunk->nr] = line;
+	cur_chunk->lens[cur_chunk->nr] = len;
+	cur_chunk->tables[cur_chunk->nr] = table;
+	cur_chunk->nr++;
+	if (cur_chunk->nr == CHUNK_LINES) {
+		queue_chunk(cur_chunk);
+		cur_chunk = NULL;
+		write_chunks(&write_seq, read_seq, false);
+	}
+}
+
+static void read_text_file(FILE *fp)
+{
+	char *buf = NULL;
+	size_t size = 0;
+
+	while (getline(&buf, &size, fp) >= 0) {
+		/* cheap filter so the threads only see the SQL lines */
+		if (!strstr(buf, "() SQL"))
+			continue;
+		add_line(strdup(buf), 0, NULL);
+	}
+	free(buf);
+}
+
+static const char *intern_table(const char *name)
+{
+	static char *names[SQLB_MAX_TABLES * 4];
+	static int nr;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (strcmp(names[i], name) == 0)
+			return names[i];
+	}
+	if (nr == sizeof(names) / sizeof(names[0]))
+		return NULL;
+	names[nr] = strdup(name);
+	return names[nr++];
+}
+
+static void read_binary_file(const char *filename, FILE *fp)
+{
+	const char *tables[SQLB_MAX_TABLES] = {};
+	unsigned int len;
+	char *rec;
+
+	while (fread(&len, sizeof(len), 1, fp) == 1) {
+		rec = malloc(len + 1);
+		if (len < 2 || fread(rec, 1, len, fp) != len) {
+			fprintf(stderr, "%s: truncated record\n", filename);
+			errors++;
+			free(rec);
+			return;
+		}
+		rec[len] = '\0';
+
+		switch (rec[0]) {
+		case SQLB_VERSION:
+			memset(tables, 0, sizeof(tables));
+			free(rec);
+			break;
+		case SQLB_TABLE:
+			tables[(unsigned char)rec[1]] = intern_table(rec + 2);
+			free(rec);
+			break;
+		default:
+			if (!tables[(unsigned char)rec[1]]) {
+				fprintf(stderr, "%s: unknown table id\n", filename);
+				errors++;
+				free(rec);
+				break;
+			}
+			add_line(rec, len, tables[(unsigned char)rec[1]]);
+			break;
+		}
+	}
+}
+
+static bool is_binary_file(FILE *fp)
+{
+	char buf[sizeof(unsigned int) + 1 + sizeof(SQLB_MAGIC) - 1];
+	bool ret = false;
+
+	if (fread(buf, sizeof(buf), 1, fp) == 1 &&
+	    buf[sizeof(unsigned int)] == SQLB_VERSION &&
+	    memcmp(buf + sizeof(unsigned int) + 1, SQLB_MAGIC, sizeof(SQLB_MAGIC) - 1) == 0)
+		ret = true;
+	rewind(fp);
+	return ret;
+}
+
+static void flush_chunks(void)
+{
+	if (cur_chunk) {
+		queue_chunk(cur_chunk);
+		cur_chunk = NULL;
+	}
+	write_chunks(&write_seq, read_seq, true);
+}
+
+static bool is_sqlite_file(FILE *fp)
+{
+	char buf[16];
+	bool ret = false;
+
+	if (fread(buf, sizeof(buf), 1, fp) == 1 &&
+	    memcmp(buf, "SQLite format 3", sizeof(buf)) == 0)
+		ret = true;
+	rewind(fp);
+	return ret;
+}
+
+static void merge_sql(const char *sql)
+{
+	exec_sql(sql);
+	rows += sqlite3_changes(db);
+}
+
+static long long select_int(const char *sql)
+{
+	sqlite3_stmt *stmt;
+	long long ret = 0;
+
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK &&
+	    sqlite3_step(stmt) == SQLITE_ROW)
+		ret = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+	return ret;
+}
+
+static int get_tables(const char *schema, char **tables, int max)
+{
+	sqlite3_stmt *stmt;
+	const char *name;
+	char *sql;
+	int nr = 0;
+
+	sql = sqlite3_mprintf("select name from %s.sqlite_master where type = 'table';", schema);
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+		while (sqlite3_step(stmt) == SQLITE_ROW && nr < max) {
+			name = (const char *)sqlite3_column_text(stmt, 0);
+			if (strncmp(name, "sqlite_", 7) == 0)
+				continue;
+			tables[nr++] = strdup(name);
+		}
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_free(sql);
+	return nr;
+}
+
+static bool has_file_column(const char *schema, const char *table)
+{
+	char *sql;
+	bool ret;
+
+	sql = sqlite3_mprintf("select count(*) from %s.pragma_table_info(%Q) where name = 'file';",
+			      schema, table);
+	ret = select_int(sql);
+	sqlite3_free(sql);
+	return ret;
+}
+
+/*
+ * The call_ids in a shard start from 1 so they are moved up past the ones
+ * we have already used.  The '%call_marker%' keys are counted for the
+ * "too common" list and then dropped, the same as for the text input.
+ */
+static void merge_caller_info(const char *filter)
+{
+	char not_in[256];
+	sqlite3_stmt *stmt;
+	unsigned long max_id;
+	char *sql, *p = not_in;
+	int i;
+
+	if (sqlite3_prepare_v2(db, "select function, count(*) from shard.caller_info "
+			       "where key = '%call_marker%' group by function;",
+			       -1, &stmt, NULL) == SQLITE_OK) {
+		while (sqlite3_step(stmt) == SQLITE_ROW)
+			count_call_marker((const char *)sqlite3_column_text(stmt, 0),
+					  sqlite3_column_int(stmt, 1));
+	}
+	sqlite3_finalize(stmt);
+
+	max_id = select_int("select max(call_id) from shard.caller_info;");
+
+	for (i = 0; i < sizeof(ignored_funcs) / sizeof(ignored_funcs[0]); i++)
+		p += snprintf(p, not_in + sizeof(not_in) - p, "%s'%s'",
+			      i ? ", " : "", ignored_funcs[i]);
+
+	sql = sqlite3_mprintf("insert into main.caller_info select file, caller, function, "
+			      "call_id + %lu, static, type, parameter, "
+			      "case when key = '%%call_marker%%' then '' else key end, value "
+			      "from shard.caller_info where instr(function, '__builtin_') = 0 "
+			      "and function not in (%s) %s%s order by rowid;",
+			      call_id, not_in, filter[0] ? "and " : "", filter);
+	merge_sql(sql);
+	sqlite3_free(sql);
+
+	call_id += max_id;
+}
+
+/*
+ * With --update the database already holds the rows from an earlier run.
+ * A translation unit's rows are the ones where "file" is in its file_deps
+ * and those are only replaced if the shard was written after the database.
+ * The other rows, which can't be tied to a single translation unit, are
+ * deleted up front and copied from every shard again.  The constraints
+ * are kept because the rows refer to them by id.
+ *
+ * The files whose rows were replaced are listed in update_files with
+ * fixed = 0 and their old rows are saved in update_old_return_states and
+ * update_old_caller_info.  The fixup scripts use update_files to leave the
+ * rows which they have already fixed alone.  The tables are kept until
+ * --changed has compared the fixed new rows with the old ones.
+ */
+static bool update_mode;
+static struct timespec db_mtime;
+static const char *changed_file;
+
+static bool is_update_table(const char *table)
+{
+	return strncmp(table, "update_", 7) == 0;
+}
+
+static bool keep_table(const char *table)
+{
+	return strcmp(table, "file_deps") == 0 ||
+	       strcmp(table, "constraints") == 0 ||
+	       is_update_table(table);
+}
+
+/*
+ * If the last update didn't get as far as --changed then the tables are
+ * still there and the old rows from before that update are kept.
+ */
+static void save_old_rows(const char *files)
+{
+	char *sql;
+
+	sql = sqlite3_mprintf("insert into main.update_old_return_states select * from main.return_states "
+			      "where file in (%s) and file not in (select file from main.update_files);", files);
+	exec_sql(sql);
+	sqlite3_free(sql);
+	sql = sqlite3_mprintf("insert into main.update_old_caller_info select * from main.caller_info "
+			      "where file in (%s) and file not in (select file from main.update_files);", files);
+	exec_sql(sql);
+	sqlite3_free(sql);
+	sql = sqlite3_mprintf("insert or replace into main.update_files select distinct file, 0 from (%s);", files);
+	exec_sql(sql);
+	sqlite3_free(sql);
+}
+
+static void begin_update(void)
+{
+	char *tables[SQLB_MAX_TABLES];
+	int nr_tables, i;
+	char *sql;
+
+	call_id = select_int("select max(call_id) from caller_info;");
+
+	nr_tables = get_tables("main", tables, SQLB_MAX_TABLES);
+	for (i = 0; i < nr_tables; i++) {
+		sql = NULL;
+		if (keep_table(tables[i]))
+			;
+		else if (has_file_column("main", tables[i]))
+			sql = sqlite3_mprintf("delete from \"%w\" where file not in "
+					      "(select file from file_deps);", tables[i]);
+		else
+			sql = sqlite3_mprintf("delete from \"%w\";", tables[i]);
+		if (sql)
+			exec_sql(sql);
+		sqlite3_free(sql);
+		free(tables[i]);
+	}
+
+	exec_sql("create temp table seen_files (file varchar(128) primary key);");
+	exec_sql("create table if not exists update_files (file varchar(128) primary key, fixed boolean);");
+	exec_sql("create table if not exists update_old_return_states as select * from main.return_states where 0;");
+	exec_sql("create table if not exists update_old_caller_info as select * from main.caller_info where 0;");
+}
+
+/*
+ * The rows which describe a function, leaving out the call_id which is
+ * different every time.
+ */
+#define RETURN_STATES_COLS "file, function, return_id, return, static, type, parameter, key, value"
+#define CALLER_INFO_COLS "file, caller, function, static, type, parameter, key, value"
+
+static void add_changed_funcs(const char *kind, const char *table, const char *cols)
+{
+	const char *new_rows = "from main.%s where file in (select file from main.update_files)";
+	char *sql, *fmt;
+	int i;
+
+	/* old rows which are gone and then new rows which weren't there */
+	for (i = 0; i < 2; i++) {
+		fmt = sqlite3_mprintf("insert into temp.changed_funcs select distinct '%%s', file, function, static from ("
+				      "select %%s %s except select %%s %s);",
+				      i ? new_rows : "from main.update_old_%s",
+				      i ? "from main.update_old_%s" : new_rows);
+		sql = sqlite3_mprintf(fmt, kind, cols, table, cols, table);
+		exec_sql(sql);
+		sqlite3_free(sql);
+		sqlite3_free(fmt);
+	}
+}
+
+/*
+ * Write the list of files which have to be checked again because what
+ * they know about another file's functions is out of date.  If the
+ * return_states of a function changed then the callers have to be checked
+ * again.  If the caller_info changed then the file which has the function.
+ * When this list is empty the database has reached a fixed point.
+ *
+ * The old rows went through the fixup scripts so this has to run after the
+ * fixups have been applied to the new rows as well.
+ */
+static void write_rerun_files(const char *filename)
+{
+	sqlite3_stmt *stmt;
+	int nr_funcs = 0, nr_files = 0;
+	FILE *f;
+
+	f = fopen(filename, "w");
+	if (!f) {
+		fprintf(stderr, "cannot write %s: %s\n", filename, strerror(errno));
+		errors++;
+		return;
+	}
+
+	if (!select_int("select count(*) from sqlite_master where name = 'update_files';")) {
+		fclose(f);
+		fprintf(stderr, "no update to compare.  0 files to check again.\n");
+		return;
+	}
+
+	exec_sql("create temp table changed_funcs (kind varchar(1), file varchar(128), function varchar(64), static boolean);");
+	add_changed_funcs("r", "return_states", RETURN_STATES_COLS);
+	add_changed_funcs("c", "caller_info", CALLER_INFO_COLS);
+
+	if (sqlite3_prepare_v2(db,
+			"select distinct c.file from main.caller_info c join temp.changed_funcs f "
+			"on c.function = f.function where f.kind = 'r' and (f.static = 0 or c.file = f.file) "
+			"and c.file in (select file from main.file_deps) "
+			"union "
+			"select distinct r.file from main.return_states r join temp.changed_funcs f "
+			"on r.function = f.function where f.kind = 'c' and (f.static = 0 or r.file = f.file) "
+			"and r.file in (select file from main.file_deps) "
+			"order by 1;", -1, &stmt, NULL) == SQLITE_OK) {
+		while (sqlite3_step(stmt) == SQLITE_ROW) {
+			fprintf(f, "%s\n", sqlite3_column_text(stmt, 0));
+			nr_files++;
+		}
+	} else {
+		fprintf(stderr, "SQL error: %s\n", sqlite3_errmsg(db));
+	}
+	sqlite3_finalize(stmt);
+	fclose(f);
+
+	nr_funcs = select_int("select count(*) from (select distinct file, function from temp.changed_funcs);");
+	fprintf(stderr, "%d changed functions.  %d files to check again.\n", nr_funcs, nr_files);
+
+	exec_sql("drop table update_old_return_states;");
+	exec_sql("drop table update_old_caller_info;");
+	exec_sql("drop table update_files;");
+}
+
+/* The files which don't have a shard any more have been deleted. */
+static void finish_update(void)
+{
+	char *tables[SQLB_MAX_TABLES];
+	int nr_tables, i;
+	char *sql;
+
+	save_old_rows("select file from file_deps where file not in (select file from temp.seen_files)");
+
+	nr_tables = get_tables("main", tables, SQLB_MAX_TABLES);
+	/* file_deps is needed until the end */
+	tables[nr_tables++] = strdup("file_deps");
+	for (i = 0; i < nr_tables; i++) {
+		if ((i < nr_tables - 1 && strcmp(tables[i], "file_deps") == 0) ||
+		    is_update_table(tables[i]) ||
+		    !has_file_column("main", tables[i])) {
+			free(tables[i]);
+			continue;
+		}
+		sql = sqlite3_mprintf("delete from \"%w\" where file in (select file from file_deps "
+				      "where file not in (select file from temp.seen_files));",
+				      tables[i]);
+		exec_sql(sql);
+		sqlite3_free(sql);
+		free(tables[i]);
+	}
+}
+
+static bool shard_is_newer(const char *filename)
+{
+	struct stat st;
+
+	if (stat(filename, &st) != 0)
+		return true;
+	if (st.st_mtim.tv_sec != db_mtime.tv_sec)
+		return st.st_mtim.tv_sec > db_mtime.tv_sec;
+	return st.st_mtim.tv_nsec > db_mtime.tv_nsec;
+}
+
+/*
+ * A shard is a database written by "smatch --info-db".  It has the same
+ * tables as the real database so they are copied across with
+ * "insert ... select".
+ */
+static void merge_shard(const char *filename)
+{
+	const char *tu = "file in (select file from shard.file_deps)";
+	char *tables[SQLB_MAX_TABLES];
+	bool has_deps, changed = true;
+	const char *filter;
+	int nr_tables;
+	bool file_col;
+	char *sql;
+	int i;
+
+	/* everything before the shard has to go in first */
+	flush_chunks();
+
+	/* ATTACH isn't allowed inside a transaction */
+	exec_sql("commit;");
+	sql = sqlite3_mprintf("attach database %Q as shard;", filename);
+	exec_sql(sql);
+	sqlite3_free(sql);
+	exec_sql("begin transaction;");
+
+	has_deps = select_int("select count(*) from shard.sqlite_master where name = 'file_deps';");
+	if (!has_deps)
+		tu = "0";
+	if (update_mode && has_deps) {
+		exec_sql("insert or ignore into temp.seen_files select distinct file from shard.file_deps;");
+		changed = shard_is_newer(filename) ||
+			  select_int("select count(*) from shard.file_deps where file not in "
+				     "(select file from main.file_deps);");
+		if (changed)
+			save_old_rows("select file from shard.file_deps");
+	}
+
+	nr_tables = get_tables("shard", tables, SQLB_MAX_TABLES);
+	for (i = 0; i < nr_tables; i++) {
+		file_col = has_file_column("main", tables[i]);
+
+		if (update_mode && changed && file_col) {
+			sql = sqlite3_mprintf("delete from main.\"%w\" where %s;", tables[i], tu);
+			exec_sql(sql);
+			sqlite3_free(sql);
+		}
+
+		filter = "";
+		if (file_col && !changed)
+			filter = "not (file in (select file from shard.file_deps))";
+
+		if (strcmp(tables[i], "caller_info") == 0) {
+			merge_caller_info(filter);
+		} else if (strcmp(tables[i], "constraints") == 0) {
+			/* the ids are different in every shard */
+			merge_sql("insert or ignore into main.constraints (str) "
+				  "select str from shard.constraints order by rowid;");
+		} else {
+			sql = sqlite3_mprintf("insert or ignore into main.\"%w\" "
+					      "select * from shard.\"%w\" %s%s order by rowid;",
+					      tables[i], tables[i],
+					      filter[0] ? "where " : "", filter);
+			merge_sql(sql);
+			sqlite3_free(sql);
+		}
+		free(tables[i]);
+	}
+
+	exec_sql("commit;");
+	exec_sql("detach database shard;");
+	exec_sql("begin transaction;");
+}
+
+static void read_files(char **files, int nr_files, int nr_threads)
+{
+	pthread_t *threads;
+	FILE *fp;
+	int i;
+
+	threads = calloc(nr_threads, sizeof(*threads));
+	for (i = 0; i < nr_threads; i++)
+		pthread_create(&threads[i], NULL, parse_thread, NULL);
+
+	for (i = 0; i < nr_files; i++) {
+		fp = fopen(files[i], "r");
+		if (!fp) {
+			fprintf(stderr, "cannot open %s: %s\n", files[i], strerror(errno));
+			errors++;
+			continue;
+		}
+		if (is_sqlite_file(fp)) {
+			fclose(fp);
+			merge_shard(files[i]);
+			continue;
+		}
+		if (is_binary_file(fp))
+			read_binary_file(files[i], fp);
+		else
+			read_text_file(fp);
+		fclose(fp);
+	}
+	if (cur_chunk)
+		queue_chunk(cur_chunk);
+
+	pthread_mutex_lock(&lock);
+	reading_done = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+
+	write_chunks(&write_seq, read_seq, true);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+}
+
+static void write_late_sql(void)
+{
+	int i;
+
+	for (i = 0; i < late_nr; i++) {
+		exec_sql(late_sql[i]);
+		free(late_sql[i]);
+		rows++;
+	}
+	free(late_sql);
+}
+
+static void write_common_functions(const char *filename)
+{
+	struct common_func *tmp;
+	sqlite3_stmt *stmt;
+	FILE *fp = NULL;
+	int i;
+
+	if (filename) {
+		fp = fopen(filename, "w");
+		if (!fp)
+			fprintf(stderr, "cannot open %s: %s\n", filename, strerror(errno));
+	}
+
+	sqlite3_prepare_v2(db, "insert into common_caller_info values ('unknown', 'too common', ?, 0, 0, 0, -1, '', '');",
+			   -1, &stmt, NULL);
+	for (i = 0; i < COMMON_HASH; i++) {
+		for (tmp = common_hash[i]; tmp; tmp = tmp->next) {
+			if (tmp->count <= TOO_COMMON)
+				continue;
+			if (stmt) {
+				sqlite3_bind_text(stmt, 1, tmp->name, -1, SQLITE_STATIC);
+				sqlite3_step(stmt);
+				sqlite3_reset(stmt);
+			}
+			if (fp && !strchr(tmp->name, ' '))
+				fprintf(fp, "%s\n", tmp->name);
+		}
+	}
+	sqlite3_finalize(stmt);
+	if (fp)
+		fclose(fp);
+}
+
+static char **files;
+static int nr_files, files_alloced;
+
+static void add_file(const char *name)
+{
+	if (nr_files == files_alloced) {
+		files_alloced = files_alloced ? files_alloced * 2 : 64;
+		files = realloc(files, files_alloced * sizeof(*files));
+	}
+	files[nr_files++] = strdup(name);
+}
+
+static void add_files_from(const char *list)
+{
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *fp;
+
+	fp = fopen(list, "r");
+	if (!fp) {
+		fprintf(stderr, "cannot open %s: %s\n", list, strerror(errno));
+		exit(1);
+	}
+	while (getline(&buf, &size, fp) >= 0) {
+		buf[strcspn(buf, "\n")] = '\0';
+		if (buf[0])
+			add_file(buf);
+	}
+	free(buf);
+	fclose(fp);
+}
+
+int main(int argc, char **argv)
+{
+	const char *common_file = NULL;
+	const char *files_from = NULL;
+	struct prepared *prep;
+	int nr_threads;
+	int i = 1;
+
+	nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	while (i < argc && argv[i][0] == '-') {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			nr_threads = atoi(argv[i + 1]);
+			i += 2;
+		} else if (strncmp(argv[i], "--common-functions=", 19) == 0) {
+			common_file = argv[i] + 19;
+			i++;
+		} else if (strncmp(argv[i], "--changed=", 10) == 0) {
+			changed_file = argv[i] + 10;
+			i++;
+		} else if (strcmp(argv[i], "--update") == 0) {
+			update_mode = true;
+			i++;
+		} else if (strncmp(argv[i], "--files-from=", 13) == 0) {
+			files_from = argv[i] + 13;
+			i++;
+		} else {
+			usage(argv[0]);
+		}
+	}
+	if (nr_threads < 1)
+		nr_threads = 1;
+	if (changed_file && (update_mode || files_from || argc - i != 1))
+		usage(argv[0]);
+	if (argc - i < 1 || (argc - i < 2 && !files_from && !changed_file))
+		usage(argv[0]);
+
+	if (update_mode) {
+		struct stat st;
+
+		if (stat(argv[i], &st) != 0) {
+			fprintf(stderr, "--update needs an existing database: %s\n", argv[i]);
+			return 1;
+		}
+		db_mtime = st.st_mtim;
+	}
+
+	if (sqlite3_open(argv[i], &db) != SQLITE_OK) {
+		fprintf(stderr, "cannot open %s: %s\n", argv[i], sqlite3_errmsg(db));
+		return 1;
+	}
+	exec_sql("PRAGMA cache_size = 800000;");
+	exec_sql("PRAGMA journal_mode = OFF;");
+	exec_sql("PRAGMA synchronous = OFF;");
+	exec_sql("PRAGMA temp_store = MEMORY;");
+	exec_sql("PRAGMA locking_mode = EXCLUSIVE;");
+	exec_sql("begin transaction;");
+
+	if (changed_file) {
+		write_rerun_files(changed_file);
+		exec_sql("commit;");
+		sqlite3_close(db);
+		return errors ? 1 : 0;
+	}
+
+	while (++i < argc)
+		add_file(argv[i]);
+	if (files_from)
+		add_files_from(files_from);
+
+	if (update_mode)
+		begin_update();
+	read_files(files, nr_files, nr_threads);
+	if (update_mode)
+		finish_update();
+	write_late_sql();
+	write_common_functions(common_file);
+
+	for (prep = prepared_list; prep; prep = prep->next)
+		sqlite3_finalize(prep->stmt);
+	exec_sql("commit;");
+	sqlite3_close(db);
+
+	fprintf(stderr, "%s: %lu rows, %lu errors\n", argv[0], rows, errors);
+	return errors ? 1 : 0;
+}
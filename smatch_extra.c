@@ -180,15 +180,12 @@ static void mark_sub_members_gone(const char *name, struct symbol *sym, struct s
 	if (!is_noderef_ptr_rl(estate_rl(state)))
 		return;
 
-	FOR_EACH_MY_SM(SMATCH_EXTRA, __get_cur_stree(), sm) {
-		if (sm->sym != sym)
-			continue;
+	sm = NULL;
+	while ((sm = next_sub_member(SMATCH_EXTRA, name, sym, sm))) {
 		if (strcmp(name, sm->name) == 0)
 			continue;
-		if (!is_sub_member(name, sym, sm))
-			continue;
 		set_extra_nomod(sm->name, sm->sym, NULL, alloc_estate_empty());
-	} END_FOR_EACH_SM(sm);
+	}
 }
 
 static void call_update_mtag_data(struct expression *expr,
@@ -2440,6 +2437,7 @@ static int is_really_long(struct sm_state *sm)
 
 static int filter_unused_param_value_info(struct expression *call, int param, char *printed_name, struct sm_state *sm)
 {
+	char sql[256];
 	int found = 0;
 
 	/* for function pointers assume everything is used */
@@ -2461,16 +2459,20 @@ static int filter_unused_param_value_info(struct expression *call, int param, ch
 	if (!is_kzalloc_info(sm) && !is_really_long(sm))
 		return 0;
 
-	run_sql(&param_used_callback, &found,
-		"select * from return_implies where %s and type = %d and parameter = %d and key = '%s';",
-		get_static_filter(call->fn->symbol), PARAM_USED, param, printed_name);
+	snprintf(sql, sizeof(sql),
+		 "select * from return_implies where %s and type = ? and parameter = ? and key = ?;",
+		 get_static_filter_bind(call->fn->symbol));
+	run_sql_bind(&param_used_callback, &found, sql, "Fdds",
+		     call->fn->symbol, PARAM_USED, param, printed_name);
 	if (found)
 		return 0;
 
 	/* If the database is not built yet, then assume everything is used */
-	run_sql(&param_used_callback, &found,
-		"select * from return_implies where %s and type = %d;",
-		get_static_filter(call->fn->symbol), PARAM_USED);
+	snprintf(sql, sizeof(sql),
+		 "select * from return_implies where %s and type = ?;",
+		 get_static_filter_bind(call->fn->symbol));
+	run_sql_bind(&param_used_callback, &found, sql, "Fd",
+		     call->fn->symbol, PARAM_USED);
 	if (!found)
 		return 0;
 
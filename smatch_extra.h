@@ -15,7 +15,32 @@
  * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
  */
 
-DECLARE_PTR_LIST(range_list, struct data_range);
+/*
+ * A range_list is a sorted array of ranges.  The lists are hash-consed in
+ * smatch_ranges.c so they never change after they are created and two
+ * lists with the same ranges are normally the same pointer.  Use
+ * FOR_EACH_RANGE() to walk the ranges.
+ */
+struct range_list {
+	struct range_list *next;	/* hash chain */
+	unsigned int hash;
+	unsigned int nr:31;
+	unsigned int perm:1;
+	struct data_range ranges[];
+};
+
+#define FOR_EACH_RANGE(rl, drange) do {					\
+	struct range_list *__rl_##drange = (rl);			\
+	unsigned int __i_##drange;					\
+	for (__i_##drange = 0;						\
+	     __rl_##drange && __i_##drange < __rl_##drange->nr;		\
+	     __i_##drange++) {						\
+		drange = &__rl_##drange->ranges[__i_##drange];
+
+#define END_FOR_EACH_RANGE(drange)					\
+	}								\
+} while (0)
+
 DECLARE_PTR_LIST(range_list_stack, struct range_list);
 
 struct relation {
@@ -55,11 +80,12 @@ int values_fit_type(struct expression *left, struct expression *right);
 struct range_list *alloc_rl(sval_t min, sval_t max);
 struct range_list *clone_rl(struct range_list *list);
 struct range_list *clone_rl_permanent(struct range_list *list);
+void save_worker_rl(struct range_list *rl);
+struct range_list *load_worker_rl(FILE *fp);
 struct range_list *alloc_whole_rl(struct symbol *type);
 
 void add_range(struct range_list **list, sval_t min, sval_t max);
 struct range_list *remove_range(struct range_list *list, sval_t min, sval_t max);
-void tack_on(struct range_list **list, struct data_range *drange);
 
 int true_comparison_range(struct data_range *left, int comparison, struct data_range *right);
 int true_comparison_range_LR(int comparison, struct data_range *var, struct data_range *val, int left);
@@ -82,6 +108,7 @@ bool is_noderef_ptr_rl(struct range_list *rl);
 bool rl_is_zero(struct range_list *rl);
 
 int rl_equiv(struct range_list *one, struct range_list *two);
+int rl_nr(struct range_list *rl);
 int is_whole_rl(struct range_list *rl);
 int is_unknown_ptr(struct range_list *rl);
 bool is_whole_ptr_rl(struct range_list *rl);
@@ -120,6 +147,8 @@ void split_comparison_rl(struct range_list *left_orig, int op, struct range_list
 
 void free_data_info_allocs(void);
 void free_all_rl(void);
+void free_rl_text_cache(void);
+void print_rl_text_cache_stats(void);
 
 /* smatch_estate.c */
 
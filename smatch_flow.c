@@ -18,6 +18,7 @@
 #define _GNU_SOURCE 1
 #include <unistd.h>
 #include <stdio.h>
+#include <sys/wait.h>
 #include "token.h"
 #include "scope.h"
 #include "smatch.h"
@@ -61,8 +62,9 @@ struct statement *__cur_stmt;
 struct statement *__next_stmt;
 int __in_pre_condition = 0;
 int __bail_on_rest_of_function = 0;
-static struct timeval fn_start_time;
-static struct timeval outer_fn_start_time;
+unsigned long long work_units;
+static unsigned long long fn_start_work;
+static unsigned long long outer_fn_start_work;
 char *get_function(void) { return cur_func; }
 int get_lineno(void) { return __smatch_lineno; }
 int inside_loop(void) { return !!loop_count; }
@@ -128,6 +130,7 @@ const char *get_base_file(void)
 	return base_file;
 }
 
+static struct position cur_position;
 static void set_position(struct position pos)
 {
 	int len;
@@ -139,6 +142,7 @@ static void set_position(struct position pos)
 	if (pos.stream == 0 && pos.line == 0)
 		return;
 
+	cur_position = pos;
 	__smatch_lineno = pos.line;
 
 	if (pos.stream == prev_stream)
@@ -216,10 +220,12 @@ static int save_func_time(void *_rl, int argc, char **argv, char **azColName)
 static int get_func_time(struct symbol *sym)
 {
 	unsigned long time = 0;
+	char sql[256];
 
-	run_sql(&save_func_time, &time,
-		"select key from return_implies where %s and type = %d;",
-		get_static_filter(sym), FUNC_TIME);
+	snprintf(sql, sizeof(sql),
+		 "select key from return_implies where %s and type = ?;",
+		 get_static_filter_bind(sym));
+	run_sql_bind(&save_func_time, &time, sql, "Fd", sym, FUNC_TIME);
 
 	return time;
 }
@@ -236,7 +242,7 @@ int inlinable(struct expression *expr)
 
 	if (expr->type != EXPR_SYMBOL || !expr->symbol)
 		return 0;
-	if (is_no_inline_function(expr->symbol->ident->name))
+	if (is_no_inline_function(expr->symbol->ident))
 		return 0;
 	sym = get_base_type(expr->symbol);
 	if (sym->stmt && sym->stmt->type == STMT_COMPOUND) {
@@ -908,14 +914,15 @@ static void split_case(struct statement *stmt)
 	__split_stmt(stmt->case_statement);
 }
 
-int time_parsing_function(void)
+/* this is in seconds of work, see WORK_PER_SECOND */
+int work_parsing_function(void)
 {
-	return ms_since(&fn_start_time) / 1000;
+	return (work_units - fn_start_work) / WORK_PER_SECOND;
 }
 
 bool taking_too_long(void)
 {
-	if ((ms_since(&outer_fn_start_time) / 1000) > 60 * 5) /* five minutes */
+	if (work_units - outer_fn_start_work > 60 * 5 * WORK_PER_SECOND) /* five minutes */
 		return 1;
 	return 0;
 }
@@ -1119,6 +1126,8 @@ void __split_stmt(struct statement *stmt)
 	if (!stmt)
 		goto out;
 
+	add_work(1);
+
 	if (!__in_fake_assign)
 		__silence_warnings_for_stmt = false;
 
@@ -1126,12 +1135,10 @@ void __split_stmt(struct statement *stmt)
 		return;
 
 	if (out_of_memory() || taking_too_long()) {
-		gettimeofday(&start, NULL);
-
 		__bail_on_rest_of_function = 1;
 		final_pass = 1;
-		sm_perror("Function too hairy.  Giving up. %lu seconds",
-		       start.tv_sec - fn_start_time.tv_sec);
+		sm_perror("Function too hairy.  Giving up. %d seconds of work",
+			  work_parsing_function());
 		fake_a_return();
 		final_pass = 0;  /* turn off sm_msg() from here */
 		return;
@@ -1763,12 +1770,11 @@ static void clear_function_data(void)
 
 static void record_func_time(void)
 {
-	struct timeval stop;
 	int func_time;
 	char buf[32];
 
-	gettimeofday(&stop, NULL);
-	func_time = stop.tv_sec - fn_start_time.tv_sec;
+	/* the same code has to give the same DB so this isn't wall time */
+	func_time = work_parsing_function();
 	snprintf(buf, sizeof(buf), "%d", func_time);
 	sql_insert_return_implies(FUNC_TIME, 0, "", buf);
 	if (option_time && func_time > 2) {
@@ -1785,8 +1791,8 @@ static void split_function(struct symbol *sym)
 	if (!base_type->stmt && !base_type->inline_stmt)
 		return;
 
-	gettimeofday(&outer_fn_start_time, NULL);
-	gettimeofday(&fn_start_time, NULL);
+	outer_fn_start_work = work_units;
+	fn_start_work = work_units;
 	cur_func_sym = sym;
 	if (sym->ident)
 		cur_func = sym->ident->name;
@@ -1894,7 +1900,7 @@ static void parse_inline(struct expression *call)
 {
 	struct symbol *base_type;
 	char *cur_func_bak = cur_func;  /* not aligned correctly for backup */
-	struct timeval time_backup = fn_start_time;
+	unsigned long long work_backup = fn_start_work;
 	struct expression *orig_inline = __inline_fn;
 	int orig_budget;
 
@@ -1941,7 +1947,7 @@ static void parse_inline(struct expression *call)
 	free_goto_stack();
 
 	restore_flow_state();
-	fn_start_time = time_backup;
+	fn_start_work = work_backup;
 	cur_func = cur_func_bak;
 
 	restore_all_states();
@@ -1966,10 +1972,15 @@ static void add_inline_function(struct symbol *sym)
 	add_ptr_list(&inlines_called, sym);
 }
 
+static int in_worker;
 static void process_inlines(void)
 {
 	struct symbol *tmp;
 
+	/* the parent does these after the --jobs workers are finished */
+	if (in_worker)
+		return;
+
 	FOR_EACH_PTR(inlines_called, tmp) {
 		split_function(tmp);
 	} END_FOR_EACH_PTR(tmp);
@@ -2070,21 +2081,353 @@ static struct stree *clone_estates_perm(struct stree *orig)
 }
 
 struct position last_pos;
-static void split_c_file_functions(struct symbol_list *sym_list)
+
+/*
+ * --jobs=N cuts the functions in a file into N slices and forks a worker
+ * for each slice.  The workers have their own copy of everything so it's
+ * the same as analysing each slice on its own, except that the mem_db
+ * doesn't have the return states of the static functions in the other
+ * slices and the return_ids are numbered differently.  The output is saved
+ * in temp files and printed in order so it doesn't depend on which worker
+ * finishes first.
+ *
+ * The END_FILE_HOOK only runs in the parent.  The workers pass back the
+ * things it needs in a temp file: where the output of each function ends,
+ * the inline functions it called, and the information which the hooks
+ * collected from the functions.  Each record starts with the function which
+ * loads it, and the parent loads the files in order after the workers finish
+ * so it ends up the same as if it had done the functions itself.  Then it
+ * copies the output one function at a time and does the inlines in between,
+ * the way a normal run does them, so each inline is only analysed once and
+ * its output is in the same place.
+ */
+static FILE **worker_streams[] = { &sm_outfd, &sql_outfd, &caller_info_fd, &sql_bin_fd };
+#define NR_WORKER_STREAMS ARRAY_SIZE(worker_streams)
+
+static int first_stream(int idx)
+{
+	int i;
+
+	for (i = 0; i < idx; i++) {
+		if (*worker_streams[i] == *worker_streams[idx])
+			return i;
+	}
+	return idx;
+}
+
+static void open_worker_streams(FILE *tmp[])
+{
+	int i;
+
+	for (i = 0; i < NR_WORKER_STREAMS; i++) {
+		tmp[i] = NULL;
+		if (!*worker_streams[i] || first_stream(i) != i)
+			continue;
+		tmp[i] = tmpfile();
+		if (!tmp[i])
+			sm_fatal("Error:  Cannot create a temp file for --jobs");
+	}
+}
+
+static void redirect_worker_streams(FILE *tmp[])
+{
+	FILE *orig[NR_WORKER_STREAMS];
+	int i;
+
+	for (i = 0; i < NR_WORKER_STREAMS; i++)
+		orig[i] = *worker_streams[i];
+
+	for (i = 0; i < NR_WORKER_STREAMS; i++) {
+		if (!orig[i])
+			continue;
+		/* stdout is redirected underneath so the printf()s go there too */
+		if (orig[i] == stdout) {
+			if (tmp[i])
+				dup2(fileno(tmp[i]), STDOUT_FILENO);
+			continue;
+		}
+		*worker_streams[i] = tmp[first_stream(i)];
+	}
+}
+
+/* copy up to the offsets in end[] or everything that's left if it's NULL */
+static void copy_worker_streams(FILE *tmp[], long *end)
+{
+	char buf[4096];
+	size_t len, size;
+	int i;
+
+	for (i = 0; i < NR_WORKER_STREAMS; i++) {
+		if (!tmp[i])
+			continue;
+		while (1) {
+			size = sizeof(buf);
+			if (end && end[i] - ftell(tmp[i]) < size)
+				size = end[i] - ftell(tmp[i]);
+			if (!size)
+				break;
+			len = fread(buf, 1, size, tmp[i]);
+			if (!len)
+				break;
+			fwrite(buf, 1, len, *worker_streams[i]);
+		}
+	}
+	/* our own binary rows after this have to declare their tables again */
+	forget_sqlb_tables();
+}
+
+FILE *worker_data_fd;
+
+/* the parent is a fork() of us so the pointers are the same there */
+void save_worker_data(worker_data_fn *load)
+{
+	save_worker_bytes(&load, sizeof(load));
+}
+
+void save_worker_bytes(const void *buf, size_t len)
+{
+	if (fwrite(buf, len, 1, worker_data_fd) != 1)
+		sm_fatal("Error:  Cannot save the --jobs worker data");
+}
+
+void load_worker_bytes(FILE *fp, void *buf, size_t len)
+{
+	if (fread(buf, len, 1, fp) != 1)
+		sm_fatal("Error:  The --jobs worker data is truncated");
+}
+
+void save_worker_string(const char *str)
+{
+	int len = strlen(str);
+
+	save_worker_bytes(&len, sizeof(len));
+	save_worker_bytes(str, len);
+}
+
+char *load_worker_string(FILE *fp)
+{
+	char *str;
+	int len;
+
+	load_worker_bytes(fp, &len, sizeof(len));
+	str = malloc(len + 1);
+	load_worker_bytes(fp, str, len);
+	str[len] = '\0';
+	return str;
+}
+
+struct worker_func {
+	struct position end_pos;
+	long end[NR_WORKER_STREAMS];
+	struct symbol_list *inlines;
+};
+static struct worker_func *worker_funcs;
+static int cur_worker_func;
+
+static void load_func_end(FILE *fp)
+{
+	struct worker_func *func;
+
+	load_worker_bytes(fp, &cur_worker_func, sizeof(cur_worker_func));
+	func = &worker_funcs[cur_worker_func];
+	load_worker_bytes(fp, &func->end_pos, sizeof(func->end_pos));
+	load_worker_bytes(fp, func->end, sizeof(func->end));
+}
+
+static void load_inline(FILE *fp)
 {
 	struct symbol *sym;
 
-	__unnullify_path();
+	load_worker_bytes(fp, &sym, sizeof(sym));
+	add_symbol(&worker_funcs[cur_worker_func].inlines, sym);
+}
+
+static void save_func_end(int idx, FILE *tmp[])
+{
+	long end[NR_WORKER_STREAMS] = {};
+	struct symbol *sym;
+	int i;
+
+	fflush(NULL);
+	/* use the fd offset because stdout is dup2()ed on top of tmp[] */
+	for (i = 0; i < NR_WORKER_STREAMS; i++) {
+		if (tmp[i])
+			end[i] = lseek(fileno(tmp[i]), 0, SEEK_CUR);
+	}
+
+	save_worker_data(&load_func_end);
+	save_worker_bytes(&idx, sizeof(idx));
+	save_worker_bytes(&cur_position, sizeof(cur_position));
+	save_worker_bytes(end, sizeof(end));
+
+	FOR_EACH_PTR(inlines_called, sym) {
+		save_worker_data(&load_inline);
+		save_worker_bytes(&sym, sizeof(sym));
+	} END_FOR_EACH_PTR(sym);
+	free_ptr_list(&inlines_called);
+
+	/* the next function might be copied after the parent's output */
+	forget_sqlb_tables();
+}
+
+static void load_worker_file(FILE *fp)
+{
+	worker_data_fn *load;
+
+	rewind(fp);
+	while (fread(&load, sizeof(load), 1, fp) == 1)
+		load(fp);
+	fclose(fp);
+}
+
+static void run_worker(struct symbol_list *funcs, int *slice, int worker,
+		       int nr_workers, FILE *tmp[], FILE *data)
+{
+	struct symbol *sym;
+	int i = 0;
+
+	in_worker = 1;
+	worker_data_fd = data;
+	redirect_worker_streams(tmp);
+	open_worker_info_db(worker);
+	start_worker_db(worker, nr_workers);
+
+	FOR_EACH_PTR(funcs, sym) {
+		if (slice[i++] != worker)
+			continue;
+		set_position(sym->pos);
+		last_pos = sym->pos;
+		split_function(sym);
+		save_func_end(i - 1, tmp);
+	} END_FOR_EACH_PTR(sym);
+
+	save_worker_db();
+
+	close_info_db();
+	fflush(NULL);
+	_exit((sm_nr_errors ? 1 : 0) | (sm_nr_checks ? 2 : 0));
+}
+
+/* The slices are weighted by the number of lines in each function */
+static int get_func_lines(struct symbol *sym, struct symbol *next)
+{
+	if (!next || next->pos.stream != sym->pos.stream ||
+	    next->pos.line <= sym->pos.line)
+		return 1;
+	return next->pos.line - sym->pos.line;
+}
+
+static bool split_functions_in_workers(struct symbol_list *sym_list)
+{
+	static FILE *tmp[MAX_JOBS][NR_WORKER_STREAMS];
+	FILE *data[MAX_JOBS];
+	pid_t pids[MAX_JOBS];
+	struct symbol_list *funcs = NULL;
+	struct symbol *sym, *next;
+	int nr_funcs, nr_workers;
+	long long total = 0, sofar = 0;
+	int *lines, *slice;
+	int status;
+	int i, k;
+
+	FOR_EACH_PTR(sym_list, sym) {
+		if (!interesting_function(sym))
+			continue;
+		if (sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN)
+			add_symbol(&funcs, sym);
+	} END_FOR_EACH_PTR(sym);
+
+	nr_funcs = symbol_list_size(funcs);
+	if (nr_funcs < 2) {
+		free_ptr_list(&funcs);
+		return false;
+	}
+	nr_workers = option_jobs < nr_funcs ? option_jobs : nr_funcs;
+	lines = malloc(nr_funcs * sizeof(*lines));
+	slice = malloc(nr_funcs * sizeof(*slice));
+	worker_funcs = calloc(nr_funcs, sizeof(*worker_funcs));
+
+	i = 0;
+	next = NULL;
+	FOR_EACH_PTR_REVERSE(funcs, sym) {
+		lines[nr_funcs - 1 - i] = get_func_lines(sym, next);
+		total += lines[nr_funcs - 1 - i];
+		next = sym;
+		i++;
+	} END_FOR_EACH_PTR_REVERSE(sym);
+	for (i = 0; i < nr_funcs; i++) {
+		slice[i] = sofar * nr_workers / total;
+		sofar += lines[i];
+	}
+
+	for (k = 0; k < nr_workers; k++) {
+		open_worker_streams(tmp[k]);
+		data[k] = tmpfile();
+		if (!data[k])
+			sm_fatal("Error:  Cannot create a temp file for --jobs");
+		fflush(NULL);
+		pids[k] = fork();
+		if (pids[k] < 0)
+			sm_fatal("Error:  fork() failed for --jobs");
+		if (pids[k] == 0)
+			run_worker(funcs, slice, k, nr_workers, tmp[k], data[k]);
+	}
+
+	for (k = 0; k < nr_workers; k++) {
+		if (waitpid(pids[k], &status, 0) < 0 || !WIFEXITED(status)) {
+			sm_ierror("--jobs worker %d died", k);
+			status = 0;
+		}
+		merge_worker_info_db(k);
+		load_worker_file(data[k]);
+		if (WEXITSTATUS(status) & 1)
+			sm_nr_errors++;
+		if (WEXITSTATUS(status) & 2)
+			sm_nr_checks++;
+		for (i = 0; i < NR_WORKER_STREAMS; i++) {
+			if (tmp[k][i])
+				rewind(tmp[k][i]);
+		}
+	}
+
+	/* this is split_functions() with the output from the workers */
+	i = 0;
 	FOR_EACH_PTR(sym_list, sym) {
 		set_position(sym->pos);
-		if (sym->type != SYM_NODE || get_base_type(sym)->type != SYM_FN) {
-			__pass_to_client(sym, BASE_HOOK);
-			fake_global_assign(sym);
-			__pass_to_client(sym, DECLARATION_HOOK_AFTER);
+		last_pos = sym->pos;
+		if (!interesting_function(sym))
+			continue;
+		if (sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN) {
+			copy_worker_streams(tmp[slice[i]], worker_funcs[i].end);
+			set_position(worker_funcs[i].end_pos);
+			FOR_EACH_PTR(worker_funcs[i].inlines, next) {
+				add_inline_function(next);
+			} END_FOR_EACH_PTR(next);
+			free_ptr_list(&worker_funcs[i].inlines);
+			process_inlines();
+			i++;
 		}
+		last_pos = sym->pos;
 	} END_FOR_EACH_PTR(sym);
-	global_states = clone_estates_perm(get_all_states_stree(SMATCH_EXTRA));
-	nullify_path();
+
+	for (k = 0; k < nr_workers; k++) {
+		copy_worker_streams(tmp[k], NULL);
+		for (i = 0; i < NR_WORKER_STREAMS; i++) {
+			if (tmp[k][i])
+				fclose(tmp[k][i]);
+		}
+	}
+
+	free(worker_funcs);
+	free(lines);
+	free(slice);
+	free_ptr_list(&funcs);
+	return true;
+}
+
+static void split_functions(struct symbol_list *sym_list)
+{
+	struct symbol *sym;
 
 	FOR_EACH_PTR(sym_list, sym) {
 		set_position(sym->pos);
@@ -2097,8 +2440,29 @@ static void split_c_file_functions(struct symbol_list *sym_list)
 		}
 		last_pos = sym->pos;
 	} END_FOR_EACH_PTR(sym);
+}
+
+static void split_c_file_functions(struct symbol_list *sym_list)
+{
+	struct symbol *sym;
+
+	__unnullify_path();
+	FOR_EACH_PTR(sym_list, sym) {
+		set_position(sym->pos);
+		if (sym->type != SYM_NODE || get_base_type(sym)->type != SYM_FN) {
+			__pass_to_client(sym, BASE_HOOK);
+			fake_global_assign(sym);
+			__pass_to_client(sym, DECLARATION_HOOK_AFTER);
+		}
+	} END_FOR_EACH_PTR(sym);
+	global_states = clone_estates_perm(get_all_states_stree(SMATCH_EXTRA));
+	nullify_path();
+
+	if (option_jobs <= 1 || !split_functions_in_workers(sym_list))
+		split_functions(sym_list);
 	split_inlines(sym_list);
 	__pass_to_client(sym_list, END_FILE_HOOK);
+	free_rl_text_cache();
 }
 
 static int final_before_fake;
@@ -2131,6 +2495,18 @@ static void open_output_files(char *base_file)
 	if (!option_info)
 		return;
 
+	if (option_info_db) {
+		snprintf(buf, sizeof(buf), "%s.smatch.db", base_file);
+		open_info_db(buf);
+	}
+
+	if (option_info_binary) {
+		snprintf(buf, sizeof(buf), "%s.smatch.sqlb", base_file);
+		sql_bin_fd = fopen(buf, "w");
+		if (!sql_bin_fd)
+			sm_fatal("Error:  Cannot open %s", buf);
+	}
+
 	snprintf(buf, sizeof(buf), "%s.smatch.sql", base_file);
 	sql_outfd = fopen(buf, "w");
 	if (!sql_outfd)
@@ -2172,8 +2548,16 @@ void smatch(struct string_list *filelist)
 
 	set_position(last_pos);
 	final_pass = 1;
-	if (option_time)
+	close_info_db();
+	if (option_time) {
 		sm_msg("time: %lu", stop.tv_sec - start.tv_sec);
-	if (option_mem)
+		print_sql_stats();
+		print_rl_text_cache_stats();
+	}
+	if (option_mem) {
 		sm_msg("mem: %luKb", get_max_memory());
+		show_mem_report();
+	}
+	if (option_profile)
+		show_profile_report();
 }
@@ -84,6 +84,7 @@ static int fresh_callback(void *fresh, int argc, char **argv, char **azColName)
 
 static int fresh_from_db(struct expression *call)
 {
+	char sql[256];
 	int fresh = 0;
 
 	if (is_fake_call(call))
@@ -93,9 +94,10 @@ static int fresh_from_db(struct expression *call)
 	if (call->fn->type != EXPR_SYMBOL)
 		return 0;
 
-	run_sql(&fresh_callback, &fresh,
-		"select * from return_states where %s and type = %d and parameter = -1 and key = '$' limit 1;",
-		get_static_filter(call->fn->symbol), FRESH_ALLOC);
+	snprintf(sql, sizeof(sql),
+		 "select * from return_states where %s and type = ? and parameter = -1 and key = '$' limit 1;",
+		 get_static_filter_bind(call->fn->symbol));
+	run_sql_bind(&fresh_callback, &fresh, sql, "Fd", call->fn->symbol, FRESH_ALLOC);
 	return fresh;
 }
 
@@ -65,6 +65,51 @@ static inline void destroy_function_hashtable(struct hashtable *table)
 	hashtable_destroy(table, 0);
 }
 
+/*
+ * Sparse only keeps one struct ident for each name so function names can be
+ * looked up by the ident pointer instead of hashing and comparing the
+ * string for every call.  The idents belong to sparse so never call
+ * hashtable_remove() or hashtable_destroy() on these tables because they
+ * free the keys.
+ */
+static inline unsigned int ident_ptr_hash(void *ky)
+{
+	unsigned long val = (unsigned long)ky;
+
+	return val >> 4;
+}
+
+static inline int equal_idents(void *k1, void *k2)
+{
+	return k1 == k2;
+}
+
+static inline struct hashtable *create_ident_hashtable(int size)
+{
+	return create_hashtable(size, ident_ptr_hash, equal_idents);
+}
+
+#define DEFINE_IDENT_ADD_HOOK(_name, _item_type, _list_type)  \
+void add_##_name(struct hashtable *table, const char *look_for, _item_type *value) \
+{                                                               \
+	struct ident *key = built_in_ident(look_for);          \
+	_list_type *list;                                       \
+                                                                \
+	list = search_##_name(table, key);                      \
+	if (list) {                                             \
+		/* adding to a list doesn't move the head */    \
+		add_ptr_list(&list, value);                     \
+		return;                                         \
+	}                                                       \
+	add_ptr_list(&list, value);                             \
+	insert_##_name(table, key, list);                       \
+}
+
+#define DEFINE_IDENT_HASHTABLE_STATIC(_name, _item_type, _list_type)   \
+	static DEFINE_HASHTABLE_INSERT(insert_##_name, struct ident, _list_type); \
+	static DEFINE_HASHTABLE_SEARCH(search_##_name, struct ident, _list_type); \
+	static DEFINE_IDENT_ADD_HOOK(_name, _item_type, _list_type);
+
 #define DEFINE_FUNCTION_HASHTABLE(_name, _item_type, _list_type)   \
 	DEFINE_HASHTABLE_INSERT(insert_##_name, char, _list_type); \
 	DEFINE_HASHTABLE_SEARCH(search_##_name, char, _list_type); \
@@ -70,14 +70,27 @@ struct fcall_back {
 		implied_return_hook *implied_return;
 	} u;
 	void *info;
+	int owner;
 };
 
 ALLOCATOR(fcall_back, "call backs");
 DECLARE_PTR_LIST(call_back_list, struct fcall_back);
 
-DEFINE_FUNCTION_HASHTABLE_STATIC(callback, struct fcall_back, struct call_back_list);
+DEFINE_IDENT_HASHTABLE_STATIC(callback, struct fcall_back, struct call_back_list);
 static struct hashtable *func_hash;
 
+static struct call_back_list *search_callback_name(const char *name)
+{
+	struct ident *ident;
+
+	if (!name)
+		return NULL;
+	ident = lookup_ident(name);
+	if (!ident)
+		return NULL;
+	return search_callback(func_hash, ident);
+}
+
 int __in_fake_parameter_assign;
 
 enum fn_hook_type {
@@ -100,6 +113,7 @@ struct param_key_data {
 
 struct return_implies_callback {
 	int type;
+	int owner;
 	bool param_key;
 	union {
 		return_implies_hook *callback;
@@ -142,9 +156,50 @@ static struct fcall_back *alloc_fcall_back(int type, void *call_back,
 	cb->type = type;
 	cb->u.call_back = call_back;
 	cb->info = info;
+	cb->owner = registering_check;
 	return cb;
 }
 
+static void call_func_hook(struct fcall_back *cb, const char *fn,
+			   struct expression *expr)
+{
+	struct profile_frame frame;
+
+	if (option_profile)
+		profile_enter(&frame);
+	(cb->u.call_back)(fn, expr, cb->info);
+	if (option_profile)
+		profile_exit(&frame, cb->owner);
+}
+
+static void call_ranged_hook(struct fcall_back *cb, const char *fn,
+			     struct expression *call_expr,
+			     struct expression *assign_expr)
+{
+	struct profile_frame frame;
+
+	if (option_profile)
+		profile_enter(&frame);
+	(cb->u.ranged)(fn, call_expr, assign_expr, cb->info);
+	if (option_profile)
+		profile_exit(&frame, cb->owner);
+}
+
+static int call_implied_return_hook(struct fcall_back *cb,
+				    struct expression *expr,
+				    struct range_list **rl)
+{
+	struct profile_frame frame;
+	int ret;
+
+	if (option_profile)
+		profile_enter(&frame);
+	ret = (cb->u.implied_return)(expr, cb->info, rl);
+	if (option_profile)
+		profile_exit(&frame, cb->owner);
+	return ret;
+}
+
 void add_function_hook(const char *look_for, func_hook *call_back, void *info)
 {
 	struct fcall_back *cb;
@@ -376,6 +431,7 @@ static struct return_implies_callback *alloc_db_return_callback(int type, bool p
 
 	cb = __alloc_return_implies_callback(0);
 	cb->type = type;
+	cb->owner = registering_check;
 	cb->param_key = param_key;
 	cb->callback = callback;
 
@@ -406,14 +462,21 @@ static void call_db_return_callback(struct db_callback_info *db_info,
 				    struct return_implies_callback *cb,
 				    int param, char *key, char *value)
 {
+	struct profile_frame frame;
+
+	if (cb->param_key && already_called(db_info->called, cb->pk_callback))
+		return;
+
+	if (option_profile)
+		profile_enter(&frame);
 	if (cb->param_key) {
-		if (already_called(db_info->called, cb->pk_callback))
-			return;
 		db_helper(db_info->expr, cb->pk_callback, param, key, NULL);
 		add_ptr_list(&db_info->called, cb);
 	} else {
 		cb->callback(db_info->expr, param, key, value);
 	}
+	if (option_profile)
+		profile_db_callback(&frame, cb->owner);
 }
 
 void select_return_param_key(int type, param_key_hook *callback)
@@ -455,7 +518,7 @@ static int call_call_backs(struct call_back_list *list, int type,
 
 	FOR_EACH_PTR(list, tmp) {
 		if (tmp->type == type) {
-			(tmp->u.call_back)(fn, expr, tmp->info);
+			call_func_hook(tmp, fn, expr);
 			handled = 1;
 		}
 	} END_FOR_EACH_PTR(tmp);
@@ -477,7 +540,7 @@ static void call_function_hooks(struct expression *expr, enum fn_hook_type type)
 	if (fn->type != EXPR_SYMBOL || !fn->symbol)
 		return;
 
-	call_backs = search_callback(func_hash, (char *)fn->symbol->ident->name);
+	call_backs = search_callback(func_hash, fn->symbol->ident);
 	if (!call_backs)
 		return;
 
@@ -502,7 +565,7 @@ static void call_ranged_call_backs(struct call_back_list *list,
 	struct fcall_back *tmp;
 
 	FOR_EACH_PTR(list, tmp) {
-		(tmp->u.ranged)(fn, call_expr, assign_expr, tmp->info);
+		call_ranged_hook(tmp, fn, call_expr, assign_expr);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -522,12 +585,12 @@ static struct call_back_list *get_same_ranged_call_backs(struct call_back_list *
 	return ret;
 }
 
-static int in_list_exact_sval(struct range_list *list, struct data_range *drange)
+static int in_list_exact_sval(struct call_back_list *list, struct data_range *drange)
 {
-	struct data_range *tmp;
+	struct fcall_back *tmp;
 
 	FOR_EACH_PTR(list, tmp) {
-		if (ranges_equiv(tmp, drange))
+		if (ranges_equiv(tmp->range, drange))
 			return 1;
 	} END_FOR_EACH_PTR(tmp);
 	return 0;
@@ -543,7 +606,7 @@ static int assign_ranged_funcs(const char *fn, struct expression *expr,
 	struct smatch_state *estate;
 	struct stree *tmp_stree;
 	struct stree *final_states = NULL;
-	struct range_list *handled_ranges = NULL;
+	struct call_back_list *handled_ranges = NULL;
 	struct call_back_list *same_range_call_backs = NULL;
 	struct range_list *rl;
 	int handled = 0;
@@ -563,7 +626,7 @@ static int assign_ranged_funcs(const char *fn, struct expression *expr,
 		if (in_list_exact_sval(handled_ranges, tmp->range))
 			continue;
 		__push_fake_cur_stree();
-		tack_on(&handled_ranges, tmp->range);
+		add_ptr_list(&handled_ranges, tmp);
 
 		same_range_call_backs = get_same_ranged_call_backs(call_backs, tmp->range);
 		call_ranged_call_backs(same_range_call_backs, fn, expr->right, expr);
@@ -585,6 +648,7 @@ static int assign_ranged_funcs(const char *fn, struct expression *expr,
 	} END_FOR_EACH_SM(sm);
 
 	free_stree(&final_states);
+	free_ptr_list(&handled_ranges);
 free:
 	free_string(var_name);
 	return handled;
@@ -605,7 +669,7 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 	if (expr->fn->type != EXPR_SYMBOL || !expr->fn->symbol)
 		return;
 	fn = expr->fn->symbol->ident->name;
-	call_backs = search_callback(func_hash, (char *)expr->fn->symbol->ident->name);
+	call_backs = search_callback(func_hash, expr->fn->symbol->ident);
 	if (!call_backs)
 		return;
 	value_range = alloc_range(sval, sval);
@@ -618,7 +682,7 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 			continue;
 		if (!true_comparison_range_LR(comparison, tmp->range, value_range, left))
 			continue;
-		(tmp->u.ranged)(fn, expr, NULL, tmp->info);
+		call_ranged_hook(tmp, fn, expr, NULL);
 	} END_FOR_EACH_PTR(tmp);
 	tmp_stree = __pop_fake_cur_stree();
 	merge_fake_stree(&true_states, tmp_stree);
@@ -632,7 +696,7 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 			continue;
 		if (!false_comparison_range_LR(comparison, tmp->range, value_range, left))
 			continue;
-		(tmp->u.ranged)(fn, expr, NULL, tmp->info);
+		call_ranged_hook(tmp, fn, expr, NULL);
 	} END_FOR_EACH_PTR(tmp);
 	tmp_stree = __pop_fake_cur_stree();
 	merge_fake_stree(&false_states, tmp_stree);
@@ -1233,14 +1297,14 @@ static void call_ranged_return_hooks(struct db_callback_info *db_info)
 
 	fn = expr->fn->symbol_name->name;
 
-	call_backs = search_callback(func_hash, fn);
+	call_backs = search_callback(func_hash, expr->fn->symbol_name);
 	FOR_EACH_PTR(call_backs, tmp) {
 		if (tmp->type != RANGED_CALL)
 			continue;
 		range_rl = alloc_rl(tmp->range->min, tmp->range->max);
 		range_rl = cast_rl(estate_type(db_info->ret_state), range_rl);
 		if (possibly_true_rl(range_rl, SPECIAL_EQUAL, estate_rl(db_info->ret_state)))
-			(tmp->u.ranged)(fn, expr, db_info->expr, tmp->info);
+			call_ranged_hook(tmp, fn, expr, db_info->expr);
 	} END_FOR_EACH_PTR(tmp);
 
 	FOR_EACH_PTR(call_backs, tmp) {
@@ -1261,7 +1325,7 @@ static void call_ranged_return_hooks(struct db_callback_info *db_info)
 		if (remove_range(estate_rl(db_info->ret_state),
 				 rl_min(range_rl), rl_max(range_rl)))
 			continue;
-		(tmp->u.ranged)(fn, expr, db_info->expr, tmp->info);
+		call_ranged_hook(tmp, fn, expr, db_info->expr);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -1424,7 +1488,7 @@ static void match_assign_call(struct expression *expr)
 		return;
 
 	fn = right->fn->symbol->ident->name;
-	call_backs = search_callback(func_hash, (char *)fn);
+	call_backs = search_callback(func_hash, right->fn->symbol->ident);
 
 	/*
 	 * The ordering here is sort of important.
@@ -1616,7 +1680,7 @@ static void match_macro_assign(struct expression *expr)
 
 	right = strip_expr(expr->right);
 	macro = get_macro_name(right->pos);
-	call_backs = search_callback(func_hash, (char *)macro);
+	call_backs = search_callback_name(macro);
 	if (!call_backs)
 		return;
 	call_call_backs(call_backs, MACRO_ASSIGN, macro, expr);
@@ -1637,11 +1701,11 @@ int get_implied_return(struct expression *expr, struct range_list **rl)
 	if (!fn)
 		goto out;
 
-	call_backs = search_callback(func_hash, fn);
+	call_backs = search_callback_name(fn);
 
 	FOR_EACH_PTR(call_backs, tmp) {
 		if (tmp->type == IMPLIED_RETURN)
-			handled |= (tmp->u.implied_return)(expr, tmp->info, rl);
+			handled |= call_implied_return_hook(tmp, expr, rl);
 	} END_FOR_EACH_PTR(tmp);
 
 out:
@@ -1655,13 +1719,13 @@ struct range_list *get_range_implications(const char *fn)
 	struct range_list *ret = NULL;
 	struct fcall_back *tmp;
 
-	call_backs = search_callback(func_hash, (char *)fn);
+	call_backs = search_callback_name(fn);
 
 	FOR_EACH_PTR(call_backs, tmp) {
 		if (tmp->type != RANGED_CALL &&
 		    tmp->type != RANGED_EXACT)
 			continue;
-		add_ptr_list(&ret, tmp->range);
+		add_range(&ret, tmp->range->min, tmp->range->max);
 	} END_FOR_EACH_PTR(tmp);
 
 	return ret;
@@ -1669,7 +1733,7 @@ struct range_list *get_range_implications(const char *fn)
 
 void create_function_hook_hash(void)
 {
-	func_hash = create_function_hashtable(5000);
+	func_hash = create_ident_hashtable(5000);
 }
 
 void register_function_hooks(int id)
@@ -81,6 +81,43 @@ static const enum data_type data_types[NUM_HOOKS] = {
 	[END_FILE_HOOK] = SYM_LIST_PTR,
 };
 
+/*
+ * Most hooks only care about one kind of expression or statement.  The
+ * hooks registered with add_filtered_hook() only get called when the key
+ * matches.  For the assignment, binop and op hooks the key is expr->op, for
+ * the expression and condition hooks it's expr->type and for the statement
+ * hooks it's stmt->type.
+ *
+ * hook_buckets[type][key] holds every hook that wants to see that key in
+ * the order they were registered: the filtered hooks for the key and all
+ * the unfiltered hooks.  Keys without a bucket use hook_array[type].
+ */
+enum key_type {
+	NO_KEY,
+	EXPR_TYPE_KEY,
+	EXPR_OP_KEY,
+	STMT_TYPE_KEY,
+};
+
+#define HOOK_KEY_MAX 512
+
+static const enum key_type key_types[NUM_HOOKS] = {
+	[EXPR_HOOK] = EXPR_TYPE_KEY,
+	[EXPR_HOOK_AFTER] = EXPR_TYPE_KEY,
+	[STMT_HOOK] = STMT_TYPE_KEY,
+	[STMT_HOOK_AFTER] = STMT_TYPE_KEY,
+	[ASSIGNMENT_HOOK] = EXPR_OP_KEY,
+	[ASSIGNMENT_HOOK_AFTER] = EXPR_OP_KEY,
+	[RAW_ASSIGNMENT_HOOK] = EXPR_OP_KEY,
+	[GLOBAL_ASSIGNMENT_HOOK] = EXPR_OP_KEY,
+	[LOGIC_HOOK] = EXPR_OP_KEY,
+	[CONDITION_HOOK] = EXPR_TYPE_KEY,
+	[BINOP_HOOK] = EXPR_OP_KEY,
+	[OP_HOOK] = EXPR_OP_KEY,
+};
+
+static struct hook_func_list **hook_buckets[NUM_HOOKS];
+
 void (**pre_merge_hooks)(struct sm_state *cur, struct sm_state *other);
 
 struct scope_container {
@@ -95,11 +132,73 @@ static struct scope_hook_stack *scope_hooks;
 void add_hook(void *func, enum hook_type type)
 {
 	struct hook_container *container = __alloc_hook_container(0);
+	int key;
 
 	container->hook_type = type;
+	container->owner = registering_check;
 	container->fn = func;
 
 	add_ptr_list(&hook_array[type], container);
+
+	if (!hook_buckets[type])
+		return;
+	for (key = 0; key < HOOK_KEY_MAX; key++) {
+		if (hook_buckets[type][key])
+			add_ptr_list(&hook_buckets[type][key], container);
+	}
+}
+
+void add_filtered_hook(void *func, enum hook_type type, int key)
+{
+	struct hook_container *container;
+	struct hook_func_list **bucket;
+
+	if (key_types[type] == NO_KEY || key < 0 || key >= HOOK_KEY_MAX)
+		sm_fatal("%s: hook type %d can't be filtered on %d", __func__, type, key);
+
+	container = __alloc_hook_container(0);
+	container->hook_type = type;
+	container->owner = registering_check;
+	container->fn = func;
+
+	if (!hook_buckets[type])
+		hook_buckets[type] = calloc(HOOK_KEY_MAX, sizeof(*hook_buckets[type]));
+	bucket = &hook_buckets[type][key];
+	if (!*bucket)
+		concat_ptr_list((struct ptr_list *)hook_array[type], (struct ptr_list **)bucket);
+	add_ptr_list(bucket, container);
+}
+
+static struct hook_func_list *get_hook_list(void *data, enum hook_type type)
+{
+	struct expression *expr = data;
+	struct statement *stmt = data;
+	struct hook_func_list *list;
+	int key;
+
+	if (!hook_buckets[type] || !data)
+		return hook_array[type];
+
+	switch (key_types[type]) {
+	case EXPR_TYPE_KEY:
+		key = expr->type;
+		break;
+	case EXPR_OP_KEY:
+		key = expr->op;
+		break;
+	case STMT_TYPE_KEY:
+		key = stmt->type;
+		break;
+	default:
+		return hook_array[type];
+	}
+
+	if (key < 0 || key >= HOOK_KEY_MAX)
+		return hook_array[type];
+	list = hook_buckets[type][key];
+	if (!list)
+		return hook_array[type];
+	return list;
 }
 
 void add_merge_hook(int client_id, merge_func_t *func)
@@ -143,25 +242,37 @@ static void pass_sym_list_to_client(void *fn, void *data)
 	((sym_list_func *)fn)((struct symbol_list *)data);
 }
 
+static void pass_data_to_client(void *fn, void *data, enum hook_type type)
+{
+	switch (data_types[type]) {
+	case EXPR_PTR:
+		pass_expr_to_client(fn, data);
+		break;
+	case STMT_PTR:
+		pass_stmt_to_client(fn, data);
+		break;
+	case SYMBOL_PTR:
+		pass_sym_to_client(fn, data);
+		break;
+	case SYM_LIST_PTR:
+		pass_sym_list_to_client(fn, data);
+		break;
+	}
+}
+
 void __pass_to_client(void *data, enum hook_type type)
 {
 	struct hook_container *container;
+	struct profile_frame frame;
 
-	FOR_EACH_PTR(hook_array[type], container) {
-		switch (data_types[type]) {
-		case EXPR_PTR:
-			pass_expr_to_client(container->fn, data);
-			break;
-		case STMT_PTR:
-			pass_stmt_to_client(container->fn, data);
-			break;
-		case SYMBOL_PTR:
-			pass_sym_to_client(container->fn, data);
-			break;
-		case SYM_LIST_PTR:
-			pass_sym_list_to_client(container->fn, data);
-			break;
+	FOR_EACH_PTR(get_hook_list(data, type), container) {
+		if (!option_profile) {
+			pass_data_to_client(container->fn, data, type);
+			continue;
 		}
+		profile_enter(&frame);
+		pass_data_to_client(container->fn, data, type);
+		profile_exit(&frame, container->owner);
 	} END_FOR_EACH_PTR(container);
 }
 
@@ -171,9 +282,14 @@ void __pass_case_to_client(struct expression *switch_expr,
 	typedef void (case_func)(struct expression *switch_expr,
 				 struct range_list *rl);
 	struct hook_container *container;
+	struct profile_frame frame;
 
 	FOR_EACH_PTR(hook_array[CASE_HOOK], container) {
+		if (option_profile)
+			profile_enter(&frame);
 		((case_func *)container->fn)(switch_expr, rl);
+		if (option_profile)
+			profile_exit(&frame, container->owner);
 	} END_FOR_EACH_PTR(container);
 }
 
@@ -192,8 +308,9 @@ struct smatch_state *__client_merge_function(int owner,
 					     struct smatch_state *s1,
 					     struct smatch_state *s2)
 {
-	struct smatch_state *tmp_state;
+	struct smatch_state *tmp_state, *ret;
 	struct hook_container *tmp;
+	struct profile_frame frame;
 
 	/* Pass NULL states first and the rest alphabetically by name */
 	if (!s2 || (s1 && strcmp(s2->name, s1->name) < 0)) {
@@ -203,8 +320,14 @@ struct smatch_state *__client_merge_function(int owner,
 	}
 
 	FOR_EACH_PTR(merge_funcs, tmp) {
-		if (tmp->owner == owner)
+		if (tmp->owner != owner)
+			continue;
+		if (!option_profile)
 			return ((merge_func_t *)tmp->fn)(s1, s2);
+		profile_enter(&frame);
+		ret = ((merge_func_t *)tmp->fn)(s1, s2);
+		profile_exit(&frame, owner);
+		return ret;
 	} END_FOR_EACH_PTR(tmp);
 	return &undefined;
 }
@@ -212,21 +335,38 @@ struct smatch_state *__client_merge_function(int owner,
 struct smatch_state *__client_unmatched_state_function(struct sm_state *sm)
 {
 	struct hook_container *tmp;
+	struct profile_frame frame;
+	struct smatch_state *ret;
 
 	FOR_EACH_PTR(unmatched_state_funcs, tmp) {
-		if (tmp->owner == sm->owner)
+		if (tmp->owner != sm->owner)
+			continue;
+		if (!option_profile)
 			return ((unmatched_func_t *)tmp->fn)(sm);
+		profile_enter(&frame);
+		ret = ((unmatched_func_t *)tmp->fn)(sm);
+		profile_exit(&frame, sm->owner);
+		return ret;
 	} END_FOR_EACH_PTR(tmp);
 	return &undefined;
 }
 
 void call_pre_merge_hook(struct sm_state *cur, struct sm_state *other)
 {
+	struct profile_frame frame;
+
 	if (cur->owner >= num_checks)
 		return;
 
-	if (pre_merge_hooks[cur->owner])
+	if (!pre_merge_hooks[cur->owner])
+		return;
+	if (!option_profile) {
 		pre_merge_hooks[cur->owner](cur, other);
+		return;
+	}
+	profile_enter(&frame);
+	pre_merge_hooks[cur->owner](cur, other);
+	profile_exit(&frame, cur->owner);
 }
 
 static struct scope_hook_list *pop_scope_hook_list(struct scope_hook_stack **stack)
@@ -282,6 +422,7 @@ void add_array_initialized_hook(void (*hook)(struct expression *array, int nr))
 {
 	struct hook_container *container = __alloc_hook_container(0);
 
+	container->owner = registering_check;
 	container->fn = hook;
 
 	add_ptr_list(&array_init_hooks, container);
@@ -290,9 +431,14 @@ void add_array_initialized_hook(void (*hook)(struct expression *array, int nr))
 void __call_array_initialized_hooks(struct expression *array, int nr)
 {
 	struct hook_container *tmp;
+	struct profile_frame frame;
 
 	FOR_EACH_PTR(array_init_hooks, tmp) {
+		if (option_profile)
+			profile_enter(&frame);
 		((array_init_hook *)tmp->fn)(array, nr);
+		if (option_profile)
+			profile_exit(&frame, tmp->owner);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -77,18 +77,12 @@ bool debug_implied(void)
 
 /*
  * tmp_range_list():
- * It messes things up to free range list allocations.  This helper fuction
- * lets us reuse memory instead of doing new allocations.
+ * Range lists are hash-consed so asking for the same number again doesn't
+ * do a new allocation.
  */
 static struct range_list *tmp_range_list(struct symbol *type, long long num)
 {
-	static struct range_list *my_list = NULL;
-	static struct data_range *my_range;
-
-	__free_ptr_list((struct ptr_list **)&my_list);
-	my_range = alloc_range(ll_to_sval(num), ll_to_sval(num));
-	add_ptr_list(&my_list, my_range);
-	return my_list;
+	return alloc_rl(ll_to_sval(num), ll_to_sval(num));
 }
 
 static const char *show_comparison(int op)
@@ -204,53 +198,153 @@ static int create_fake_history(struct sm_state *sm, int comparison, struct range
 }
 
 /*
- * add_pool() adds a slist to *pools. If the slist has already been
- * added earlier then it doesn't get added a second time.
+ * The true, false and maybe pools and the states we have already visited
+ * are kept in open addressed hash tables instead of sorted state_lists.
+ * With a long merge history the linear searches were quadratic.
+ *
+ * Removing a pool leaves the key in place and sets ->sm to NULL so it's
+ * safe to remove pools while we are walking the table.
  */
-void add_pool(struct state_list **pools, struct sm_state *new)
+struct pool_slot {
+	void *key;
+	struct sm_state *sm;
+};
+
+struct pool_set {
+	struct pool_slot *slots;
+	unsigned int size;
+	unsigned int used;
+	unsigned int count;
+};
+
+static unsigned int ptr_hash(void *p)
 {
-	struct sm_state *tmp;
+	unsigned long val = (unsigned long)p;
 
-	FOR_EACH_PTR(*pools, tmp) {
-		if (tmp->pool < new->pool)
-			continue;
-		else if (tmp->pool == new->pool) {
-			return;
-		} else {
-			INSERT_CURRENT(new, tmp);
-			return;
-		}
-	} END_FOR_EACH_PTR(tmp);
-	add_ptr_list(pools, new);
+	return ((val >> 4) ^ (val >> 20)) * 2654435761U;
 }
 
-static int pool_in_pools(struct stree *pool,
-			 const struct state_list *slist)
+static struct pool_slot *find_slot(const struct pool_set *set, void *key)
 {
-	struct sm_state *tmp;
+	unsigned int mask = set->size - 1;
+	unsigned int i;
 
-	FOR_EACH_PTR(slist, tmp) {
-		if (!tmp->pool)
-			continue;
-		if (tmp->pool == pool)
-			return 1;
-	} END_FOR_EACH_PTR(tmp);
-	return 0;
+	i = ptr_hash(key) & mask;
+	while (set->slots[i].key && set->slots[i].key != key)
+		i = (i + 1) & mask;
+	return &set->slots[i];
 }
 
-static int remove_pool(struct state_list **pools, struct stree *remove)
+static struct sm_state *pool_set_lookup(const struct pool_set *set, void *key)
 {
-	struct sm_state *tmp;
-	int ret = 0;
+	if (!set->size || !key)
+		return NULL;
+	return find_slot(set, key)->sm;
+}
 
-	FOR_EACH_PTR(*pools, tmp) {
-		if (tmp->pool == remove) {
-			DELETE_CURRENT_PTR(tmp);
-			ret = 1;
-		}
-	} END_FOR_EACH_PTR(tmp);
+static void grow_pool_set(struct pool_set *set)
+{
+	struct pool_slot *old = set->slots;
+	unsigned int old_size = set->size;
+	unsigned int i;
+
+	/* if it's mostly tombstones then just clean them out */
+	if (!set->size)
+		set->size = 64;
+	else if (set->count * 4 > set->size)
+		set->size *= 2;
+	set->slots = calloc(set->size, sizeof(*set->slots));
+	if (!set->slots)
+		sm_fatal("out of memory in %s", __func__);
+	set->used = set->count;
+	for (i = 0; i < old_size; i++) {
+		if (old[i].sm)
+			*find_slot(set, old[i].key) = old[i];
+	}
+	free(old);
+}
 
-	return ret;
+static bool pool_set_add(struct pool_set *set, void *key, struct sm_state *sm)
+{
+	struct pool_slot *slot;
+
+	if ((set->used + 1) * 2 > set->size)
+		grow_pool_set(set);
+
+	slot = find_slot(set, key);
+	if (slot->sm)
+		return false;
+	if (!slot->key)
+		set->used++;
+	slot->key = key;
+	slot->sm = sm;
+	set->count++;
+	return true;
+}
+
+static int pool_set_remove(struct pool_set *set, void *key)
+{
+	struct pool_slot *slot;
+
+	if (!set->size || !key)
+		return 0;
+	slot = find_slot(set, key);
+	if (!slot->sm)
+		return 0;
+	slot->sm = NULL;
+	set->count--;
+	return 1;
+}
+
+static struct sm_state *next_pool(const struct pool_set *set, unsigned int *iter)
+{
+	struct sm_state *sm;
+
+	while (*iter < set->size) {
+		sm = set->slots[(*iter)++].sm;
+		if (sm)
+			return sm;
+	}
+	return NULL;
+}
+
+static void free_pool_set(struct pool_set *set)
+{
+	free(set->slots);
+	memset(set, 0, sizeof(*set));
+}
+
+/*
+ * add_pool() adds a slist to *pools. If the slist has already been
+ * added earlier then it doesn't get added a second time.
+ */
+static void add_pool(struct pool_set *pools, struct sm_state *new)
+{
+	pool_set_add(pools, new->pool, new);
+}
+
+static int pool_in_pools(struct stree *pool, const struct pool_set *pools)
+{
+	return !!pool_set_lookup(pools, pool);
+}
+
+static int remove_pool(struct pool_set *pools, struct stree *remove)
+{
+	return pool_set_remove(pools, remove);
+}
+
+static struct {
+	unsigned int true_pools;
+	unsigned int false_pools;
+	unsigned int maybe_pools;
+	unsigned int visited;
+} pool_stats;
+
+void show_implied_pool_stats(void)
+{
+	sm_msg("implied pools: true = %u false = %u maybe = %u visited = %u",
+	       pool_stats.true_pools, pool_stats.false_pools,
+	       pool_stats.maybe_pools, pool_stats.visited);
 }
 
 static bool possibly_true_helper(struct range_list *var_rl, int comparison, struct range_list *rl)
@@ -283,9 +377,9 @@ static bool possibly_false_helper(struct range_list *var_rl, int comparison, str
  * the false pools.  If we're not sure, then we don't add it to either.
  */
 static void do_compare(struct sm_state *sm, int comparison, struct range_list *rl,
-			struct state_list **true_stack,
-			struct state_list **maybe_stack,
-			struct state_list **false_stack,
+			struct pool_set *true_stack,
+			struct pool_set *maybe_stack,
+			struct pool_set *false_stack,
 			int *mixed, struct sm_state *gate_sm)
 {
 	int istrue;
@@ -322,17 +416,6 @@ static void do_compare(struct sm_state *sm, int comparison, struct range_list *r
 		add_pool(maybe_stack, sm);
 }
 
-static int is_checked(struct state_list *checked, struct sm_state *sm)
-{
-	struct sm_state *tmp;
-
-	FOR_EACH_PTR(checked, tmp) {
-		if (tmp == sm)
-			return 1;
-	} END_FOR_EACH_PTR(tmp);
-	return 0;
-}
-
 /*
  * separate_pools():
  * Example code:  if (foo == 99) {
@@ -342,22 +425,17 @@ static int is_checked(struct state_list *checked, struct sm_state *sm)
  * do_compare() for each time 'foo' was set.
  */
 static void __separate_pools(struct sm_state *sm, int comparison, struct range_list *rl,
-			struct state_list **true_stack,
-			struct state_list **maybe_stack,
-			struct state_list **false_stack,
-			struct state_list **checked, int *mixed, struct sm_state *gate_sm,
-			struct timeval *start_time)
+			struct pool_set *true_stack,
+			struct pool_set *maybe_stack,
+			struct pool_set *false_stack,
+			struct pool_set *checked, int *mixed, struct sm_state *gate_sm,
+			unsigned long long start_work)
 {
-	int free_checked = 0;
-	struct state_list *checked_states = NULL;
-	struct timeval now, diff;
-
 	if (!sm)
 		return;
 
-	gettimeofday(&now, NULL);
-	timersub(&now, start_time, &diff);
-	if (diff.tv_sec >= 1) {
+	add_work(1);
+	if (work_units - start_work >= WORK_PER_SECOND) {
 		if (full_debug) {
 			sm_msg("debug: %s: implications taking too long.  (%s %s %s)",
 			       __func__, sm->state->name, show_comparison(comparison), show_rl(rl));
@@ -366,77 +444,78 @@ static void __separate_pools(struct sm_state *sm, int comparison, struct range_l
 			*mixed = 1;
 	}
 
-	if (checked == NULL) {
-		checked = &checked_states;
-		free_checked = 1;
-	}
-	if (is_checked(*checked, sm))
+	if (!pool_set_add(checked, sm, sm))
 		return;
-	add_ptr_list(checked, sm);
 
 	do_compare(sm, comparison, rl, true_stack, maybe_stack, false_stack, mixed, gate_sm);
 
-	__separate_pools(sm->left, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_time);
-	__separate_pools(sm->right, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_time);
-	if (free_checked)
-		free_slist(checked);
+	__separate_pools(sm->left, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_work);
+	__separate_pools(sm->right, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_work);
 }
 
 static void separate_pools(struct sm_state *sm, int comparison, struct range_list *rl,
-			struct state_list **true_stack,
-			struct state_list **false_stack,
-			struct state_list **checked, int *mixed)
+			struct pool_set *true_stack,
+			struct pool_set *false_stack,
+			int *mixed)
 {
-	struct state_list *maybe_stack = NULL;
+	struct pool_set maybe_stack = {};
+	struct pool_set checked = {};
 	struct sm_state *tmp;
-	struct timeval start_time;
+	unsigned int iter;
 
+	__separate_pools(sm, comparison, rl, true_stack, &maybe_stack, false_stack, &checked, mixed, sm, work_units);
 
-	gettimeofday(&start_time, NULL);
-	__separate_pools(sm, comparison, rl, true_stack, &maybe_stack, false_stack, checked, mixed, sm, &start_time);
+	pool_stats.maybe_pools = maybe_stack.count;
+	pool_stats.visited = checked.count;
+	free_pool_set(&checked);
 
 	if (full_debug) {
 		struct sm_state *sm;
 
-		FOR_EACH_PTR(*true_stack, sm) {
+		iter = 0;
+		while ((sm = next_pool(true_stack, &iter)))
 			sm_msg("TRUE %s [stree %d %p]", show_sm(sm), get_stree_id(sm->pool), sm->pool);
-		} END_FOR_EACH_PTR(sm);
 
-		FOR_EACH_PTR(maybe_stack, sm) {
+		iter = 0;
+		while ((sm = next_pool(&maybe_stack, &iter)))
 			sm_msg("MAYBE %s %s[stree %d %p]",
 			       show_sm(sm), sm->merged ? "(merged) ": "", get_stree_id(sm->pool), sm->pool);
-		} END_FOR_EACH_PTR(sm);
 
-		FOR_EACH_PTR(*false_stack, sm) {
+		iter = 0;
+		while ((sm = next_pool(false_stack, &iter)))
 			sm_msg("FALSE %s [stree %d %p]", show_sm(sm), get_stree_id(sm->pool), sm->pool);
-		} END_FOR_EACH_PTR(sm);
 	}
 	/* if it's a maybe then remove it */
-	FOR_EACH_PTR(maybe_stack, tmp) {
+	iter = 0;
+	while ((tmp = next_pool(&maybe_stack, &iter))) {
 		remove_pool(false_stack, tmp->pool);
 		remove_pool(true_stack, tmp->pool);
-	} END_FOR_EACH_PTR(tmp);
+	}
+	free_pool_set(&maybe_stack);
 
 	/* if it's both true and false remove it from both */
-	FOR_EACH_PTR(*true_stack, tmp) {
+	iter = 0;
+	while ((tmp = next_pool(true_stack, &iter))) {
 		if (remove_pool(false_stack, tmp->pool))
-			DELETE_CURRENT_PTR(tmp);
-	} END_FOR_EACH_PTR(tmp);
+			remove_pool(true_stack, tmp->pool);
+	}
+
+	pool_stats.true_pools = true_stack->count;
+	pool_stats.false_pools = false_stack->count;
 }
 
-static int sm_in_keep_leafs(struct sm_state *sm, const struct state_list *keep_gates)
+static int sm_in_keep_leafs(struct sm_state *sm, const struct pool_set *keep_leafs)
 {
 	struct sm_state *tmp, *old;
+	unsigned int iter = 0;
 
-	FOR_EACH_PTR(keep_gates, tmp) {
-		if (is_merged(tmp))
-			continue;
+	while ((tmp = next_pool(keep_leafs, &iter))) {
 		old = get_sm_state_stree(tmp->pool, sm->owner, sm->name, sm->sym);
 		if (!old)
 			continue;
 		if (old == sm)
 			return 1;
-	} END_FOR_EACH_PTR(tmp);
+	}
 	return 0;
 }
 
@@ -449,13 +528,13 @@ static int going_too_slow(void)
 		return 1;
 	}
 
-	if (time_parsing_function() < 60) {
+	if (work_parsing_function() < 60) {
 		implications_off = false;
 		return 0;
 	}
 
 	if (!__inline_fn && printed != cur_func_sym) {
-		sm_perror("turning off implications after 60 seconds");
+		sm_perror("turning off implications after 60 seconds of work");
 		printed = cur_func_sym;
 	}
 	implications_off = true;
@@ -485,6 +564,78 @@ static char *sm_state_info(struct sm_state *sm)
 	return buf;
 }
 
+/*
+ * The merge histories of the states in a stree share most of their nodes so
+ * filter_stack() remembers what filter_pools() returned for each sm_state.
+ * The answer only depends on the remove and keep stacks so the memo is
+ * thrown away at the end of filter_stack().
+ */
+struct filter_memo {
+	struct sm_state *sm;
+	struct sm_state *ret;
+};
+
+struct filter_info {
+	const struct pool_set *remove_stack;
+	const struct pool_set *keep_stack;
+	const struct pool_set *keep_leafs;
+	unsigned long long start_work;
+	int recurse_cnt;
+	int skip;
+	int bail;
+	struct filter_memo *memo;
+	unsigned int memo_size;
+	unsigned int memo_count;
+};
+
+static struct filter_memo *find_memo(struct filter_info *info, struct sm_state *sm)
+{
+	unsigned int mask = info->memo_size - 1;
+	unsigned int i;
+
+	i = ptr_hash(sm) & mask;
+	while (info->memo[i].sm && info->memo[i].sm != sm)
+		i = (i + 1) & mask;
+	return &info->memo[i];
+}
+
+static struct filter_memo *get_memo(struct filter_info *info, struct sm_state *sm)
+{
+	struct filter_memo *memo;
+
+	if (!info->memo_size)
+		return NULL;
+	memo = find_memo(info, sm);
+	if (!memo->sm)
+		return NULL;
+	return memo;
+}
+
+static void add_memo(struct filter_info *info, struct sm_state *sm, struct sm_state *ret)
+{
+	struct filter_memo *old = info->memo;
+	struct filter_memo *memo;
+	unsigned int old_size = info->memo_size;
+	unsigned int i;
+
+	if ((info->memo_count + 1) * 2 > info->memo_size) {
+		info->memo_size = old_size ? old_size * 2 : 256;
+		info->memo = calloc(info->memo_size, sizeof(*info->memo));
+		if (!info->memo)
+			sm_fatal("out of memory in %s", __func__);
+		for (i = 0; i < old_size; i++) {
+			if (old[i].sm)
+				*find_memo(info, old[i].sm) = old[i];
+		}
+		free(old);
+	}
+
+	memo = find_memo(info, sm);
+	memo->sm = sm;
+	memo->ret = ret;
+	info->memo_count++;
+}
+
 /*
  * NOTE: If a state is in both the keep stack and the remove stack then that is
  * a bug.  Only add states which are definitely true or definitely false.  If
@@ -493,32 +644,27 @@ static char *sm_state_info(struct sm_state *sm)
  * you can't do that, then don't add it to either list.
  */
 #define RECURSE_LIMIT 300
-struct sm_state *filter_pools(struct sm_state *sm,
-			      const struct state_list *remove_stack,
-			      const struct state_list *keep_stack,
-			      int *modified, int *recurse_cnt,
-			      struct timeval *start, int *skip, int *bail)
+static struct sm_state *filter_pools(struct filter_info *info, struct sm_state *sm, int *modified);
+
+static struct sm_state *__filter_pools(struct filter_info *info, struct sm_state *sm, int *modified)
 {
+	const struct pool_set *remove_stack = info->remove_stack;
+	const struct pool_set *keep_stack = info->keep_stack;
+	const struct pool_set *keep_leafs = info->keep_leafs;
 	struct sm_state *ret = NULL;
 	struct sm_state *left;
 	struct sm_state *right;
 	int removed = 0;
-	struct timeval now, diff;
 
-	if (!sm)
-		return NULL;
-	if (*bail)
-		return NULL;
-	gettimeofday(&now, NULL);
-	timersub(&now, start, &diff);
-	if (diff.tv_sec >= 3) {
+	add_work(1);
+	if (work_units - info->start_work >= 3 * WORK_PER_SECOND) {
 		DIMPLIED("%s: implications taking too long: %s\n", __func__, sm_state_info(sm));
-		*bail = 1;
+		info->bail = 1;
 		return NULL;
 	}
-	if ((*recurse_cnt)++ > RECURSE_LIMIT) {
+	if (info->recurse_cnt++ > RECURSE_LIMIT) {
 		DIMPLIED("%s: recursed too far:  %s\n", __func__, sm_state_info(sm));
-		*skip = 1;
+		info->skip = 1;
 		return NULL;
 	}
 
@@ -528,18 +674,18 @@ struct sm_state *filter_pools(struct sm_state *sm,
 		return NULL;
 	}
 
-	if (!is_merged(sm) || pool_in_pools(sm->pool, keep_stack) || sm_in_keep_leafs(sm, keep_stack)) {
+	if (!is_merged(sm) || pool_in_pools(sm->pool, keep_stack) || sm_in_keep_leafs(sm, keep_leafs)) {
 		DIMPLIED("%s: keep %s (%s, %s, %s): %s\n", __func__, sm->state->name,
 			is_merged(sm) ? "merged" : "not merged",
 			pool_in_pools(sm->pool, keep_stack) ? "in keep pools" : "not in keep pools",
-			sm_in_keep_leafs(sm, keep_stack) ? "reachable keep leaf" : "no keep leaf",
+			sm_in_keep_leafs(sm, keep_leafs) ? "reachable keep leaf" : "no keep leaf",
 			sm_state_info(sm));
 		return sm;
 	}
 
-	left = filter_pools(sm->left, remove_stack, keep_stack, &removed, recurse_cnt, start, skip, bail);
-	right = filter_pools(sm->right, remove_stack, keep_stack, &removed, recurse_cnt, start, skip, bail);
-	if (*bail || *skip)
+	left = filter_pools(info, sm->left, &removed);
+	right = filter_pools(info, sm->right, &removed);
+	if (info->bail || info->skip)
 		return NULL;
 	if (!removed) {
 		DIMPLIED("%s: kept all: %s\n", __func__, sm_state_info(sm));
@@ -581,44 +727,135 @@ struct sm_state *filter_pools(struct sm_state *sm,
 	return ret;
 }
 
-static struct stree *filter_stack(struct sm_state *gate_sm,
-				  struct stree *pre_stree,
-				  const struct state_list *remove_stack,
-				  const struct state_list *keep_stack)
+static struct sm_state *filter_pools(struct filter_info *info, struct sm_state *sm, int *modified)
 {
+	struct filter_memo *memo;
+	struct sm_state *ret;
+
+	if (!sm)
+		return NULL;
+	if (info->bail)
+		return NULL;
+
+	memo = get_memo(info, sm);
+	if (memo) {
+		if (memo->ret != sm)
+			*modified = 1;
+		return memo->ret;
+	}
+
+	ret = __filter_pools(info, sm, modified);
+	/* if we gave up part way through then the answer is wrong */
+	if (!info->bail && !info->skip)
+		add_memo(info, sm, ret);
+	return ret;
+}
+
+static void get_keep_leafs(const struct pool_set *keep_stack, struct pool_set *keep_leafs)
+{
+	struct sm_state *tmp;
+	unsigned int iter = 0;
+
+	while ((tmp = next_pool(keep_stack, &iter))) {
+		if (!is_merged(tmp))
+			add_pool(keep_leafs, tmp);
+	}
+}
+
+static struct stree *__filter_stack(struct sm_state *gate_sm,
+				    struct stree *pre_stree,
+				    const struct pool_set *remove_stack,
+				    const struct pool_set *keep_stack,
+				    const struct pool_set *keep_leafs)
+{
+	struct filter_info info = {
+		.remove_stack = remove_stack,
+		.keep_stack = keep_stack,
+		.keep_leafs = keep_leafs,
+	};
 	struct stree *ret = NULL;
 	struct sm_state *tmp;
 	struct sm_state *filtered_sm;
 	int modified;
-	int recurse_cnt;
-	struct timeval start;
-	int skip;
-	int bail = 0;
 
-	if (!remove_stack)
+	if (!remove_stack->count)
 		return NULL;
 
-	gettimeofday(&start, NULL);
+	info.start_work = work_units;
 	FOR_EACH_SM(pre_stree, tmp) {
-		if (!tmp->merged || sm_in_keep_leafs(tmp, keep_stack))
+		if (!tmp->merged || sm_in_keep_leafs(tmp, keep_leafs))
 			continue;
 		modified = 0;
-		recurse_cnt = 0;
-		skip = 0;
-		filtered_sm = filter_pools(tmp, remove_stack, keep_stack, &modified, &recurse_cnt, &start, &skip, &bail);
-		if (going_too_slow())
-			return NULL;
-		if (bail)
-			return ret;  /* Return the implications we figured out before time ran out. */
+		info.recurse_cnt = 0;
+		info.skip = 0;
+		filtered_sm = filter_pools(&info, tmp, &modified);
+		if (going_too_slow()) {
+			free_stree(&ret);
+			goto free;
+		}
+		if (info.bail)
+			goto free;  /* Return the implications we figured out before time ran out. */
 
 
-		if (skip || !filtered_sm || !modified)
+		if (info.skip || !filtered_sm || !modified)
 			continue;
-		/* the assignments here are for borrowed implications */
-		filtered_sm->name = tmp->name;
-		filtered_sm->sym = tmp->sym;
+		/*
+		 * The assignments here are for borrowed implications.  The
+		 * filtered state might be in the history of another state
+		 * so don't change the one in the memo.
+		 */
+		if (filtered_sm->sym != tmp->sym || filtered_sm->name != tmp->name) {
+			struct sm_state *pool_sm = filtered_sm;
+
+			filtered_sm = clone_sm(filtered_sm);
+			filtered_sm->pool = pool_sm->pool;
+			filtered_sm->name = tmp->name;
+			filtered_sm->sym = tmp->sym;
+		}
 		avl_insert(&ret, filtered_sm);
 	} END_FOR_EACH_SM(tmp);
+free:
+	free(info.memo);
+	return ret;
+}
+
+/*
+ * The implication hooks in smatch_comparison.c and the other modules give
+ * us their true and false states as state_lists.  Turn them into pool sets.
+ */
+static void slist_to_pool_set(const struct state_list *slist, struct pool_set *pools,
+			      struct pool_set *leafs)
+{
+	struct sm_state *tmp;
+
+	FOR_EACH_PTR(slist, tmp) {
+		if (!tmp->pool)
+			continue;
+		add_pool(pools, tmp);
+		if (leafs && !is_merged(tmp))
+			add_pool(leafs, tmp);
+	} END_FOR_EACH_PTR(tmp);
+}
+
+static struct stree *filter_stack(struct sm_state *gate_sm,
+				  struct stree *pre_stree,
+				  const struct state_list *remove_stack,
+				  const struct state_list *keep_stack)
+{
+	struct pool_set remove_pools = {};
+	struct pool_set keep_pools = {};
+	struct pool_set keep_leafs = {};
+	struct stree *ret;
+
+	if (!remove_stack)
+		return NULL;
+
+	slist_to_pool_set(remove_stack, &remove_pools, NULL);
+	slist_to_pool_set(keep_stack, &keep_pools, &keep_leafs);
+	ret = __filter_stack(gate_sm, pre_stree, &remove_pools, &keep_pools, &keep_leafs);
+	free_pool_set(&remove_pools);
+	free_pool_set(&keep_pools);
+	free_pool_set(&keep_leafs);
 	return ret;
 }
 
@@ -628,14 +865,14 @@ static void separate_and_filter(struct sm_state *sm, int comparison, struct rang
 		struct stree **false_states,
 		int *mixed)
 {
-	struct state_list *true_stack = NULL;
-	struct state_list *false_stack = NULL;
-	struct timeval time_before;
-	struct timeval time_after;
+	struct pool_set true_stack = {};
+	struct pool_set false_stack = {};
+	struct pool_set true_leafs = {};
+	struct pool_set false_leafs = {};
+	unsigned long long start_work = work_units;
+	unsigned int iter;
 	int sec;
 
-	gettimeofday(&time_before, NULL);
-
 	DIMPLIED("checking implications: (%s (%s) %s %s)\n",
 		 sm->name, sm->state->name, show_comparison(comparison), show_rl(rl));
 
@@ -644,31 +881,35 @@ static void separate_and_filter(struct sm_state *sm, int comparison, struct rang
 		return;
 	}
 
-	separate_pools(sm, comparison, rl, &true_stack, &false_stack, NULL, mixed);
+	separate_pools(sm, comparison, rl, &true_stack, &false_stack, mixed);
 
 	if (implied_debug) {
 		struct sm_state *sm;
 
-		FOR_EACH_PTR(true_stack, sm) {
+		iter = 0;
+		while ((sm = next_pool(&true_stack, &iter)))
 			sm_msg("TRUE POOL: %p", sm->pool);
-		} END_FOR_EACH_PTR(sm);
 
-		FOR_EACH_PTR(false_stack, sm) {
+		iter = 0;
+		while ((sm = next_pool(&false_stack, &iter)))
 			sm_msg("FALSE POOL: %p", sm->pool);
-		} END_FOR_EACH_PTR(sm);
 	}
 
+	get_keep_leafs(&true_stack, &true_leafs);
+	get_keep_leafs(&false_stack, &false_leafs);
+
 	DIMPLIED("filtering true stack.\n");
-	*true_states = filter_stack(sm, pre_stree, false_stack, true_stack);
+	*true_states = __filter_stack(sm, pre_stree, &false_stack, &true_stack, &true_leafs);
 	DIMPLIED("filtering false stack.\n");
-	*false_states = filter_stack(sm, pre_stree, true_stack, false_stack);
-	free_slist(&true_stack);
-	free_slist(&false_stack);
+	*false_states = __filter_stack(sm, pre_stree, &true_stack, &false_stack, &false_leafs);
+	free_pool_set(&true_stack);
+	free_pool_set(&false_stack);
+	free_pool_set(&true_leafs);
+	free_pool_set(&false_leafs);
 
-	gettimeofday(&time_after, NULL);
-	sec = time_after.tv_sec - time_before.tv_sec;
+	sec = (work_units - start_work) / WORK_PER_SECOND;
 	if (sec > 20)
-		sm_perror("Function too hairy.  Ignoring implications after %d seconds.", sec);
+		sm_perror("Function too hairy.  Ignoring implications after %d seconds of work.", sec);
 }
 
 static struct expression *get_last_expr(struct statement *stmt)
@@ -1033,7 +1274,7 @@ void param_limit_implications(struct expression *expr, int param, char *key, cha
 	struct symbol *left_sym = NULL;
 	int mixed = 0;
 
-	if (time_parsing_function() > 40)
+	if (work_parsing_function() > 40)
 		return;
 
 	orig_expr = expr;
@@ -216,13 +216,13 @@ static bool handle_minus_preop(struct expression *expr, int implied, int *recurs
 		if (sval_is_min(rl_min(neg)) && !sval_is_min(rl_max(neg)))
 			neg = remove_range(neg, sval_type_min(type), sval_type_min(type));
 
-		FOR_EACH_PTR(neg, drange) {
+		FOR_EACH_RANGE(neg, drange) {
 			new_min = drange->max;
 			new_min.value = -new_min.value;
 			new_max = drange->min;
 			new_max.value = -new_max.value;
 			add_range(&ret, new_min, new_max);
-		} END_FOR_EACH_PTR(drange);
+		} END_FOR_EACH_RANGE(drange);
 
 		if (untrusted_type_min(expr))
 			add_range(&ret, sval_type_min(type), sval_type_min(type));
@@ -236,13 +236,13 @@ static bool handle_minus_preop(struct expression *expr, int implied, int *recurs
 		pos = alloc_rl(zero, sval_type_max(type));
 		pos = rl_intersection(rl, pos);
 
-		FOR_EACH_PTR(pos, drange) {
+		FOR_EACH_RANGE(pos, drange) {
 			new_min = drange->max;
 			new_min.value = -new_min.value;
 			new_max = drange->min;
 			new_max.value = -new_max.value;
 			add_range(&ret, new_min, new_max);
-		} END_FOR_EACH_PTR(drange);
+		} END_FOR_EACH_RANGE(drange);
 	}
 
 	*res = ret;
@@ -704,10 +704,10 @@ static int has_actual_ranges(struct range_list *rl)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (sval_cmp(tmp->min, tmp->max) != 0)
 			return 1;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
@@ -724,20 +724,20 @@ static struct range_list *handle_implied_binop(struct range_list *left_rl, int o
 	if (has_actual_ranges(right_rl))
 		return NULL;
 
-	if (ptr_list_size((struct ptr_list *)left_rl) * ptr_list_size((struct ptr_list *)right_rl) > 20)
+	if (rl_nr(left_rl) * rl_nr(right_rl) > 20)
 		return NULL;
 
 	res_rl = NULL;
 
-	FOR_EACH_PTR(left_rl, left_drange) {
-		FOR_EACH_PTR(right_rl, right_drange) {
+	FOR_EACH_RANGE(left_rl, left_drange) {
+		FOR_EACH_RANGE(right_rl, right_drange) {
 			if ((op == '%' || op == '/') &&
 			    right_drange->min.value == 0)
 				return NULL;
 			res = sval_binop(left_drange->min, op, right_drange->min);
 			add_range(&res_rl, res, res);
-		} END_FOR_EACH_PTR(right_drange);
-	} END_FOR_EACH_PTR(left_drange);
+		} END_FOR_EACH_RANGE(right_drange);
+	} END_FOR_EACH_RANGE(left_drange);
 
 	return res_rl;
 }
@@ -17,8 +17,10 @@
  */
 
 #include "smatch.h"
+#include "smatch_slist.h"
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/time.h>
 #ifdef __sun
 #include <sys/procfs.h>
 #endif
@@ -66,6 +68,75 @@ unsigned long get_mem_kb(void)
 }
 #endif
 
+/* the memory we know about without asking the kernel */
+static unsigned long get_tracked_bytes(void)
+{
+	return get_allocator_bytes() + avl_node_count * sizeof(AvlNode);
+}
+
+/*
+ * get_mem_kb() opens a file in /proc so it's too slow to call for every
+ * merge.  This only reads /proc once a second or when the allocators
+ * have grown by 16MB.  In between it adds what the allocators have grown
+ * by to the last number from /proc.
+ */
+unsigned long get_mem_kb_cheap(void)
+{
+	static unsigned long last_kb, last_bytes;
+	static time_t last_sec;
+	unsigned long bytes = get_tracked_bytes();
+	struct timeval now;
+
+	if (last_kb && bytes < last_bytes + 16 * 1024 * 1024) {
+		gettimeofday(&now, NULL);
+		if (now.tv_sec == last_sec) {
+			if (bytes > last_bytes)
+				return last_kb + (bytes - last_bytes) / 1024;
+			return last_kb;
+		}
+		last_sec = now.tv_sec;
+	}
+
+	last_kb = get_mem_kb();
+	last_bytes = bytes;
+	return last_kb;
+}
+
+static int cmp_peak(const void *_a, const void *_b)
+{
+	const struct allocator_struct *a = *(const struct allocator_struct **)_a;
+	const struct allocator_struct *b = *(const struct allocator_struct **)_b;
+
+	if (a->peak_bytes > b->peak_bytes)
+		return -1;
+	if (a->peak_bytes < b->peak_bytes)
+		return 1;
+	return strcmp(a->name, b->name);
+}
+
+void show_mem_report(void)
+{
+	struct allocator_struct *desc, **list;
+	int nr = 0, i;
+
+	for (desc = allocator_list; desc; desc = desc->next)
+		nr++;
+	list = malloc((nr + 1) * sizeof(*list));
+	i = 0;
+	for (desc = allocator_list; desc; desc = desc->next)
+		list[i++] = desc;
+	qsort(list, nr, sizeof(*list), cmp_peak);
+
+	sm_msg("mem: %-32s %10s %10s", "allocator", "peak Kb", "now Kb");
+	for (i = 0; i < nr; i++) {
+		sm_msg("mem: %-32s %10lu %10lu", list[i]->name,
+		       list[i]->peak_bytes / 1024, list[i]->total_bytes / 1024);
+	}
+	sm_msg("mem: %-32s %10s %10lu", "avl nodes", "",
+	       avl_node_count * sizeof(AvlNode) / 1024);
+	free(list);
+}
+
 static void match_end_func(struct symbol *sym)
 {
 	unsigned long size;
@@ -122,36 +122,136 @@ bool is_sub_member(const char *name, struct symbol *sym, struct sm_state *sm)
 	return false;
 }
 
+/*
+ * The stree is sorted by owner and then by name so the states which
+ * is_sub_member() can match are in a few ranges:  the names which start
+ * with "name" or "&name" and, if "name" starts with N stars, the names
+ * which are N + 1 stars, with or without a '&' in front, followed by
+ * nothing, '-' or '.'.
+ */
+#define NR_SUB_MEMBER_RANGES 8
+
+struct sub_member_range {
+	char prefix[80];
+	bool exact;
+};
+
+static int get_sub_member_ranges(const char *name, struct sub_member_range *ranges)
+{
+	int stars = 0;
+	char *p;
+	int i;
+
+	if (strlen(name) + 4 > sizeof(ranges[0].prefix))
+		return 0;
+
+	while (name[stars] == '*')
+		stars++;
+
+	snprintf(ranges[0].prefix, sizeof(ranges[0].prefix), "%s", name);
+	snprintf(ranges[1].prefix, sizeof(ranges[1].prefix), "&%s", name);
+	ranges[0].exact = ranges[1].exact = false;
+	for (i = 2; i < NR_SUB_MEMBER_RANGES; i++) {
+		p = ranges[i].prefix;
+		if (i >= 5)
+			*p++ = '&';
+		memset(p, '*', stars + 1);
+		p[stars + 1] = "\0-."[(i - 2) % 3];
+		p[stars + 2] = '\0';
+		ranges[i].exact = ((i - 2) % 3 == 0);
+	}
+
+	return NR_SUB_MEMBER_RANGES;
+}
+
+static struct sm_state *first_in_range(struct stree *stree, int owner,
+				       struct sub_member_range *range,
+				       struct sm_state *prev)
+{
+	struct sm_state *sm;
+
+	sm = avl_lower_bound(stree, owner, range->prefix);
+	if (prev && sm && cmp_tracker(sm, prev) <= 0)
+		sm = avl_next(stree, prev);
+	if (!sm || sm->owner != owner)
+		return NULL;
+	if (range->exact) {
+		if (strcmp(sm->name, range->prefix) != 0)
+			return NULL;
+	} else {
+		if (strncmp(sm->name, range->prefix, strlen(range->prefix)) != 0)
+			return NULL;
+	}
+	return sm;
+}
+
+/*
+ * Returns the next state after "prev" for "owner" where is_sub_member() is
+ * true, in the same order as FOR_EACH_MY_SM().  It looks up the current
+ * stree each time so it's fine if the caller sets states in between.
+ */
+struct sm_state *next_sub_member(int owner, const char *name, struct symbol *sym,
+				 struct sm_state *prev)
+{
+	struct sub_member_range ranges[NR_SUB_MEMBER_RANGES];
+	struct stree *stree = __get_cur_stree();
+	struct sm_state *sm, *tmp;
+	int nr_ranges, i;
+
+	if (!has_states(stree, owner))
+		return NULL;
+
+	nr_ranges = get_sub_member_ranges(name, ranges);
+	while (true) {
+		if (nr_ranges == 0) {
+			/* too long for the ranges so check everything */
+			if (prev)
+				sm = avl_next(stree, prev);
+			else
+				sm = avl_lower_bound(stree, owner, "");
+			if (sm && sm->owner != owner)
+				sm = NULL;
+		} else {
+			sm = NULL;
+			for (i = 0; i < nr_ranges; i++) {
+				tmp = first_in_range(stree, owner, &ranges[i], prev);
+				if (tmp && (!sm || cmp_tracker(tmp, sm) < 0))
+					sm = tmp;
+			}
+		}
+		if (!sm || is_sub_member(name, sym, sm))
+			return sm;
+		prev = sm;
+	}
+}
+
 static void call_modification_hooks_name_sym(char *name, struct symbol *sym, struct expression *mod_expr, int late)
 {
 	struct sm_state *sm;
 	struct smatch_state *prev;
-	int match;
+	int owner;
 
 	prev = get_state(my_id, name, sym);
 
 	if (cur_func_sym && !__in_fake_assign)
 		set_state(my_id, name, sym, alloc_my_state(mod_expr, prev));
 
-	FOR_EACH_SM(__get_cur_stree(), sm) {
-		if (sm->owner > num_checks)
-			continue;
-		if (!hooks[sm->owner] && !hooks_late[sm->owner])
-			continue;
-		match = is_sub_member(name, sym, sm);
-		if (!match)
+	for (owner = 0; owner <= num_checks; owner++) {
+		if (!hooks[owner] && !hooks_late[owner])
 			continue;
 
-		if (late == EARLY || late == BOTH) {
-			if (hooks[sm->owner])
-				(hooks[sm->owner])(sm, mod_expr);
-		}
-		if (late == LATE || late == BOTH) {
-			if (hooks_late[sm->owner])
-				(hooks_late[sm->owner])(sm, mod_expr);
+		sm = NULL;
+		while ((sm = next_sub_member(owner, name, sym, sm))) {
+			if (late == EARLY || late == BOTH) {
+				if (hooks[owner])
+					(hooks[owner])(sm, mod_expr);
+			}
+			if (late == LATE || late == BOTH) {
+				if (hooks_late[owner])
+					(hooks_late[owner])(sm, mod_expr);
+			}
 		}
-
-	} END_FOR_EACH_SM(sm);
+	}
 }
 
 static void call_modification_hooks(struct expression *expr, struct expression *mod_expr, int late)
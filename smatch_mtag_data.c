@@ -40,8 +40,8 @@ static struct range_list *select_orig(mtag_t tag, int offset)
 {
 	struct range_list *rl = NULL;
 
-	mem_sql(&save_rl, &rl, "select value from mtag_data where tag = %lld and offset = %d;",
-		tag, offset);
+	mem_sql_bind(&save_rl, &rl, "select value from mtag_data where tag = ? and offset = ?;",
+		     "ld", tag, offset);
 	return rl;
 }
 
@@ -126,10 +126,10 @@ static void insert_mtag_data(mtag_t tag, int offset, struct range_list *rl)
 
 	rl = clone_rl_permanent(rl);
 
-	mem_sql(NULL, NULL, "delete from mtag_data where tag = %lld and offset = %d and type = %d",
-		tag, offset, DATA_VALUE);
-	mem_sql(NULL, NULL, "insert into mtag_data values (%lld, %d, %d, '%lu');",
-		tag, offset, DATA_VALUE, (unsigned long)rl);
+	mem_sql_bind(NULL, NULL, "delete from mtag_data where tag = ? and offset = ? and type = ?;",
+		     "ldd", tag, offset, DATA_VALUE);
+	mem_sql_bind(NULL, NULL, "insert into mtag_data values (?, ?, ?, ?);",
+		     "lddu", tag, offset, DATA_VALUE, (unsigned long)rl);
 }
 
 static bool invalid_type(struct symbol *type)
@@ -155,9 +155,40 @@ static bool parent_is_fresh_alloc(struct expression *expr)
 	return is_fresh_alloc_var_sym(sym->ident->name, sym);
 }
 
+static void load_mtag_data(FILE *fp);
+
+static void union_mtag_data(mtag_t tag, int offset, bool fresh, struct range_list *rl)
+{
+	struct range_list *orig = NULL;
+
+	/* the parent redoes this after the --jobs worker is finished */
+	if (worker_data_fd && !in_fake_env) {
+		save_worker_data(&load_mtag_data);
+		save_worker_bytes(&tag, sizeof(tag));
+		save_worker_bytes(&offset, sizeof(offset));
+		save_worker_bytes(&fresh, sizeof(fresh));
+		save_worker_rl(rl);
+	}
+
+	if (!fresh)
+		orig = select_orig(tag, offset);
+	insert_mtag_data(tag, offset, rl_union(orig, rl));
+}
+
+static void load_mtag_data(FILE *fp)
+{
+	mtag_t tag;
+	int offset;
+	bool fresh;
+
+	load_worker_bytes(fp, &tag, sizeof(tag));
+	load_worker_bytes(fp, &offset, sizeof(offset));
+	load_worker_bytes(fp, &fresh, sizeof(fresh));
+	union_mtag_data(tag, offset, fresh, load_worker_rl(fp));
+}
+
 void update_mtag_data(struct expression *expr, struct smatch_state *state)
 {
-	struct range_list *orig, *new;
 	struct symbol *type;
 	char *name;
 	mtag_t tag;
@@ -183,12 +214,7 @@ void update_mtag_data(struct expression *expr, struct smatch_state *state)
 	if (offset == 0 && invalid_type(type))
 		return;
 
-	if (parent_is_fresh_alloc(expr))
-		orig = NULL;
-	else
-		orig = select_orig(tag, offset);
-	new = rl_union(orig, estate_rl(state));
-	insert_mtag_data(tag, offset, new);
+	union_mtag_data(tag, offset, parent_is_fresh_alloc(expr), estate_rl(state));
 }
 
 static void match_global_assign(struct expression *expr)
@@ -228,6 +254,11 @@ static int save_mtag_data(void *_unused, int argc, char **argv, char **azColName
 		return 0;
 
 	rl = (struct range_list *)strtoul(argv[3], NULL, 10);
+	if (info_db) {
+		sql_insert_info_db("mtag_data", 0, "'%s', '%s', '%s', '%s'",
+				   argv[0], argv[1], argv[2], show_rl(rl));
+		return 0;
+	}
 	sm_msg("SQL: insert into mtag_data values ('%s', '%s', '%s', '%s');",
 	       argv[0], argv[1], argv[2], show_rl(rl));
 
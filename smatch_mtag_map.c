@@ -33,9 +33,6 @@ static void match_assign(struct expression *expr)
 	int right_offset, left_offset;
 	sval_t sval;
 
-	if (expr->op != '=')
-		return;
-
 	left = strip_expr(expr->left);
 	right = strip_expr(expr->right);
 
@@ -60,6 +57,6 @@ void register_mtag_map(int id)
 {
 	my_id = id;
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
-	add_hook(&match_assign, GLOBAL_ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
+	add_filtered_hook(&match_assign, GLOBAL_ASSIGNMENT_HOOK, '=');
 }
@@ -50,9 +50,6 @@ static void match_nul_assign(struct expression *expr)
 	struct symbol *type;
 	sval_t sval;
 
-	if (expr->op != '=')
-		return;
-
 	if (!get_value(expr->right, &sval) || sval.value != 0)
 		return;
 
@@ -113,8 +110,6 @@ static void match_string_assign(struct expression *expr)
 {
 	struct smatch_state *state;
 
-	if (expr->op != '=')
-		return;
 	state = get_terminated_state(expr->right);
 	if (!state)
 		return;
@@ -308,8 +303,8 @@ void register_nul_terminator(int id)
 {
 	my_id = id;
 
-	add_hook(&match_nul_assign, ASSIGNMENT_HOOK);
-	add_hook(&match_string_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_nul_assign, ASSIGNMENT_HOOK, '=');
+	add_filtered_hook(&match_string_assign, ASSIGNMENT_HOOK, '=');
 
 	add_hook(&match_call_info, FUNCTION_CALL_HOOK);
 	add_member_info_callback(my_id, struct_member_callback);
@@ -31,12 +31,6 @@ static void match_assign(struct expression *expr)
 {
 	sval_t sval;
 
-	if (expr->type != EXPR_ASSIGNMENT)
-		return;
-
-	if (expr->op != SPECIAL_AND_ASSIGN)
-		return;
-
 	if (!get_implied_value(expr->right, &sval))
 		return;
 
@@ -88,7 +82,7 @@ void register_param_bits_clear(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, SPECIAL_AND_ASSIGN);
 	add_unmatched_state_hook(my_id, &unmatched_state);
 	add_merge_hook(my_id, &merge_bstates);
 
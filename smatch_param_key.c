@@ -716,9 +716,6 @@ static void match_assign(struct expression *expr)
 	struct symbol *param_sym;
 	char *param_name;
 
-	if (expr->op != '=')
-		return;
-
 	/* __in_fake_parameter_assign is included deliberately */
 	if (is_fake_call(expr->right) ||
 	    __in_fake_struct_assign)
@@ -745,7 +742,7 @@ void register_param_key(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
-	add_hook(&match_assign, ASSIGNMENT_HOOK_AFTER);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK_AFTER, '=');
 	add_modification_hook(my_id, &undef);
 }
 
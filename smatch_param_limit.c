@@ -92,7 +92,7 @@ static struct range_list *generify_mtag_range(struct smatch_state *state)
 	 *
 	 */
 	rl = estate_rl(state);
-	FOR_EACH_PTR(rl, drange) {
+	FOR_EACH_RANGE(rl, drange) {
 		if (drange->min.value != drange->max.value)
 			continue;
 		if (drange->min.value == 0)
@@ -100,7 +100,7 @@ static struct range_list *generify_mtag_range(struct smatch_state *state)
 		if (is_err_ptr(drange->min))
 			continue;
 		return rl_union(valid_ptr_rl, rl);
-	} END_FOR_EACH_PTR(drange);
+	} END_FOR_EACH_RANGE(drange);
 
 	return estate_rl(state);
 }
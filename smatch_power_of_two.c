@@ -68,9 +68,6 @@ static bool is_sign_expansion(struct expression *expr)
 
 static void match_assign(struct expression *expr)
 {
-	if (expr->op != '=')
-		return;
-
 	if (is_sign_expansion(expr))
 		return;
 
@@ -161,7 +158,7 @@ void register_power_of_two(int id)
 {
 	my_id = id;
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 	add_hook(&match_condition, CONDITION_HOOK);
 	add_caller_info_callback(my_id, caller_info_callback);
 	select_caller_name_sym(set_power_of_two, POWER_OF_TWO);
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * --profile says which checks the time is spent in.  Every hook remembers
+ * the check which was being registered when it was added, and the places
+ * which call the hooks (__pass_to_client(), the function hooks, the merge,
+ * unmatched and pre-merge hooks and the DB callbacks) wrap each call in
+ * profile_enter() and profile_exit().
+ *
+ * Hooks call other hooks, for example when a function is parsed inline, so
+ * the time a check is charged for is the time spent in its hooks minus the
+ * time spent in the hooks that they called.  The sm_states are counted by
+ * owner in alloc_sm_state() and the DB rows are counted by the check which
+ * the row was passed to.
+ *
+ * "--profile" prints a table sorted by time at the end and "--profile=json"
+ * prints the same thing as JSON.
+ */
+
+#include <time.h>
+#include "smatch.h"
+
+int option_profile;
+int registering_check;
+
+struct check_profile {
+	unsigned long long nsec;
+	unsigned long long calls;
+	unsigned long long states;
+	unsigned long long db_rows;
+};
+
+static struct check_profile *profiles;
+static unsigned long long child_nsec;
+
+static unsigned long long now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct check_profile *get_profile(int owner)
+{
+	if (!profiles)
+		profiles = calloc(num_checks + 1, sizeof(*profiles));
+	/* set_state(-1, ...) and the dynamic owners are counted as internal */
+	if (owner < 0 || owner > num_checks)
+		owner = 0;
+	return &profiles[owner];
+}
+
+void profile_enter(struct profile_frame *frame)
+{
+	frame->start = now_nsec();
+	frame->saved_child = child_nsec;
+	child_nsec = 0;
+}
+
+void profile_exit(struct profile_frame *frame, int owner)
+{
+	struct check_profile *prof = get_profile(owner);
+	unsigned long long total;
+
+	total = now_nsec() - frame->start;
+	prof->nsec += total > child_nsec ? total - child_nsec : 0;
+	prof->calls++;
+	child_nsec = frame->saved_child + total;
+}
+
+void profile_sm_state(int owner)
+{
+	get_profile(owner)->states++;
+}
+
+void profile_db_callback(struct profile_frame *frame, int owner)
+{
+	profile_exit(frame, owner);
+	get_profile(owner)->db_rows++;
+}
+
+static const char *profile_name(int id)
+{
+	if (id == 0)
+		return "internal";
+	return check_name(id);
+}
+
+static int cmp_profile(const void *_a, const void *_b)
+{
+	int id_a = *(const int *)_a;
+	int id_b = *(const int *)_b;
+	struct check_profile *a = &profiles[id_a];
+	struct check_profile *b = &profiles[id_b];
+
+	if (a->nsec != b->nsec)
+		return a->nsec > b->nsec ? -1 : 1;
+	if (a->calls != b->calls)
+		return a->calls > b->calls ? -1 : 1;
+	return id_a - id_b;
+}
+
+static bool profile_used(struct check_profile *prof)
+{
+	return prof->calls || prof->states || prof->db_rows;
+}
+
+void show_profile_report(void)
+{
+	struct check_profile *prof;
+	unsigned long long total = 0;
+	int *order;
+	int nr = 0;
+	int i;
+
+	if (!profiles)
+		return;
+
+	order = malloc((num_checks + 1) * sizeof(*order));
+	for (i = 0; i <= num_checks; i++) {
+		if (!profile_used(&profiles[i]))
+			continue;
+		total += profiles[i].nsec;
+		order[nr++] = i;
+	}
+	qsort(order, nr, sizeof(*order), cmp_profile);
+
+	if (option_profile == PROFILE_JSON) {
+		fprintf(sm_outfd, "{\"total_usec\": %llu, \"checks\": [\n", total / 1000);
+		for (i = 0; i < nr; i++) {
+			prof = &profiles[order[i]];
+			fprintf(sm_outfd, "  {\"check\": \"%s\", \"usec\": %llu, \"calls\": %llu, \"states\": %llu, \"db_rows\": %llu}%s\n",
+				profile_name(order[i]), prof->nsec / 1000,
+				prof->calls, prof->states, prof->db_rows,
+				i + 1 < nr ? "," : "");
+		}
+		fprintf(sm_outfd, "]}\n");
+		free(order);
+		return;
+	}
+
+	sm_msg("profile: %-40s %8s %6s %12s %10s %10s", "check", "msec", "%",
+	       "calls", "states", "db rows");
+	for (i = 0; i < nr; i++) {
+		prof = &profiles[order[i]];
+		sm_msg("profile: %-40s %8llu %6.2f %12llu %10llu %10llu",
+		       profile_name(order[i]), prof->nsec / 1000000,
+		       total ? prof->nsec * 100.0 / total : 0.0,
+		       prof->calls, prof->states, prof->db_rows);
+	}
+	free(order);
+}
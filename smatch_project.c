@@ -26,8 +26,8 @@
 #include "smatch_extra.h"
 #include "smatch_function_hashtable.h"
 
-static DEFINE_HASHTABLE_INSERT(insert_func, char, int);
-static DEFINE_HASHTABLE_SEARCH(search_func, char, int);
+static DEFINE_HASHTABLE_INSERT(insert_func, struct ident, int);
+static DEFINE_HASHTABLE_SEARCH(search_func, struct ident, int);
 static struct hashtable *skipped_funcs;
 static struct hashtable *silenced_funcs;
 static struct hashtable *no_inline_funcs;
@@ -46,12 +46,9 @@ int is_skipped_function(void)
 
 static void match_function_def(struct symbol *sym)
 {
-	char *func;
-
-	func = get_function();
-	if (!func)
+	if (!sym->ident)
 		return;
-	if (search_func(skipped_funcs, func))
+	if (search_func(skipped_funcs, sym->ident))
 		set_function_skipped();
 }
 
@@ -61,22 +58,19 @@ static void match_function_def(struct symbol *sym)
  */
 int is_silenced_function(void)
 {
-	char *func;
-
 	if (is_skipped_function())
 		return 1;
 
-	func = get_function();
-	if (!func)
+	if (!cur_func_sym || !cur_func_sym->ident)
 		return 0;
-	if (search_func(silenced_funcs, func))
+	if (search_func(silenced_funcs, cur_func_sym->ident))
 		return 1;
 	return 0;
 }
 
-int is_no_inline_function(const char *function)
+int is_no_inline_function(struct ident *function)
 {
-	if (search_func(no_inline_funcs, (char *)function))
+	if (search_func(no_inline_funcs, function))
 		return 1;
 	return 0;
 }
@@ -135,10 +129,9 @@ static void register_ignored_macros(void)
 static void register_skipped_functions(void)
 {
 	struct token *token;
-	char *func;
 	char name[256];
 
-	skipped_funcs = create_function_hashtable(500);
+	skipped_funcs = create_ident_hashtable(500);
 
 	if (option_project == PROJ_NONE)
 		return;
@@ -154,8 +147,7 @@ static void register_skipped_functions(void)
 	while (token_type(token) != TOKEN_STREAMEND) {
 		if (token_type(token) != TOKEN_IDENT)
 			return;
-		func = alloc_string(show_ident(token->ident));
-		insert_func(skipped_funcs, func, INT_PTR(1));
+		insert_func(skipped_funcs, token->ident, INT_PTR(1));
 		token = token->next;
 	}
 	clear_token_alloc();
@@ -164,10 +156,9 @@ static void register_skipped_functions(void)
 static void register_silenced_functions(void)
 {
 	struct token *token;
-	char *func;
 	char name[256];
 
-	silenced_funcs = create_function_hashtable(500);
+	silenced_funcs = create_ident_hashtable(500);
 
 	if (option_project == PROJ_NONE)
 		return;
@@ -183,8 +174,7 @@ static void register_silenced_functions(void)
 	while (token_type(token) != TOKEN_STREAMEND) {
 		if (token_type(token) != TOKEN_IDENT)
 			return;
-		func = alloc_string(show_ident(token->ident));
-		insert_func(silenced_funcs, func, INT_PTR(1));
+		insert_func(silenced_funcs, token->ident, INT_PTR(1));
 		token = token->next;
 	}
 	clear_token_alloc();
@@ -193,10 +183,9 @@ static void register_silenced_functions(void)
 static void register_no_inline_functions(void)
 {
 	struct token *token;
-	char *func;
 	char name[256];
 
-	no_inline_funcs = create_function_hashtable(500);
+	no_inline_funcs = create_ident_hashtable(500);
 
 	if (option_project == PROJ_NONE)
 		return;
@@ -212,8 +201,7 @@ static void register_no_inline_functions(void)
 	while (token_type(token) != TOKEN_STREAMEND) {
 		if (token_type(token) != TOKEN_IDENT)
 			return;
-		func = alloc_string(show_ident(token->ident));
-		insert_func(no_inline_funcs, func, INT_PTR(1));
+		insert_func(no_inline_funcs, token->ident, INT_PTR(1));
 		token = token->next;
 	}
 	clear_token_alloc();
@@ -24,7 +24,10 @@ ALLOCATOR(data_info, "smatch extra data");
 ALLOCATOR(data_range, "data range");
 __DO_ALLOCATOR(struct data_range, sizeof(struct data_range), __alignof__(struct data_range),
 			 "permanent ranges", perm_data_range);
-__DECLARE_ALLOCATOR(struct ptr_list, rl_ptrlist);
+__DO_ALLOCATOR(struct range_list, sizeof(struct range_list), __alignof__(struct range_list),
+			 "range lists", range_list);
+__DO_ALLOCATOR(struct range_list, sizeof(struct range_list), __alignof__(struct range_list),
+			 "permanent range lists", perm_range_list);
 
 bool is_err_ptr(sval_t sval)
 {
@@ -114,6 +117,169 @@ static char *get_err_pointer_str(struct data_range *drange)
 	return buf;
 }
 
+/*
+ * The DB stores range lists as text so the same strings get parsed and
+ * printed over and over.  Remember the conversions.  The lists in
+ * parse_cache are permanent so that cache lasts until the end of the file.
+ * show_rl() is keyed on the range_list pointer and hash-consed lists are
+ * freed at the end of the function, so show_cache is cleared then too.
+ * The permanent lists go in perm_show_cache which lasts for the file.
+ */
+struct rl_text {
+	struct rl_text *next;
+	unsigned int hash;
+	struct symbol *type;
+	struct range_list *rl;
+	char str[];
+};
+
+struct rl_text_table {
+	struct rl_text **buckets;
+	unsigned int size;
+	unsigned int count;
+};
+__DO_ALLOCATOR(struct rl_text, sizeof(struct rl_text), __alignof__(struct rl_text),
+			 "range list text", rl_text);
+__DO_ALLOCATOR(struct rl_text, sizeof(struct rl_text), __alignof__(struct rl_text),
+			 "file range list text", file_rl_text);
+
+static struct rl_text_table parse_cache, show_cache, perm_show_cache;
+static unsigned long parse_hits, parse_misses, show_hits, show_misses;
+
+/* really long strings aren't worth remembering */
+#define RL_TEXT_MAX 256
+
+static unsigned int hash_rl_text(struct symbol *type, const char *str)
+{
+	unsigned long hash = (unsigned long)type;
+
+	while (*str)
+		hash = hash * 31 + *str++;
+	return hash ^ (hash >> 32);
+}
+
+static struct rl_text *find_rl_text(struct rl_text_table *table, unsigned int hash)
+{
+	if (!table->size)
+		return NULL;
+	return table->buckets[hash & (table->size - 1)];
+}
+
+static void add_rl_text(struct rl_text_table *table, struct rl_text *txt)
+{
+	struct rl_text **buckets, *tmp, *next;
+	unsigned int size, i;
+
+	if (table->count >= table->size) {
+		size = table->size ? table->size * 2 : 256;
+		buckets = calloc(size, sizeof(*buckets));
+		if (!buckets)
+			sm_fatal("out of memory growing the range list text cache");
+		for (i = 0; i < table->size; i++) {
+			for (tmp = table->buckets[i]; tmp; tmp = next) {
+				next = tmp->next;
+				tmp->next = buckets[tmp->hash & (size - 1)];
+				buckets[tmp->hash & (size - 1)] = tmp;
+			}
+		}
+		free(table->buckets);
+		table->buckets = buckets;
+		table->size = size;
+	}
+	txt->next = table->buckets[txt->hash & (table->size - 1)];
+	table->buckets[txt->hash & (table->size - 1)] = txt;
+	table->count++;
+}
+
+static void clear_rl_text_table(struct rl_text_table *table)
+{
+	free(table->buckets);
+	memset(table, 0, sizeof(*table));
+}
+
+static struct rl_text *alloc_rl_text(bool per_file, const char *str)
+{
+	struct rl_text *txt;
+	int len = strlen(str) + 1;
+
+	if (per_file)
+		txt = __alloc_file_rl_text(len);
+	else
+		txt = __alloc_rl_text(len);
+	memcpy(txt->str, str, len);
+	return txt;
+}
+
+static bool get_parsed_rl(struct symbol *type, const char *str, struct range_list **rl)
+{
+	unsigned int hash = hash_rl_text(type, str);
+	struct rl_text *txt;
+
+	for (txt = find_rl_text(&parse_cache, hash); txt; txt = txt->next) {
+		if (txt->hash == hash && txt->type == type &&
+		    strcmp(txt->str, str) == 0) {
+			parse_hits++;
+			*rl = txt->rl;
+			return true;
+		}
+	}
+	parse_misses++;
+	return false;
+}
+
+static void remember_parsed_rl(struct symbol *type, const char *str, struct range_list *rl)
+{
+	struct rl_text *txt;
+
+	if (strlen(str) >= RL_TEXT_MAX)
+		return;
+
+	txt = alloc_rl_text(true, str);
+	txt->hash = hash_rl_text(type, str);
+	txt->type = type;
+	txt->rl = clone_rl_permanent(rl);
+	add_rl_text(&parse_cache, txt);
+}
+
+static char *get_shown_rl(struct range_list *rl)
+{
+	struct rl_text_table *table = rl->perm ? &perm_show_cache : &show_cache;
+	struct rl_text *txt;
+
+	for (txt = find_rl_text(table, rl->hash); txt; txt = txt->next) {
+		if (txt->rl == rl) {
+			show_hits++;
+			return txt->str;
+		}
+	}
+	show_misses++;
+	return NULL;
+}
+
+static char *remember_shown_rl(struct range_list *rl, const char *str)
+{
+	struct rl_text *txt;
+
+	txt = alloc_rl_text(rl->perm, str);
+	txt->hash = rl->hash;
+	txt->rl = rl;
+	add_rl_text(rl->perm ? &perm_show_cache : &show_cache, txt);
+	return txt->str;
+}
+
+void free_rl_text_cache(void)
+{
+	clear_rl_text_table(&parse_cache);
+	clear_rl_text_table(&perm_show_cache);
+	clear_file_rl_text_alloc();
+}
+
+void print_rl_text_cache_stats(void)
+{
+	sm_msg("range list text cache: str_to_rl hits=%lu misses=%lu show_rl hits=%lu misses=%lu",
+	       parse_hits, parse_misses, show_hits, show_misses);
+}
+
 char *show_rl(struct range_list *list)
 {
 	struct data_range *prev_drange = NULL;
@@ -122,12 +288,20 @@ char *show_rl(struct range_list *list)
 	char *p = full;
 	char *prev = full;
 	char *err_ptr;
+	char *ret;
 	int remain;
 	int i = 0;
 
+	if (!list)
+		return alloc_sname("");
+
+	ret = get_shown_rl(list);
+	if (ret)
+		return ret;
+
 	full[0] = '\0';
 
-	FOR_EACH_PTR(list, tmp) {
+	FOR_EACH_RANGE(list, tmp) {
 		remain = full + sizeof(full) - p;
 		if (remain < 48) {
 			snprintf(prev, full + sizeof(full) - prev, ",%s-%s",
@@ -149,14 +323,256 @@ char *show_rl(struct range_list *list)
 				      sval_to_str(tmp->min),
 				      sval_to_str(tmp->max));
 		}
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
+
+	return remember_shown_rl(list, full);
+}
+
+/*
+ * Range lists are hash-consed.  A list is built up in a struct rl_builder
+ * and when it is finished we look it up in a hash table and use the copy
+ * we already have if there is one.  The lists are never modified after
+ * that.  Most lists only have one or two ranges and the same lists are
+ * built over and over so this saves a lot of memory and it means that
+ * rl_equiv() is normally just a pointer compare.
+ *
+ * The lists in rl_table are freed at the end of every function along with
+ * the rest of the smatch_extra data.  clone_rl_permanent() puts the list in
+ * perm_table instead and those are never freed.
+ *
+ * The float types don't use all of the sval union so lists with floats in
+ * them can't be hashed or compared by their bits.  They are rare and they
+ * are allocated without going into the table.
+ */
+struct rl_table {
+	struct range_list **buckets;
+	unsigned int size;
+	unsigned int count;
+};
+static struct rl_table rl_table, perm_table;
+
+/* lists which are too big for the allocator are malloc()ed */
+#define RL_BIG_BYTES (CHUNK / 4)
+static struct range_list_stack *big_rls;
+
+struct rl_builder {
+	struct data_range *ranges;
+	int nr;
+	int alloc;
+	struct data_range buf[8];
+};
+
+static void builder_add(struct rl_builder *b, sval_t min, sval_t max);
+
+static void init_builder(struct rl_builder *b)
+{
+	b->ranges = b->buf;
+	b->nr = 0;
+	b->alloc = ARRAY_SIZE(b->buf);
+}
+
+static void free_builder(struct rl_builder *b)
+{
+	if (b->ranges != b->buf)
+		free(b->ranges);
+	init_builder(b);
+}
+
+static void move_builder(struct rl_builder *to, struct rl_builder *from)
+{
+	free_builder(to);
+	*to = *from;
+	if (from->ranges == from->buf)
+		to->ranges = to->buf;
+	init_builder(from);
+}
+
+static void builder_insert(struct rl_builder *b, int idx, sval_t min, sval_t max)
+{
+	if (b->nr == b->alloc) {
+		b->alloc *= 2;
+		if (b->ranges == b->buf) {
+			b->ranges = malloc(b->alloc * sizeof(*b->ranges));
+			memcpy(b->ranges, b->buf, sizeof(b->buf));
+		} else {
+			b->ranges = realloc(b->ranges, b->alloc * sizeof(*b->ranges));
+		}
+		if (!b->ranges)
+			sm_fatal("out of memory building a range list");
+	}
+	memmove(&b->ranges[idx + 1], &b->ranges[idx],
+		(b->nr - idx) * sizeof(*b->ranges));
+	b->ranges[idx].min = min;
+	b->ranges[idx].max = max;
+	b->nr++;
+}
+
+static void builder_delete(struct rl_builder *b, int idx)
+{
+	memmove(&b->ranges[idx], &b->ranges[idx + 1],
+		(b->nr - idx - 1) * sizeof(*b->ranges));
+	b->nr--;
+}
+
+static void load_builder(struct rl_builder *b, struct range_list *rl)
+{
+	struct data_range *tmp;
+
+	FOR_EACH_RANGE(rl, tmp) {
+		builder_insert(b, b->nr, tmp->min, tmp->max);
+	} END_FOR_EACH_RANGE(tmp);
+}
+
+static unsigned int hash_ranges(struct data_range *ranges, int nr)
+{
+	unsigned long long hash = nr;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		hash = hash * 31 + (unsigned long)ranges[i].min.type;
+		hash = hash * 31 + ranges[i].min.uvalue;
+		hash = hash * 31 + (unsigned long)ranges[i].max.type;
+		hash = hash * 31 + ranges[i].max.uvalue;
+	}
+	return hash ^ (hash >> 32);
+}
+
+static bool same_sval(sval_t one, sval_t two)
+{
+	return one.type == two.type && one.uvalue == two.uvalue;
+}
 
-	return alloc_sname(full);
+static bool same_ranges(struct data_range *one, struct data_range *two, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (!same_sval(one[i].min, two[i].min) ||
+		    !same_sval(one[i].max, two[i].max))
+			return false;
+	}
+	return true;
+}
+
+static bool has_fp_ranges(struct data_range *ranges, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (type_is_fp(ranges[i].min.type) ||
+		    type_is_fp(ranges[i].max.type))
+			return true;
+	}
+	return false;
+}
+
+static void grow_rl_table(struct rl_table *table)
+{
+	struct range_list **buckets, *rl, *next;
+	unsigned int size, i;
+
+	size = table->size ? table->size * 2 : 256;
+	buckets = calloc(size, sizeof(*buckets));
+	if (!buckets)
+		sm_fatal("out of memory growing the range list table");
+	for (i = 0; i < table->size; i++) {
+		for (rl = table->buckets[i]; rl; rl = next) {
+			next = rl->next;
+			rl->next = buckets[rl->hash & (size - 1)];
+			buckets[rl->hash & (size - 1)] = rl;
+		}
+	}
+	free(table->buckets);
+	table->buckets = buckets;
+	table->size = size;
+}
+
+static struct range_list *intern_rl(struct data_range *ranges, int nr, bool perm)
+{
+	struct rl_table *table = perm ? &perm_table : &rl_table;
+	struct range_list *rl;
+	unsigned int hash;
+	size_t size;
+	bool fp;
+
+	if (!nr)
+		return NULL;
+
+	fp = has_fp_ranges(ranges, nr);
+	hash = fp ? 0 : hash_ranges(ranges, nr);
+	if (!fp && table->size) {
+		for (rl = table->buckets[hash & (table->size - 1)]; rl; rl = rl->next) {
+			if (rl->hash == hash && rl->nr == nr &&
+			    same_ranges(rl->ranges, ranges, nr))
+				return rl;
+		}
+	}
+
+	size = nr * sizeof(struct data_range);
+	if (sizeof(*rl) + size > RL_BIG_BYTES) {
+		rl = malloc(sizeof(*rl) + size);
+		if (!rl)
+			sm_fatal("out of memory allocating a range list");
+		if (!perm)
+			add_ptr_list(&big_rls, rl);
+	} else if (perm) {
+		rl = __alloc_perm_range_list(size);
+	} else {
+		rl = __alloc_range_list(size);
+	}
+	memcpy(rl->ranges, ranges, size);
+	rl->nr = nr;
+	rl->perm = perm;
+	rl->next = NULL;
+	if (fp) {
+		/* get_shown_rl() finds the float lists by their address */
+		rl->hash = (unsigned long)rl >> 4;
+		return rl;
+	}
+	rl->hash = hash;
+
+	if (table->count >= table->size)
+		grow_rl_table(table);
+	rl->next = table->buckets[hash & (table->size - 1)];
+	table->buckets[hash & (table->size - 1)] = rl;
+	table->count++;
+
+	return rl;
+}
+
+static struct range_list *finish_builder(struct rl_builder *b)
+{
+	struct range_list *rl;
+
+	rl = intern_rl(b->ranges, b->nr, false);
+	free_builder(b);
+	return rl;
+}
+
+static void cast_builder(struct rl_builder *b, struct symbol *type)
+{
+	struct range_list *rl;
+
+	rl = finish_builder(b);
+	rl = cast_rl(type, rl);
+	load_builder(b, rl);
 }
 
 void free_all_rl(void)
 {
-	clear_rl_ptrlist_alloc();
+	struct range_list *rl;
+
+	FOR_EACH_PTR(big_rls, rl) {
+		free(rl);
+	} END_FOR_EACH_PTR(rl);
+	free_ptr_list(&big_rls);
+
+	free(rl_table.buckets);
+	memset(&rl_table, 0, sizeof(rl_table));
+	clear_range_list_alloc();
+
+	clear_rl_text_table(&show_cache);
+	clear_rl_text_alloc();
 }
 
 static int sval_too_big(struct symbol *type, sval_t sval)
@@ -198,22 +614,22 @@ static int truncates_nicely(struct symbol *type, sval_t min, sval_t max)
 	return (min.uvalue & mask) == (max.uvalue & mask);
 }
 
-static void add_range_t(struct symbol *type, struct range_list **rl, sval_t min, sval_t max)
+static void add_range_t(struct symbol *type, struct rl_builder *b, sval_t min, sval_t max)
 {
 	/* If we're just adding a number, cast it and add it */
 	if (sval_cmp(min, max) == 0) {
-		add_range(rl, sval_cast(type, min), sval_cast(type, max));
+		builder_add(b, sval_cast(type, min), sval_cast(type, max));
 		return;
 	}
 
 	/* If the range is within the type range then add it */
 	if (sval_fits(type, min) && sval_fits(type, max)) {
-		add_range(rl, sval_cast(type, min), sval_cast(type, max));
+		builder_add(b, sval_cast(type, min), sval_cast(type, max));
 		return;
 	}
 
 	if (truncates_nicely(type, min, max)) {
-		add_range(rl, sval_cast(type, min), sval_cast(type, max));
+		builder_add(b, sval_cast(type, min), sval_cast(type, max));
 		return;
 	}
 
@@ -224,7 +640,7 @@ static void add_range_t(struct symbol *type, struct range_list **rl, sval_t min,
 	 *
 	 */
 	if (sval_too_big(type, min) || sval_too_big(type, max)) {
-		add_range(rl, sval_type_min(type), sval_type_max(type));
+		builder_add(b, sval_type_min(type), sval_type_max(type));
 		return;
 	}
 
@@ -232,31 +648,31 @@ static void add_range_t(struct symbol *type, struct range_list **rl, sval_t min,
 	if (sval_is_negative(min) && type_unsigned(type)) {
 		if (sval_is_positive(max)) {
 			if (sval_too_high(type, max)) {
-				add_range(rl, sval_type_min(type), sval_type_max(type));
+				builder_add(b, sval_type_min(type), sval_type_max(type));
 				return;
 			}
-			add_range(rl, sval_type_val(type, 0), sval_cast(type, max));
+			builder_add(b, sval_type_val(type, 0), sval_cast(type, max));
 			max = sval_type_max(type);
 		} else {
 			max = sval_cast(type, max);
 		}
 		min = sval_cast(type, min);
-		add_range(rl, min, max);
+		builder_add(b, min, max);
 	}
 
 	/* Cast high positive numbers to negative */
 	if (sval_unsigned(max) && sval_is_negative(sval_cast(type, max))) {
 		if (!sval_is_negative(sval_cast(type, min))) {
-			add_range(rl, sval_cast(type, min), sval_type_max(type));
+			builder_add(b, sval_cast(type, min), sval_type_max(type));
 			min = sval_type_min(type);
 		} else {
 			min = sval_cast(type, min);
 		}
 		max = sval_cast(type, max);
-		add_range(rl, min, max);
+		builder_add(b, min, max);
 	}
 
-	add_range(rl, sval_cast(type, min), sval_cast(type, max));
+	builder_add(b, sval_cast(type, min), sval_cast(type, max));
 	return;
 }
 
@@ -586,20 +1002,21 @@ static struct range_list *get_param_return_rl(struct expression *call, const cha
 
 static void str_to_rl_helper(struct expression *call, struct symbol *type, const char *str, const char **endp, struct range_list **rl)
 {
-	struct range_list *rl_tmp = NULL;
+	struct rl_builder b;
 	sval_t prev_min, min, max;
 	const char *c;
 
 	prev_min = sval_type_min(type);
 	min = sval_type_min(type);
 	max = sval_type_max(type);
+	init_builder(&b);
 	c = str;
 	while (*c != '\0' && *c != '[') {
 		if (*c == '+') {
 			if (sval_cmp(min, sval_type_min(type)) != 0)
 				min = max;
 			max = sval_type_max(type);
-			add_range_t(type, &rl_tmp, min, max);
+			add_range_t(type, &b, min, max);
 			break;
 		}
 		if (*c == '(')
@@ -611,18 +1028,18 @@ static void str_to_rl_helper(struct expression *call, struct symbol *type, const
 		if (*c == ')')
 			c++;
 		if (*c == '\0' || *c == '[') {
-			add_range_t(type, &rl_tmp, min, min);
+			add_range_t(type, &b, min, min);
 			break;
 		}
 		if (*c == ',') {
-			add_range_t(type, &rl_tmp, min, min);
+			add_range_t(type, &b, min, min);
 			c++;
 			continue;
 		}
 		if (*c == '+') {
 			min = prev_min;
 			max = sval_type_max(type);
-			add_range_t(type, &rl_tmp, min, max);
+			add_range_t(type, &b, min, max);
 			c++;
 			if (*c == '[' || *c == '\0')
 				break;
@@ -639,20 +1056,20 @@ static void str_to_rl_helper(struct expression *call, struct symbol *type, const
 			max = sval_type_max(type);
 		if (*c == '+') {
 			max = sval_type_max(type);
-			add_range_t(type, &rl_tmp, min, max);
+			add_range_t(type, &b, min, max);
 			c++;
 			if (*c == '[' || *c == '\0')
 				break;
 		}
 		prev_min = max;
-		add_range_t(type, &rl_tmp, min, max);
+		add_range_t(type, &b, min, max);
 		if (*c == ')')
 			c++;
 		if (*c == ',')
 			c++;
 	}
 
-	*rl = rl_tmp;
+	*rl = finish_builder(&b);
 	*endp = c;
 }
 
@@ -669,6 +1086,10 @@ static void str_to_dinfo(struct expression *call, struct symbol *type, const cha
 	if (strcmp(value, "empty") == 0)
 		return;
 
+	if (!strchr(value, '[') &&
+	    get_parsed_rl(type, value, &dinfo->value_ranges))
+		return;
+
 	if (strncmp(value, "[==$", 4) == 0) {
 		struct expression *arg;
 		int comparison;
@@ -681,8 +1102,12 @@ static void str_to_dinfo(struct expression *call, struct symbol *type, const cha
 	}
 
 	str_to_rl_helper(call, type, value, &c, &rl);
-	if (*c == '\0')
-		goto cast;
+	if (*c == '\0') {
+		rl = cast_rl(type, rl);
+		remember_parsed_rl(type, value, rl);
+		dinfo->value_ranges = rl;
+		return;
+	}
 
 	call_math = jump_to_call_math(value);
 	if (call_math && call_math[0] == 'r') {
@@ -716,14 +1141,14 @@ static int rl_is_sane(struct range_list *rl)
 	struct symbol *type;
 
 	type = rl_type(rl);
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (!sval_fits(type, tmp->min))
 			return 0;
 		if (!sval_fits(type, tmp->max))
 			return 0;
 		if (sval_cmp(tmp->min, tmp->max) > 0)
 			return 0;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 
 	return 1;
 }
@@ -750,9 +1175,9 @@ int is_whole_rl(struct range_list *rl)
 {
 	struct data_range *drange;
 
-	if (ptr_list_empty((struct ptr_list *)rl))
+	if (!rl)
 		return 0;
-	drange = first_ptr_list((struct ptr_list *)rl);
+	drange = &rl->ranges[0];
 	if (sval_is_min(drange->min) && sval_is_max(drange->max))
 		return 1;
 	return 0;
@@ -766,13 +1191,13 @@ int is_unknown_ptr(struct range_list *rl)
 	if (is_whole_rl(rl))
 		return 1;
 
-	FOR_EACH_PTR(rl, drange) {
+	FOR_EACH_RANGE(rl, drange) {
 		if (++cnt >= 3)
 			return 0;
 		if (sval_cmp(drange->min, valid_ptr_min_sval) == 0 &&
 		    sval_cmp(drange->max, valid_ptr_max_sval) == 0)
 			return 1;
-	} END_FOR_EACH_PTR(drange);
+	} END_FOR_EACH_RANGE(drange);
 
 	return 0;
 }
@@ -788,10 +1213,10 @@ bool is_whole_ptr_rl(struct range_list *rl)
 	if (is_whole_rl(rl))
 		return true;
 
-	if (ptr_list_size((struct ptr_list *)rl) != 2)
+	if (rl_nr(rl) != 2)
 		return false;
 
-	FOR_EACH_PTR(rl, drange) {
+	FOR_EACH_RANGE(rl, drange) {
 		cnt++;
 
 		if (cnt == 1) {
@@ -803,7 +1228,7 @@ bool is_whole_ptr_rl(struct range_list *rl)
 			    drange->max.value != ULONG_MAX)
 				return false;
 		}
-	} END_FOR_EACH_PTR(drange);
+	} END_FOR_EACH_RANGE(drange);
 
 	return true;
 }
@@ -812,16 +1237,16 @@ int is_whole_rl_non_zero(struct range_list *rl)
 {
 	struct data_range *drange;
 
-	if (ptr_list_empty((struct ptr_list *)rl))
+	if (!rl)
 		return 0;
-	drange = first_ptr_list((struct ptr_list *)rl);
+	drange = &rl->ranges[0];
 	if (sval_unsigned(drange->min) &&
 	    drange->min.value == 1 &&
 	    sval_is_max(drange->max))
 		return 1;
 	if (!sval_is_min(drange->min) || drange->max.value != -1)
 		return 0;
-	drange = last_ptr_list((struct ptr_list *)rl);
+	drange = &rl->ranges[rl->nr - 1];
 	if (drange->min.value != 1 || !sval_is_max(drange->max))
 		return 0;
 	return 1;
@@ -834,9 +1259,9 @@ sval_t rl_min(struct range_list *rl)
 
 	ret.type = &llong_ctype;
 	ret.value = LLONG_MIN;
-	if (ptr_list_empty((struct ptr_list *)rl))
+	if (!rl)
 		return ret;
-	drange = first_ptr_list((struct ptr_list *)rl);
+	drange = &rl->ranges[0];
 	return drange->min;
 }
 
@@ -847,9 +1272,9 @@ sval_t rl_max(struct range_list *rl)
 
 	ret.type = &llong_ctype;
 	ret.value = LLONG_MAX;
-	if (ptr_list_empty((struct ptr_list *)rl))
+	if (!rl)
 		return ret;
-	drange = last_ptr_list((struct ptr_list *)rl);
+	drange = &rl->ranges[rl->nr - 1];
 	return drange->max;
 }
 
@@ -919,13 +1344,14 @@ struct range_list *alloc_whole_rl(struct symbol *type)
 	return alloc_rl(sval_type_min(type), sval_type_max(type));
 }
 
-static bool collapse_pointer_rl(struct range_list **rl, sval_t min, sval_t max)
+static bool collapse_pointer_rl(struct rl_builder *b, sval_t min, sval_t max)
 {
-	struct range_list *new_rl = NULL;
+	struct rl_builder new;
 	struct data_range *tmp;
 	static bool recurse;
 	bool ret = false;
 	int cnt = 0;
+	int i;
 
 	/*
 	 * With the mtag work, then we end up getting huge lists of mtags.
@@ -942,38 +1368,41 @@ static bool collapse_pointer_rl(struct range_list **rl, sval_t min, sval_t max)
 	if (!type_is_ptr(min.type))
 		goto out;
 
-	if (ptr_list_size((struct ptr_list *)*rl) < 8)
+	if (b->nr < 8)
 		goto out;
-	FOR_EACH_PTR(*rl, tmp) {
-		if (!is_err_ptr(tmp->min))
+	for (i = 0; i < b->nr; i++) {
+		if (!is_err_ptr(b->ranges[i].min))
 			cnt++;
-	} END_FOR_EACH_PTR(tmp);
+	}
 	if (cnt < 8)
 		goto out;
 
-	FOR_EACH_PTR(*rl, tmp) {
+	init_builder(&new);
+	for (i = 0; i < b->nr; i++) {
+		tmp = &b->ranges[i];
 		if (sval_cmp(tmp->min, valid_ptr_min_sval) >= 0 &&
 		    sval_cmp(tmp->max, valid_ptr_max_sval) <= 0)
-			add_range(&new_rl, valid_ptr_min_sval, valid_ptr_max_sval);
+			builder_add(&new, valid_ptr_min_sval, valid_ptr_max_sval);
 		else
-			add_range(&new_rl, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
+			builder_add(&new, tmp->min, tmp->max);
+	}
 
-	add_range(&new_rl, min, max);
+	builder_add(&new, min, max);
 
-	*rl = new_rl;
+	move_builder(b, &new);
 	ret = true;
 out:
 	recurse = false;
 	return ret;
 }
 
-extern int rl_ptrlist_hack;
-void add_range(struct range_list **list, sval_t min, sval_t max)
+static void builder_add(struct rl_builder *b, sval_t min, sval_t max)
 {
+	struct symbol *type;
 	struct data_range *tmp;
-	struct data_range *new = NULL;
 	int check_next = 0;
+	int new = -1;
+	int i;
 
 	/*
 	 * There is at least on valid reason why the types might be confusing
@@ -989,17 +1418,18 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 	 * or we use the bigger size.
 	 *
 	 */
-	if (*list && rl_type(*list) != min.type) {
-		if (rl_type(*list)->type == SYM_PTR) {
-			min = sval_cast(rl_type(*list), min);
-			max = sval_cast(rl_type(*list), max);
+	if (b->nr && b->ranges[0].min.type != min.type) {
+		type = b->ranges[0].min.type;
+		if (type->type == SYM_PTR) {
+			min = sval_cast(type, min);
+			max = sval_cast(type, max);
 		} else if (min.type->type == SYM_PTR) {
-			*list = cast_rl(min.type, *list);
-		} else if (type_bits(rl_type(*list)) >= type_bits(min.type)) {
-			min = sval_cast(rl_type(*list), min);
-			max = sval_cast(rl_type(*list), max);
+			cast_builder(b, min.type);
+		} else if (type_bits(type) >= type_bits(min.type)) {
+			min = sval_cast(type, min);
+			max = sval_cast(type, max);
 		} else {
-			*list = cast_rl(min.type, *list);
+			cast_builder(b, min.type);
 		}
 	}
 
@@ -1008,7 +1438,7 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 		max = sval_type_max(min.type);
 	}
 
-	if (collapse_pointer_rl(list, min, max))
+	if (collapse_pointer_rl(b, min, max))
 		return;
 
 	/*
@@ -1016,14 +1446,15 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 	 * with a range like 1-2.  You end up with min-2,3-max instead of
 	 * just min-max.
 	 */
-	FOR_EACH_PTR(*list, tmp) {
+	for (i = 0; i < b->nr; i++) {
+		tmp = &b->ranges[i];
 		if (check_next) {
 			/* Sometimes we overlap with more than one range
 			   so we have to delete or modify the next range. */
 			if (!sval_is_max(max) && max.value + 1 == tmp->min.value) {
 				/* join 2 ranges here */
-				new->max = tmp->max;
-				DELETE_CURRENT_PTR(tmp);
+				b->ranges[new].max = tmp->max;
+				builder_delete(b, i);
 				return;
 			}
 
@@ -1033,25 +1464,23 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 
 			if (sval_cmp(max, tmp->max) <= 0) {
 				/* Partially overlaps the next one. */
-				new->max = tmp->max;
-				DELETE_CURRENT_PTR(tmp);
+				b->ranges[new].max = tmp->max;
+				builder_delete(b, i);
 				return;
 			} else {
 				/* Completely overlaps the next one. */
-				DELETE_CURRENT_PTR(tmp);
+				builder_delete(b, i--);
 				/* there could be more ranges to delete */
 				continue;
 			}
 		}
 		if (!sval_is_max(max) && max.value + 1 == tmp->min.value) {
 			/* join 2 ranges into a big range */
-			new = alloc_range(min, tmp->max);
-			REPLACE_CURRENT_PTR(tmp, new);
+			tmp->min = min;
 			return;
 		}
 		if (sval_cmp(max, tmp->min) < 0) { /* new range entirely below */
-			new = alloc_range(min, max);
-			INSERT_CURRENT(new, tmp);
+			builder_insert(b, i, min, max);
 			return;
 		}
 		if (sval_cmp(min, tmp->min) < 0) { /* new range partially below */
@@ -1059,8 +1488,9 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 				max = tmp->max;
 			else
 				check_next = 1;
-			new = alloc_range(min, max);
-			REPLACE_CURRENT_PTR(tmp, new);
+			tmp->min = min;
+			tmp->max = max;
+			new = i;
 			if (!check_next)
 				return;
 			continue;
@@ -1069,71 +1499,115 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 			return;
 		if (sval_cmp(min, tmp->max) <= 0) { /* new range partially above */
 			min = tmp->min;
-			new = alloc_range(min, max);
-			REPLACE_CURRENT_PTR(tmp, new);
+			tmp->max = max;
+			new = i;
 			check_next = 1;
 			continue;
 		}
 		if (!sval_is_min(min) && min.value - 1 == tmp->max.value) {
 			/* join 2 ranges into a big range */
-			new = alloc_range(tmp->min, max);
-			REPLACE_CURRENT_PTR(tmp, new);
+			tmp->max = max;
+			new = i;
 			check_next = 1;
 			continue;
 		}
 		/* the new range is entirely above the existing ranges */
-	} END_FOR_EACH_PTR(tmp);
+	}
 	if (check_next)
 		return;
-	new = alloc_range(min, max);
+	builder_insert(b, b->nr, min, max);
+}
+
+void add_range(struct range_list **list, sval_t min, sval_t max)
+{
+	struct rl_builder b;
 
-	rl_ptrlist_hack = 1;
-	add_ptr_list(list, new);
-	rl_ptrlist_hack = 0;
+	init_builder(&b);
+	load_builder(&b, *list);
+	builder_add(&b, min, max);
+	*list = finish_builder(&b);
 }
 
 struct range_list *clone_rl(struct range_list *list)
 {
-	struct data_range *tmp;
-	struct range_list *ret = NULL;
-
-	FOR_EACH_PTR(list, tmp) {
-		add_ptr_list(&ret, tmp);
-	} END_FOR_EACH_PTR(tmp);
-	return ret;
+	/* range lists are never changed so there is nothing to copy */
+	return list;
 }
 
 struct range_list *clone_rl_permanent(struct range_list *list)
+{
+	if (!list || list->perm)
+		return list;
+	return intern_rl(list->ranges, list->nr, true);
+}
+
+/*
+ * The --jobs workers pass range lists back to the parent.  The parent is a
+ * fork() of the worker so the types are the same there, except for the
+ * pointer types which get_type() sometimes allocates on the fly.
+ */
+static struct symbol *worker_sval_type(struct symbol *type)
+{
+	if (type && type->type == SYM_PTR)
+		return &ptr_ctype;
+	return type;
+}
+
+void save_worker_rl(struct range_list *rl)
 {
 	struct data_range *tmp;
-	struct data_range *new;
-	struct range_list *ret = NULL;
+	sval_t min, max;
+	int nr = rl ? rl->nr : 0;
 
-	FOR_EACH_PTR(list, tmp) {
-		new = alloc_range_perm(tmp->min, tmp->max);
-		add_ptr_list(&ret, new);
-	} END_FOR_EACH_PTR(tmp);
-	return ret;
+	save_worker_bytes(&nr, sizeof(nr));
+	FOR_EACH_RANGE(rl, tmp) {
+		min = tmp->min;
+		max = tmp->max;
+		min.type = worker_sval_type(min.type);
+		max.type = worker_sval_type(max.type);
+		save_worker_bytes(&min, sizeof(min));
+		save_worker_bytes(&max, sizeof(max));
+	} END_FOR_EACH_RANGE(tmp);
+}
+
+struct range_list *load_worker_rl(FILE *fp)
+{
+	struct rl_builder b;
+	sval_t min, max;
+	int nr;
+
+	load_worker_bytes(fp, &nr, sizeof(nr));
+	if (!nr)
+		return NULL;
+
+	init_builder(&b);
+	while (nr--) {
+		load_worker_bytes(fp, &min, sizeof(min));
+		load_worker_bytes(fp, &max, sizeof(max));
+		builder_add(&b, min, max);
+	}
+	return finish_builder(&b);
 }
 
 struct range_list *rl_union(struct range_list *one, struct range_list *two)
 {
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 
-	FOR_EACH_PTR(one, tmp) {
-		add_range(&ret, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
-	FOR_EACH_PTR(two, tmp) {
-		add_range(&ret, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
-	return ret;
+	init_builder(&b);
+	FOR_EACH_RANGE(one, tmp) {
+		builder_add(&b, tmp->min, tmp->max);
+	} END_FOR_EACH_RANGE(tmp);
+	FOR_EACH_RANGE(two, tmp) {
+		builder_add(&b, tmp->min, tmp->max);
+	} END_FOR_EACH_RANGE(tmp);
+	return finish_builder(&b);
 }
 
 struct range_list *remove_range(struct range_list *list, sval_t min, sval_t max)
 {
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 
 	if (!list)
 		return NULL;
@@ -1146,31 +1620,32 @@ struct range_list *remove_range(struct range_list *list, sval_t min, sval_t max)
 		max = tmp;
 	}
 
-	FOR_EACH_PTR(list, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(list, tmp) {
 		if (sval_cmp(tmp->max, min) < 0) {
-			add_range(&ret, tmp->min, tmp->max);
+			builder_add(&b, tmp->min, tmp->max);
 			continue;
 		}
 		if (sval_cmp(tmp->min, max) > 0) {
-			add_range(&ret, tmp->min, tmp->max);
+			builder_add(&b, tmp->min, tmp->max);
 			continue;
 		}
 		if (sval_cmp(tmp->min, min) >= 0 && sval_cmp(tmp->max, max) <= 0)
 			continue;
 		if (sval_cmp(tmp->min, min) >= 0) {
 			max.value++;
-			add_range(&ret, max, tmp->max);
+			builder_add(&b, max, tmp->max);
 		} else if (sval_cmp(tmp->max, max) <= 0) {
 			min.value--;
-			add_range(&ret, tmp->min, min);
+			builder_add(&b, tmp->min, min);
 		} else {
 			min.value--;
 			max.value++;
-			add_range(&ret, tmp->min, min);
-			add_range(&ret, max, tmp->max);
+			builder_add(&b, tmp->min, min);
+			builder_add(&b, max, tmp->max);
 		}
-	} END_FOR_EACH_PTR(tmp);
-	return ret;
+	} END_FOR_EACH_RANGE(tmp);
+	return finish_builder(&b);
 }
 
 int ranges_equiv(struct data_range *one, struct data_range *two)
@@ -1188,28 +1663,32 @@ int ranges_equiv(struct data_range *one, struct data_range *two)
 
 int rl_equiv(struct range_list *one, struct range_list *two)
 {
-	struct data_range *one_range;
-	struct data_range *two_range;
+	int i;
 
 	if (one == two)
 		return 1;
 
-	PREPARE_PTR_LIST(one, one_range);
-	PREPARE_PTR_LIST(two, two_range);
-	for (;;) {
-		if (!one_range && !two_range)
-			return 1;
-		if (!ranges_equiv(one_range, two_range))
+	/*
+	 * Identical lists are the same pointer but sval_cmp() also says that
+	 * ranges of different types are equal if the values are the same.
+	 */
+	if (rl_nr(one) != rl_nr(two))
+		return 0;
+	for (i = 0; i < one->nr; i++) {
+		if (!ranges_equiv(&one->ranges[i], &two->ranges[i]))
 			return 0;
-		NEXT_PTR_LIST(one_range);
-		NEXT_PTR_LIST(two_range);
 	}
-	FINISH_PTR_LIST(two_range);
-	FINISH_PTR_LIST(one_range);
 
 	return 1;
 }
 
+int rl_nr(struct range_list *rl)
+{
+	if (!rl)
+		return 0;
+	return rl->nr;
+}
+
 int true_comparison_range(struct data_range *left, int comparison, struct data_range *right)
 {
 	switch (comparison) {
@@ -1336,12 +1815,12 @@ int possibly_true(struct expression *left, int comparison, struct expression *ri
 	rl_left = cast_rl(type, rl_left);
 	rl_right = cast_rl(type, rl_right);
 
-	FOR_EACH_PTR(rl_left, tmp_left) {
-		FOR_EACH_PTR(rl_right, tmp_right) {
+	FOR_EACH_RANGE(rl_left, tmp_left) {
+		FOR_EACH_RANGE(rl_right, tmp_right) {
 			if (true_comparison_range(tmp_left, comparison, tmp_right))
 				return 1;
-		} END_FOR_EACH_PTR(tmp_right);
-	} END_FOR_EACH_PTR(tmp_left);
+		} END_FOR_EACH_RANGE(tmp_right);
+	} END_FOR_EACH_RANGE(tmp_left);
 	return 0;
 }
 
@@ -1365,12 +1844,12 @@ int possibly_false(struct expression *left, int comparison, struct expression *r
 	rl_left = cast_rl(type, rl_left);
 	rl_right = cast_rl(type, rl_right);
 
-	FOR_EACH_PTR(rl_left, tmp_left) {
-		FOR_EACH_PTR(rl_right, tmp_right) {
+	FOR_EACH_RANGE(rl_left, tmp_left) {
+		FOR_EACH_RANGE(rl_right, tmp_right) {
 			if (false_comparison_range_sval(tmp_left, comparison, tmp_right))
 				return 1;
-		} END_FOR_EACH_PTR(tmp_right);
-	} END_FOR_EACH_PTR(tmp_left);
+		} END_FOR_EACH_RANGE(tmp_right);
+	} END_FOR_EACH_RANGE(tmp_left);
 	return 0;
 }
 
@@ -1391,12 +1870,12 @@ int possibly_true_rl(struct range_list *left_ranges, int comparison, struct rang
 	left_ranges = cast_rl(type, left_ranges);
 	right_ranges = cast_rl(type, right_ranges);
 
-	FOR_EACH_PTR(left_ranges, left_tmp) {
-		FOR_EACH_PTR(right_ranges, right_tmp) {
+	FOR_EACH_RANGE(left_ranges, left_tmp) {
+		FOR_EACH_RANGE(right_ranges, right_tmp) {
 			if (true_comparison_range(left_tmp, comparison, right_tmp))
 				return 1;
-		} END_FOR_EACH_PTR(right_tmp);
-	} END_FOR_EACH_PTR(left_tmp);
+		} END_FOR_EACH_RANGE(right_tmp);
+	} END_FOR_EACH_RANGE(left_tmp);
 	return 0;
 }
 
@@ -1417,12 +1896,12 @@ int possibly_false_rl(struct range_list *left_ranges, int comparison, struct ran
 	left_ranges = cast_rl(type, left_ranges);
 	right_ranges = cast_rl(type, right_ranges);
 
-	FOR_EACH_PTR(left_ranges, left_tmp) {
-		FOR_EACH_PTR(right_ranges, right_tmp) {
+	FOR_EACH_RANGE(left_ranges, left_tmp) {
+		FOR_EACH_RANGE(right_ranges, right_tmp) {
 			if (false_comparison_range_sval(left_tmp, comparison, right_tmp))
 				return 1;
-		} END_FOR_EACH_PTR(right_tmp);
-	} END_FOR_EACH_PTR(left_tmp);
+		} END_FOR_EACH_RANGE(right_tmp);
+	} END_FOR_EACH_RANGE(left_tmp);
 	return 0;
 }
 
@@ -1447,19 +1926,14 @@ int rl_has_sval(struct range_list *rl, sval_t sval)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (sval_cmp(tmp->min, sval) <= 0 &&
 		    sval_cmp(tmp->max, sval) >= 0)
 			return 1;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 0;
 }
 
-void tack_on(struct range_list **list, struct data_range *drange)
-{
-	add_ptr_list(list, drange);
-}
-
 void push_rl(struct range_list_stack **rl_stack, struct range_list *rl)
 {
 	add_ptr_list(rl_stack, rl);
@@ -1494,7 +1968,7 @@ void filter_top_rl(struct range_list_stack **rl_stack, struct range_list *filter
 struct range_list *rl_truncate_cast(struct symbol *type, struct range_list *rl)
 {
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 	sval_t min, max;
 
 	if (!rl)
@@ -1503,7 +1977,8 @@ struct range_list *rl_truncate_cast(struct symbol *type, struct range_list *rl)
 	if (!type || type == rl_type(rl))
 		return rl;
 
-	FOR_EACH_PTR(rl, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(rl, tmp) {
 		min = tmp->min;
 		max = tmp->max;
 		if (type_bits(type) < type_bits(rl_type(rl))) {
@@ -1514,10 +1989,10 @@ struct range_list *rl_truncate_cast(struct symbol *type, struct range_list *rl)
 			min = sval_cast(type, min);
 			max = sval_cast(type, max);
 		}
-		add_range_t(type, &ret, min, max);
-	} END_FOR_EACH_PTR(tmp);
+		add_range_t(type, &b, min, max);
+	} END_FOR_EACH_RANGE(tmp);
 
-	return ret;
+	return finish_builder(&b);
 }
 
 int rl_fits_in_type(struct range_list *rl, struct symbol *type)
@@ -1538,10 +2013,10 @@ static int rl_type_consistent(struct range_list *rl)
 	struct symbol *type;
 
 	type = rl_type(rl);
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (type != tmp->min.type || type != tmp->max.type)
 			return 0;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 	return 1;
 }
 
@@ -1554,7 +2029,7 @@ static struct range_list *cast_to_bool(struct range_list *rl)
 	sval_t min = { .type = &bool_ctype };
 	sval_t max = { .type = &bool_ctype };
 
-	FOR_EACH_PTR(rl, tmp) {
+	FOR_EACH_RANGE(rl, tmp) {
 		if (tmp->min.value || tmp->max.value)
 			has_one = 1;
 		if (sval_is_negative(tmp->min) &&
@@ -1566,7 +2041,7 @@ static struct range_list *cast_to_bool(struct range_list *rl)
 		if (sval_is_negative(tmp->min) &&
 		    tmp->max.value > 0)
 			has_zero = 1;
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 
 	if (!has_zero)
 		min.value = 1;
@@ -1580,7 +2055,8 @@ static struct range_list *cast_to_bool(struct range_list *rl)
 struct range_list *cast_rl(struct symbol *type, struct range_list *rl)
 {
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct range_list *ret;
+	struct rl_builder b;
 
 	if (!rl)
 		return NULL;
@@ -1595,9 +2071,11 @@ struct range_list *cast_rl(struct symbol *type, struct range_list *rl)
 	if (type == &bool_ctype)
 		return cast_to_bool(rl);
 
-	FOR_EACH_PTR(rl, tmp) {
-		add_range_t(type, &ret, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
+	init_builder(&b);
+	FOR_EACH_RANGE(rl, tmp) {
+		add_range_t(type, &b, tmp->min, tmp->max);
+	} END_FOR_EACH_RANGE(tmp);
+	ret = finish_builder(&b);
 
 	if (!ret)
 		return alloc_whole_rl(type);
@@ -1609,9 +2087,9 @@ struct range_list *rl_filter(struct range_list *rl, struct range_list *filter)
 {
 	struct data_range *tmp;
 
-	FOR_EACH_PTR(filter, tmp) {
+	FOR_EACH_RANGE(filter, tmp) {
 		rl = remove_range(rl, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
+	} END_FOR_EACH_RANGE(tmp);
 
 	return rl;
 }
@@ -1619,50 +2097,47 @@ struct range_list *rl_filter(struct range_list *rl, struct range_list *filter)
 struct range_list *do_intersection(struct range_list *one_rl, struct range_list *two_rl)
 {
 	struct data_range *one, *two;
-	struct range_list *ret = NULL;
-
-
-	PREPARE_PTR_LIST(one_rl, one);
-	PREPARE_PTR_LIST(two_rl, two);
+	struct rl_builder b;
+	int i = 0, j = 0;
 
+	init_builder(&b);
 	while (true) {
-		if (!one || !two)
+		if (i >= rl_nr(one_rl) || j >= rl_nr(two_rl))
 			break;
+		one = &one_rl->ranges[i];
+		two = &two_rl->ranges[j];
 		if (sval_cmp(one->max, two->min) < 0) {
-			NEXT_PTR_LIST(one);
+			i++;
 			continue;
 		}
 		if (sval_cmp(one->min, two->min) < 0 && sval_cmp(one->max, two->max) <= 0) {
-			add_range(&ret, two->min, one->max);
-			NEXT_PTR_LIST(one);
+			builder_add(&b, two->min, one->max);
+			i++;
 			continue;
 		}
 		if (sval_cmp(one->min, two->min) >= 0 && sval_cmp(one->max, two->max) <= 0) {
-			add_range(&ret, one->min, one->max);
-			NEXT_PTR_LIST(one);
+			builder_add(&b, one->min, one->max);
+			i++;
 			continue;
 		}
 		if (sval_cmp(one->min, two->min) < 0 && sval_cmp(one->max, two->max) > 0) {
-			add_range(&ret, two->min, two->max);
-			NEXT_PTR_LIST(two);
+			builder_add(&b, two->min, two->max);
+			j++;
 			continue;
 		}
 		if (sval_cmp(one->min, two->max) <= 0 && sval_cmp(one->max, two->max) > 0) {
-			add_range(&ret, one->min, two->max);
-			NEXT_PTR_LIST(two);
+			builder_add(&b, one->min, two->max);
+			j++;
 			continue;
 		}
 		if (sval_cmp(one->min, two->max) <= 0) {
 			sm_fatal("error calculating intersection of '%s' and '%s'", show_rl(one_rl), show_rl(two_rl));
 			return NULL;
 		}
-		NEXT_PTR_LIST(two);
+		j++;
 	}
 
-	FINISH_PTR_LIST(two);
-	FINISH_PTR_LIST(one);
-
-	return ret;
+	return finish_builder(&b);
 }
 
 struct range_list *rl_intersection(struct range_list *one, struct range_list *two)
@@ -1715,52 +2190,54 @@ static struct range_list *get_neg_rl(struct range_list *rl)
 {
 	struct data_range *tmp;
 	struct data_range *new;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 
 	if (!rl)
 		return NULL;
 	if (sval_is_positive(rl_min(rl)))
 		return NULL;
 
-	FOR_EACH_PTR(rl, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(rl, tmp) {
 		if (sval_is_positive(tmp->min))
 			break;
 		if (sval_is_positive(tmp->max)) {
 			new = alloc_range(tmp->min, tmp->max);
 			new->max.value = -1;
-			add_range(&ret, new->min, new->max);
+			builder_add(&b, new->min, new->max);
 			break;
 		}
-		add_range(&ret, tmp->min, tmp->max);
-	} END_FOR_EACH_PTR(tmp);
+		builder_add(&b, tmp->min, tmp->max);
+	} END_FOR_EACH_RANGE(tmp);
 
-	return ret;
+	return finish_builder(&b);
 }
 
 static struct range_list *get_pos_rl(struct range_list *rl)
 {
 	struct data_range *tmp;
 	struct data_range *new;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 
 	if (!rl)
 		return NULL;
 	if (sval_is_negative(rl_max(rl)))
 		return NULL;
 
-	FOR_EACH_PTR(rl, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(rl, tmp) {
 		if (sval_is_negative(tmp->max))
 			continue;
 		if (sval_is_positive(tmp->min)) {
-			add_range(&ret, tmp->min, tmp->max);
+			builder_add(&b, tmp->min, tmp->max);
 			continue;
 		}
 		new = alloc_range(tmp->min, tmp->max);
 		new->min.value = 0;
-		add_range(&ret, new->min, new->max);
-	} END_FOR_EACH_PTR(tmp);
+		builder_add(&b, new->min, new->max);
+	} END_FOR_EACH_RANGE(tmp);
 
-	return ret;
+	return finish_builder(&b);
 }
 
 static struct range_list *divide_rl_helper(struct range_list *left, struct range_list *right)
@@ -2008,7 +2485,8 @@ static struct range_list *handle_lshift(struct range_list *left_orig, struct ran
 {
 	struct range_list *left;
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct range_list *ret;
+	struct rl_builder b;
 	sval_t zero = { .type = rl_type(left_orig), };
 	sval_t shift, min, max;
 	bool add_zero = false;
@@ -2026,7 +2504,8 @@ static struct range_list *handle_lshift(struct range_list *left_orig, struct ran
 	else
 		left = left_orig;
 
-	FOR_EACH_PTR(left, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(left, tmp) {
 		min = tmp->min;
 		max = tmp->max;
 
@@ -2038,8 +2517,9 @@ static struct range_list *handle_lshift(struct range_list *left_orig, struct ran
 			min.value = 1;
 		min = sval_binop(min, SPECIAL_LEFTSHIFT, shift);
 		max = sval_binop(max, SPECIAL_LEFTSHIFT, shift);
-		add_range(&ret, min, max);
-	} END_FOR_EACH_PTR(tmp);
+		builder_add(&b, min, max);
+	} END_FOR_EACH_RANGE(tmp);
+	ret = finish_builder(&b);
 
 	if (!rl_fits_in_type(ret, rl_type(left_orig)))
 		add_zero = true;
@@ -2053,7 +2533,7 @@ static struct range_list *handle_lshift(struct range_list *left_orig, struct ran
 static struct range_list *handle_rshift(struct range_list *left_orig, struct range_list *right_orig)
 {
 	struct data_range *tmp;
-	struct range_list *ret = NULL;
+	struct rl_builder b;
 	sval_t shift, min, max;
 
 	if (!rl_to_sval(right_orig, &shift) || sval_is_negative(shift))
@@ -2061,13 +2541,14 @@ static struct range_list *handle_rshift(struct range_list *left_orig, struct ran
 	if (shift.value == 0)
 		return left_orig;
 
-	FOR_EACH_PTR(left_orig, tmp) {
+	init_builder(&b);
+	FOR_EACH_RANGE(left_orig, tmp) {
 		min = sval_binop(tmp->min, SPECIAL_RIGHTSHIFT, shift);
 		max = sval_binop(tmp->max, SPECIAL_RIGHTSHIFT, shift);
-		add_range(&ret, min, max);
-	} END_FOR_EACH_PTR(tmp);
+		builder_add(&b, min, max);
+	} END_FOR_EACH_RANGE(tmp);
 
-	return ret;
+	return finish_builder(&b);
 }
 
 struct range_list *rl_binop(struct range_list *left, int op, struct range_list *right)
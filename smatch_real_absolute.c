@@ -116,8 +116,6 @@ static void match_assign(struct expression *expr)
 	struct symbol *type;
 	sval_t sval;
 
-	if (expr->op != '=')
-		return;
 	if (is_fake_call(expr->right))
 		return;
 	if (in_iterator_pre_statement())
@@ -162,6 +160,6 @@ void register_real_absolute(int id)
 	add_merge_hook(my_id, &merge_estates);
 	add_extra_mod_hook(&extra_mod_hook);
 
-	add_hook(&match_assign, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assign, ASSIGNMENT_HOOK, '=');
 }
 
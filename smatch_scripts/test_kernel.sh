@@ -65,12 +65,15 @@ fi
 
 make $KERNEL_ARCH $KERNEL_CROSS_COMPILE clean
 find -name \*.c.smatch -exec rm \{\} \;
+find -name \*.c.smatch.db -exec rm \{\} \;
 make $KERNEL_ARCH $KERNEL_CROSS_COMPILE -j${NR_CPU} $ENDIAN -k CHECK="$CMD -p=kernel --file-output --succeed $*" \
 	C=1 $BUILD_PARAM $TARGET 2>&1 | tee $LOG
 BUILD_STATUS=${PIPESTATUS[0]}
 find -name \*.c.smatch -exec cat \{\} \; -exec rm \{\} \; > $WLOG
 find -name \*.c.smatch.sql -exec cat \{\} \; -exec rm \{\} \; > $WLOG.sql
 find -name \*.c.smatch.caller_info -exec cat \{\} \; -exec rm \{\} \; > $WLOG.caller_info
+find -name \*.c.smatch.sqlb -exec cat \{\} \; -exec rm \{\} \; > $WLOG.sqlb
+find $PWD -name \*.c.smatch.db > $WLOG.shards
 
 echo "Done. Build with status $BUILD_STATUS. The warnings are saved to $WLOG"
 exit $BUILD_STATUS
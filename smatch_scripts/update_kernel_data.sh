@@ -0,0 +1,120 @@
+#!/bin/bash
+
+#
+# Re-runs Smatch on the files where the source or one of the headers has
+# changed since smatch_db.sqlite was built and updates the database in
+# place.  The database has to be built with --info-db the first time.
+#
+# Then the files which call a function whose return_states changed, or
+# which have a function whose caller_info changed, are checked again until
+# nothing changes or until $MAX_ITERATIONS.
+#
+
+PROJECT=kernel
+WLOG=smatch_warns.txt
+MAX_ITERATIONS=${MAX_ITERATIONS:-8}
+
+function usage {
+    echo
+    echo "Usage:  $0"
+    echo "Re-checks the changed files and updates the smatch database"
+    echo "until it reaches a fixed point.  Set MAX_ITERATIONS to limit the runs."
+    echo
+    exit 1
+}
+
+if [ "$1" = "-h" ] || [ "$1" = "--help" ] ; then
+	usage;
+fi
+
+SCRIPT_DIR=$(dirname $0)
+if [ -e $SCRIPT_DIR/../smatch -a -d kernel -a -d fs ] ; then
+    CMD=$SCRIPT_DIR/../smatch
+    DATA_DIR=$SCRIPT_DIR/../smatch_data
+else
+    echo "This script should be located in the smatch_scripts/ subdirectory of the smatch source."
+    echo "It should be run from the root of a kernel source tree."
+    exit 1
+fi
+
+if [[ ! -z $ARCH ]]; then
+	KERNEL_ARCH="ARCH=$ARCH"
+fi
+if [[ ! -z $CROSS_COMPILE ]] ; then
+	KERNEL_CROSS_COMPILE="CROSS_COMPILE=$CROSS_COMPILE"
+fi
+
+#
+# Check the files again and replace their warnings and shards.
+#
+function check_files {
+    local file objs status
+
+    for file in $* ; do
+	if [ -e $file ] ; then
+	    objs="$objs ${file%.c}.o"
+	else
+	    rm -f $file.smatch.db
+	fi
+    done
+
+    if [ "$objs" != "" ] ; then
+	# C=2 runs the checker even if the object is up to date
+	make $KERNEL_ARCH $KERNEL_CROSS_COMPILE -j$(nproc) -k C=2 \
+	    CHECK="$CMD -p=$PROJECT --file-output --succeed --call-tree --info --info-db --spammy --data=$DATA_DIR" \
+	    $objs 2>&1 | tee -a smatch_compile.warns
+	status=${PIPESTATUS[0]}
+	[ $status -eq 0 ] || BUILD_STATUS=$status
+    fi
+
+    for file in $* ; do
+	echo $file
+    done > $WLOG.changed
+    awk 'FNR == NR { changed[$0] = 1; next }
+	 { split($1, a, ":"); if (!(a[1] in changed)) print }' $WLOG.changed $WLOG > $WLOG.new
+    find -name \*.c.smatch -exec cat \{\} \; -exec rm \{\} \; >> $WLOG.new
+    mv $WLOG.new $WLOG
+    rm -f $WLOG.changed
+
+    find $PWD -name \*.c.smatch.db > $WLOG.shards
+
+    for i in $SCRIPT_DIR/gen_* ; do
+	$i $WLOG -p=$PROJECT
+    done
+    mv ${PROJECT}.* $DATA_DIR
+}
+
+BUILD_STATUS=0
+if [ ! -e smatch_db.sqlite ] || [ ! -e $WLOG.shards ] || \
+   [ "$(echo 'select count(*) from file_deps;' | sqlite3 smatch_db.sqlite 2>/dev/null)" = "" ] ; then
+    echo "Building the database from scratch."
+    $SCRIPT_DIR/test_kernel.sh --call-tree --info --info-db --spammy --data=$DATA_DIR || BUILD_STATUS=$?
+    $DATA_DIR/db/create_db.sh -p=$PROJECT $WLOG
+    # the first run didn't have a database so everything is out of date
+    files=$(echo "select distinct file from file_deps;" | sqlite3 smatch_db.sqlite)
+else
+    changed=$(echo "select distinct hash || '  ' || dep from file_deps;" | \
+	      sqlite3 smatch_db.sqlite | md5sum -c --quiet 2>/dev/null | \
+	      sed -n -e 's/: FAILED.*//p')
+
+    files=$( (echo "create temp table changed (dep varchar(256));"
+	      for dep in $changed ; do
+		  echo "insert into changed values ('$dep');"
+	      done
+	      echo "select distinct file from file_deps where dep in (select dep from changed);") | \
+	      sqlite3 smatch_db.sqlite)
+fi
+
+for iteration in $(seq 1 $MAX_ITERATIONS) ; do
+    check_files $files
+    $DATA_DIR/db/update_db.sh -p=$PROJECT $WLOG
+
+    files=$(cat $WLOG.rerun 2>/dev/null)
+    if [ "$files" = "" ] ; then
+	echo "Reached a fixed point after $iteration iterations."
+	break
+    fi
+    echo "Iteration $iteration: $(echo $files | wc -w) files to check again."
+done
+
+exit $BUILD_STATUS
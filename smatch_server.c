@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2021 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * When we check a kernel, make starts a new smatch for every file and each
+ * one opens the database, loads the smatch_data/ files, builds the hook
+ * tables and registers all the checks before it looks at the file.
+ *
+ * "smatch --server=<socket> [smatch options]" does that setup once and
+ * then waits for connections.  "smatch --client=<socket> [cflags] file.c"
+ * sends its working directory, the command line and its stdin, stdout and
+ * stderr to the server.  The server forks a child for each connection which
+ * runs sparse_initialize() with those arguments, checks the files, and
+ * sends back the exit code.  Because each file is checked in a fresh fork
+ * nothing one file does can leak into the next one, and make -j works the
+ * same way as before.
+ *
+ * The checks and the smatch options come from the server's command line.
+ * The client only passes on the compiler flags and the file names, so it
+ * can be used as CHECK="smatch --client=<socket>".
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "smatch.h"
+
+#define SERVER_NR_FDS 3
+
+static int fill_addr(struct sockaddr_un *addr, const char *path)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr->sun_path))
+		return -1;
+	strcpy(addr->sun_path, path);
+	return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t ret;
+
+	while (len) {
+		ret = write(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	char *p = buf;
+	ssize_t ret;
+
+	while (len) {
+		ret = read(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+/*
+ * The request is the length of the strings with the client's stdin, stdout
+ * and stderr attached, and then the working directory and the arguments,
+ * each with a NUL after it.
+ */
+static int send_request(int sock, const char *buf, unsigned int len)
+{
+	char control[CMSG_SPACE(sizeof(int) * SERVER_NR_FDS)];
+	int fds[SERVER_NR_FDS] = { 0, 1, 2 };
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+
+	iov.iov_base = &len;
+	iov.iov_len = sizeof(len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(sock, &msg, 0) != sizeof(len))
+		return -1;
+	return write_all(sock, buf, len);
+}
+
+int smatch_client(const char *path, int argc, char **argv)
+{
+	struct sockaddr_un addr;
+	char *buf, *cwd, *p;
+	unsigned int len;
+	int sock, status;
+	int i;
+
+	if (fill_addr(&addr, path))
+		sm_fatal("socket path too long: '%s'", path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)))
+		sm_fatal("cannot connect to smatch server '%s': %s", path, strerror(errno));
+
+	cwd = getcwd(NULL, 0);
+	if (!cwd)
+		sm_fatal("getcwd: %s", strerror(errno));
+	len = strlen(cwd) + 1;
+	for (i = 0; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+	buf = malloc(len);
+	p = stpcpy(buf, cwd) + 1;
+	for (i = 0; i < argc; i++)
+		p = stpcpy(p, argv[i]) + 1;
+
+	if (send_request(sock, buf, len))
+		sm_fatal("cannot send to smatch server '%s'", path);
+	free(buf);
+	free(cwd);
+
+	if (read_all(sock, &status, sizeof(status))) {
+		fprintf(stderr, "smatch: the server died while checking %s\n",
+			argc > 1 ? argv[argc - 1] : "");
+		return 1;
+	}
+	close(sock);
+	return status;
+}
+
+static int recv_request(int sock, int *fds, char **bufp, unsigned int *lenp)
+{
+	char control[CMSG_SPACE(sizeof(int) * SERVER_NR_FDS)];
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	unsigned int len;
+	char *buf;
+
+	iov.iov_base = &len;
+	iov.iov_len = sizeof(len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	if (recvmsg(sock, &msg, 0) != sizeof(len))
+		return -1;
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(int) * SERVER_NR_FDS))
+		return -1;
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * SERVER_NR_FDS);
+
+	if (!len || len > 1024 * 1024)
+		return -1;
+	buf = malloc(len);
+	if (read_all(sock, buf, len) || buf[len - 1] != '\0') {
+		free(buf);
+		return -1;
+	}
+	*bufp = buf;
+	*lenp = len;
+	return 0;
+}
+
+static void __attribute__((noreturn)) handle_client(int sock)
+{
+	int fds[SERVER_NR_FDS];
+	unsigned int len;
+	char **argv;
+	char *buf, *p;
+	int argc = 0;
+	int status;
+	int i;
+
+	if (recv_request(sock, fds, &buf, &len))
+		_exit(1);
+
+	for (i = 0; i < SERVER_NR_FDS; i++) {
+		dup2(fds[i], i);
+		close(fds[i]);
+	}
+
+	/* the first string is the working directory */
+	argv = malloc(sizeof(*argv) * (len + 1));
+	for (p = buf + strlen(buf) + 1; p < buf + len; p += strlen(p) + 1)
+		argv[argc++] = p;
+	argv[argc] = NULL;
+	if (chdir(buf))
+		sm_fatal("chdir '%s': %s", buf, strerror(errno));
+
+	status = argc < 2 ? 1 : check_files(argc, argv);
+	fflush(NULL);
+	write_all(sock, &status, sizeof(status));
+	exit(status);
+}
+
+void smatch_server(const char *path)
+{
+	struct sockaddr_un addr;
+	int sock, conn;
+
+	if (fill_addr(&addr, path))
+		sm_fatal("socket path too long: '%s'", path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0)
+		sm_fatal("socket: %s", strerror(errno));
+	unlink(path);
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(sock, SOMAXCONN))
+		sm_fatal("cannot listen on '%s': %s", path, strerror(errno));
+
+	/* nobody waits for the children */
+	signal(SIGCHLD, SIG_IGN);
+	fflush(NULL);
+
+	while (1) {
+		conn = accept(sock, NULL, NULL);
+		if (conn < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			sm_fatal("accept: %s", strerror(errno));
+		}
+		switch (fork()) {
+		case -1:
+			sm_fatal("fork: %s", strerror(errno));
+		case 0:
+			close(sock);
+			handle_client(conn);
+		}
+		close(conn);
+	}
+}
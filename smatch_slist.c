@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include "smatch.h"
 #include "smatch_slist.h"
+#include "smatch_function_hashtable.h"
 
 #undef CHECKORDER
 
@@ -29,6 +30,16 @@ __DO_ALLOCATOR(char, 1, 4, "state names", sname);
 
 int sm_state_counter;
 
+/*
+ * The same names are used over and over so the sm_states share one copy
+ * of each name.  That way cmp_tracker() can tell that two names are the
+ * same by comparing the pointers.  The names are freed at the end of the
+ * function along with the sm_states.
+ */
+static struct hashtable *sm_names;
+static DEFINE_HASHTABLE_INSERT(insert_sm_name, char, char);
+static DEFINE_HASHTABLE_SEARCH(search_sm_name, char, char);
+
 static struct stree_stack *all_pools;
 
 const char *show_sm(struct sm_state *sm)
@@ -104,11 +115,13 @@ int cmp_tracker(const struct sm_state *a, const struct sm_state *b)
 	if (a->owner > b->owner)
 		return 1;
 
-	ret = strcmp(a->name, b->name);
-	if (ret < 0)
-		return -1;
-	if (ret > 0)
-		return 1;
+	if (a->name != b->name) {
+		ret = strcmp(a->name, b->name);
+		if (ret < 0)
+			return -1;
+		if (ret > 0)
+			return 1;
+	}
 
 	if (!b->sym && a->sym)
 		return -1;
@@ -185,14 +198,34 @@ static int cmp_possible_sm(const struct sm_state *a, const struct sm_state *b, i
 	return strcmp(a->state->name, b->state->name);
 }
 
+static const char *get_sm_name(const char *name)
+{
+	char *ret;
+
+	if (!name)
+		return NULL;
+
+	if (!sm_names)
+		sm_names = create_function_hashtable(4000);
+	ret = search_sm_name(sm_names, (char *)name);
+	if (ret)
+		return ret;
+	ret = strdup(name);
+	insert_sm_name(sm_names, ret, ret);
+	return ret;
+}
+
 struct sm_state *alloc_sm_state(int owner, const char *name,
 				struct symbol *sym, struct smatch_state *state)
 {
 	struct sm_state *sm_state = __alloc_sm_state(0);
 
 	sm_state_counter++;
+	add_work(1);
+	if (option_profile)
+		profile_sm_state(owner);
 
-	sm_state->name = alloc_sname(name);
+	sm_state->name = get_sm_name(name);
 	sm_state->owner = owner;
 	sm_state->sym = sym;
 	sm_state->state = state;
@@ -308,7 +341,7 @@ int out_of_memory(void)
 	 * the next function an extra 100MB to work with.
 	 *
 	 */
-	if (get_mem_kb() > oom_limit) {
+	if (get_mem_kb_cheap() > oom_limit) {
 		oom_func = cur_func_sym;
 		final_pass++;
 		sm_perror("OOM: %luKb sm_state_count = %d", get_mem_kb(), sm_state_counter);
@@ -367,6 +400,11 @@ void free_every_single_sm_state(void)
 	}
 	clear_sname_alloc();
 	clear_smatch_state_alloc();
+	if (sm_names) {
+		/* this frees the names as well */
+		destroy_function_hashtable(sm_names);
+		sm_names = NULL;
+	}
 
 	free_stack_and_strees(&all_pools);
 	sm_state_counter = 0;
@@ -690,11 +728,15 @@ static void match_states_stree(struct stree **one, struct stree **two)
 {
 	struct smatch_state *tmp_state;
 	struct sm_state *sm;
-	struct state_list *add_to_one = NULL;
-	struct state_list *add_to_two = NULL;
+	struct sm_state **add_to_one, **add_to_two;
+	int nr_one = 0, nr_two = 0;
 	AvlIter one_iter;
 	AvlIter two_iter;
 
+	/* these are sorted so they can be added in one go */
+	add_to_one = malloc((stree_count(*two) + 1) * sizeof(*add_to_one));
+	add_to_two = malloc((stree_count(*one) + 1) * sizeof(*add_to_two));
+
 	__set_cur_stree_readonly();
 
 	avl_iter_begin(&one_iter, *one, FORWARD);
@@ -711,7 +753,7 @@ static void match_states_stree(struct stree **one, struct stree **two)
 			__pop_fake_cur_stree_fast();
 			sm = alloc_state_no_name(one_iter.sm->owner, one_iter.sm->name,
 						  one_iter.sm->sym, tmp_state);
-			add_ptr_list(&add_to_two, sm);
+			add_to_two[nr_two++] = sm;
 			avl_iter_next(&one_iter);
 		} else if (cmp_tracker(one_iter.sm, two_iter.sm) == 0) {
 			avl_iter_next(&one_iter);
@@ -724,23 +766,18 @@ static void match_states_stree(struct stree **one, struct stree **two)
 			__pop_fake_cur_stree_fast();
 			sm = alloc_state_no_name(two_iter.sm->owner, two_iter.sm->name,
 						  two_iter.sm->sym, tmp_state);
-			add_ptr_list(&add_to_one, sm);
+			add_to_one[nr_one++] = sm;
 			avl_iter_next(&two_iter);
 		}
 	}
 
 	__set_cur_stree_writable();
 
-	FOR_EACH_PTR(add_to_one, sm) {
-		avl_insert(one, sm);
-	} END_FOR_EACH_PTR(sm);
+	avl_insert_sorted(one, add_to_one, nr_one);
+	avl_insert_sorted(two, add_to_two, nr_two);
 
-	FOR_EACH_PTR(add_to_two, sm) {
-		avl_insert(two, sm);
-	} END_FOR_EACH_PTR(sm);
-
-	free_slist(&add_to_one);
-	free_slist(&add_to_two);
+	free(add_to_one);
+	free(add_to_two);
 }
 
 static void call_pre_merge_hooks(struct stree **one, struct stree **two)
@@ -781,21 +818,18 @@ static void call_pre_merge_hooks(struct stree **one, struct stree **two)
 
 static void clone_pool_havers_stree(struct stree **stree)
 {
-	struct sm_state *sm, *tmp;
-	struct state_list *slist = NULL;
+	struct sm_state **clones;
+	struct sm_state *sm;
+	int nr = 0;
 
+	clones = malloc((stree_count(*stree) + 1) * sizeof(*clones));
 	FOR_EACH_SM(*stree, sm) {
-		if (sm->pool) {
-			tmp = clone_sm(sm);
-			add_ptr_list(&slist, tmp);
-		}
+		if (sm->pool)
+			clones[nr++] = clone_sm(sm);
 	} END_FOR_EACH_SM(sm);
 
-	FOR_EACH_PTR(slist, sm) {
-		avl_insert(stree, sm);
-	} END_FOR_EACH_PTR(sm);
-
-	free_slist(&slist);
+	avl_insert_sorted(stree, clones, nr);
+	free(clones);
 }
 
 int __stree_id;
@@ -806,7 +840,8 @@ int __stree_id;
  */
 static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 {
-	struct stree *results = NULL;
+	struct sm_state **results;
+	int nr = 0;
 	struct stree *implied_one = NULL;
 	struct stree *implied_two = NULL;
 	AvlIter one_iter;
@@ -848,6 +883,9 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 	push_stree(&all_pools, implied_one);
 	push_stree(&all_pools, implied_two);
 
+	/* the results come out in order so the stree is built at the end */
+	results = malloc((stree_count(implied_one) + 1) * sizeof(*results));
+
 	avl_iter_begin(&one_iter, implied_one, FORWARD);
 	avl_iter_begin(&two_iter, implied_two, FORWARD);
 
@@ -859,7 +897,7 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 		two = two_iter.sm;
 
 		if (one == two) {
-			avl_insert(&results, one);
+			results[nr++] = one;
 			goto next;
 		}
 
@@ -874,14 +912,15 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 		res = merge_sm_states(one, two);
 		add_possible_sm(res, one);
 		add_possible_sm(res, two);
-		avl_insert(&results, res);
+		results[nr++] = res;
 next:
 		avl_iter_next(&one_iter);
 		avl_iter_next(&two_iter);
 	}
 
 	free_stree(to);
-	*to = results;
+	*to = avl_from_sorted(results, nr);
+	free(results);
 }
 
 void merge_stree(struct stree **to, struct stree *stree)
@@ -975,24 +1014,25 @@ void merge_fake_stree(struct stree **to, struct stree *stree)
  */
 void filter_stree(struct stree **stree, struct stree *filter)
 {
-	struct stree *results = NULL;
+	struct sm_state **results;
+	int nr = 0;
 	AvlIter one_iter;
 	AvlIter two_iter;
 
+	results = malloc((stree_count(*stree) + 1) * sizeof(*results));
+
 	avl_iter_begin(&one_iter, *stree, FORWARD);
 	avl_iter_begin(&two_iter, filter, FORWARD);
 
-	/* FIXME: This should probably be re-written with trees in mind */
-
 	for (;;) {
 		if (!one_iter.sm && !two_iter.sm)
 			break;
 		if (cmp_tracker(one_iter.sm, two_iter.sm) < 0) {
-			avl_insert(&results, one_iter.sm);
+			results[nr++] = one_iter.sm;
 			avl_iter_next(&one_iter);
 		} else if (cmp_tracker(one_iter.sm, two_iter.sm) == 0) {
 			if (one_iter.sm != two_iter.sm)
-				avl_insert(&results, one_iter.sm);
+				results[nr++] = one_iter.sm;
 			avl_iter_next(&one_iter);
 			avl_iter_next(&two_iter);
 		} else {
@@ -1001,7 +1041,8 @@ void filter_stree(struct stree **stree, struct stree *filter)
 	}
 
 	free_stree(stree);
-	*stree = results;
+	*stree = avl_from_sorted(results, nr);
+	free(results);
 }
 
 
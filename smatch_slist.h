@@ -1,6 +1,7 @@
 struct stree;
 
 extern int unfree_stree;
+extern unsigned long avl_node_count;
 
 DECLARE_PTR_LIST(state_list, struct sm_state);
 DECLARE_PTR_LIST(state_list_stack, struct state_list);
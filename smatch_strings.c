@@ -112,9 +112,6 @@ static void match_assignment(struct expression *expr)
 	struct state_list *slist;
 	struct sm_state *sm;
 
-	if (expr->op != '=')
-		return;
-
 	slist = get_strings(strip_expr(expr->right));
 	if (!slist)
 		return;
@@ -150,7 +147,7 @@ void register_strings(int id)
 	add_function_hook("strlcpy", &match_strcpy, NULL);
 	add_function_hook("strncpy", &match_strcpy, NULL);
 
-	add_hook(&match_assignment, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_assignment, ASSIGNMENT_HOOK, '=');
 	add_hook(&match_string, STRING_HOOK);
 
 }
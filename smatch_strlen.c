@@ -62,8 +62,6 @@ static void match_string_assignment(struct expression *expr)
 {
 	struct range_list *rl;
 
-	if (expr->op != '=')
-		return;
 	if (!get_implied_strlen(expr->right, &rl))
 		return;
 	set_state_expr(my_strlen_id, expr->left, alloc_estate_rl(clone_rl(rl)));
@@ -338,7 +336,7 @@ void register_strlen(int id)
 	add_unmatched_state_hook(my_strlen_id, &unmatched_strlen_state);
 
 	select_caller_info_hook(set_param_strlen, STR_LEN);
-	add_hook(&match_string_assignment, ASSIGNMENT_HOOK);
+	add_filtered_hook(&match_string_assignment, ASSIGNMENT_HOOK, '=');
 
 	add_modification_hook(my_strlen_id, &set_strlen_undefined);
 	add_merge_hook(my_strlen_id, &merge_estates);
@@ -491,10 +491,6 @@ static void match_sscanf(const char *fn, struct expression *expr, void *unused)
 
 static void unop_expr(struct expression *expr)
 {
-	if (expr->op != SPECIAL_INCREMENT &&
-	    expr->op != SPECIAL_DECREMENT)
-		return;
-
 	if (!is_pointer(expr))
 		return;
 	faked_expression = expr;
@@ -563,7 +559,8 @@ void register_struct_assignment(int id)
 
 	add_function_hook("sscanf", &match_sscanf, NULL);
 
-	add_hook(&unop_expr, OP_HOOK);
+	add_filtered_hook(&unop_expr, OP_HOOK, SPECIAL_INCREMENT);
+	add_filtered_hook(&unop_expr, OP_HOOK, SPECIAL_DECREMENT);
 	register_clears_param();
 	select_return_states_hook(PARAM_CLEARED, &db_param_cleared);
 
@@ -547,9 +547,6 @@ static void unop_expr(struct expression *expr)
 	struct range_list *rl;
 	char *member;
 
-	if (expr->op != SPECIAL_DECREMENT && expr->op != SPECIAL_INCREMENT)
-		return;
-
 	expr = strip_expr(expr->unop);
 	member = get_member_name(expr);
 	if (!member)
@@ -657,7 +654,8 @@ void register_type_val(int id)
 
 	add_hook(&match_assign_value, ASSIGNMENT_HOOK_AFTER);
 	add_hook(&match_assign_pointer, ASSIGNMENT_HOOK);
-	add_hook(&unop_expr, OP_HOOK);
+	add_filtered_hook(&unop_expr, OP_HOOK, SPECIAL_INCREMENT);
+	add_filtered_hook(&unop_expr, OP_HOOK, SPECIAL_DECREMENT);
 	add_hook(&asm_expr, ASM_HOOK);
 	select_return_states_hook(PARAM_ADD, &db_param_add);
 	select_return_states_hook(PARAM_SET, &db_param_add);
@@ -832,7 +832,15 @@ struct symbol	zero_int;
 
 void init_symbols(void)
 {
-	int stream = init_stream(NULL, "builtin", -1, includepath);
+	static int done;
+	int stream;
+
+	/* smatch --server calls this early so the builtin idents come first */
+	if (done)
+		return;
+	done = 1;
+
+	stream = init_stream(NULL, "builtin", -1, includepath);
 
 #define __IDENT(n,str,res) \
 	hash_ident(&n)
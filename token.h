@@ -223,6 +223,8 @@ extern const char *stream_name(int stream);
 struct ident *alloc_ident(const char *name, int len);
 extern struct ident *hash_ident(struct ident *);
 extern struct ident *built_in_ident(const char *);
+extern struct ident *lookup_ident(const char *);
+extern struct ident *create_ident(const char *name, int len);
 extern struct token *built_in_token(int, struct ident *);
 extern const char *show_special(int);
 extern const char *show_ident(const struct ident *);
@@ -237,6 +239,18 @@ extern void init_include_path(void);
 extern struct token *preprocess(struct token *);
 
 extern void store_all_tokens(struct token *token);
+
+extern const char *token_cache_dir;
+extern struct token *load_cached_tokens(const char *name, int fd, int stream, struct token **endp);
+extern void save_cached_tokens(const char *name, int fd, struct token *begin, struct token *end);
+extern const char *save_snapshot_file;
+extern const char *load_snapshot_file;
+extern void start_snapshot(void);
+extern void snapshot_raw_tokens(struct token *token);
+extern void snapshot_diagnostic(const char *type, struct position pos, const char *msg);
+extern void snapshot_macro_pos(struct token *token);
+extern void finish_snapshot(struct token *token);
+extern struct token *load_snapshot(const char *name);
 extern struct token *pos_get_token(struct position pos);
 extern char *pos_ident(struct position pos);
 
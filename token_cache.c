@@ -0,0 +1,689 @@
+/*
+ * Copyright (C) 2021 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * When we check a kernel every file includes the same headers and each
+ * smatch process tokenizes them again.  With --token-cache=<dir> the
+ * tokens for each header are saved in <dir> the first time and the later
+ * processes mmap() the file and copy the tokens out instead of lexing the
+ * header.
+ *
+ * The cache is only the output of the tokenizer, before the preprocessor
+ * runs, so it doesn't depend on which macros are defined.  A cache file is
+ * only used if the inode, size and mtime of the header match and it was
+ * written with the same tabstop.  If lexing the header printed a warning
+ * then we don't cache it so the warning is printed every time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib.h"
+#include "allocate.h"
+#include "token.h"
+#include "symbol.h"
+
+#define TOKEN_CACHE_MAGIC "smatch-tokens-1"
+
+const char *token_cache_dir;
+
+struct token_cache_header {
+	char magic[16];
+	unsigned long long dev, ino, size;
+	long long mtime_sec, mtime_nsec;
+	unsigned int tabstop;
+	unsigned int no_lineno;
+	unsigned int nr_tokens;
+	unsigned int name_len;
+};
+
+static void get_cache_filename(const char *name, char *buf, int size)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)name; *p; p++) {
+		hash ^= *p;
+		hash *= 0x100000001b3ULL;
+	}
+	snprintf(buf, size, "%s/%016llx.tok", token_cache_dir, hash);
+}
+
+static int fill_header(struct token_cache_header *hdr, const char *name, int fd)
+{
+	struct stat st;
+
+	if (fstat(fd, &st))
+		return -1;
+
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, TOKEN_CACHE_MAGIC, sizeof(TOKEN_CACHE_MAGIC));
+	hdr->dev = st.st_dev;
+	hdr->ino = st.st_ino;
+	hdr->size = st.st_size;
+	hdr->mtime_sec = st.st_mtim.tv_sec;
+	hdr->mtime_nsec = st.st_mtim.tv_nsec;
+	hdr->tabstop = tabstop;
+	hdr->no_lineno = no_lineno;
+	hdr->name_len = strlen(name);
+	return 0;
+}
+
+/*
+ * The tokens are a struct position followed by whatever the type needs:
+ * the name for idents, the text and NUL for numbers, the data for strings
+ * and chars and the four bytes for the short chars.
+ */
+static void write_token(FILE *fp, struct token *token)
+{
+	struct string *string;
+	unsigned int len;
+
+	fwrite(&token->pos, sizeof(token->pos), 1, fp);
+
+	switch (token_type(token)) {
+	case TOKEN_IDENT:
+		fwrite(&token->ident->len, 1, 1, fp);
+		fwrite(token->ident->name, token->ident->len, 1, fp);
+		break;
+	case TOKEN_NUMBER:
+		len = strlen(token->number) + 1;
+		fwrite(&len, sizeof(len), 1, fp);
+		fwrite(token->number, len, 1, fp);
+		break;
+	case TOKEN_CHAR:
+	case TOKEN_WIDE_CHAR:
+	case TOKEN_STRING:
+	case TOKEN_WIDE_STRING:
+		string = token->string;
+		len = string->length;
+		fwrite(&len, sizeof(len), 1, fp);
+		fwrite(string->data, len, 1, fp);
+		break;
+	case TOKEN_CHAR_EMBEDDED_0 ... TOKEN_CHAR_EMBEDDED_3:
+	case TOKEN_WIDE_CHAR_EMBEDDED_0 ... TOKEN_WIDE_CHAR_EMBEDDED_3:
+		fwrite(token->embedded, 4, 1, fp);
+		break;
+	case TOKEN_SPECIAL:
+		fwrite(&token->special, sizeof(token->special), 1, fp);
+		break;
+	}
+}
+
+static int cacheable_token(struct token *token)
+{
+	switch (token_type(token)) {
+	case TOKEN_STREAMBEGIN:
+	case TOKEN_STREAMEND:
+	case TOKEN_IDENT:
+	case TOKEN_NUMBER:
+	case TOKEN_CHAR ... TOKEN_WIDE_STRING:
+	case TOKEN_SPECIAL:
+		return 1;
+	}
+	return 0;
+}
+
+void save_cached_tokens(const char *name, int fd, struct token *begin, struct token *end)
+{
+	struct token_cache_header hdr;
+	char filename[PATH_MAX];
+	char tmp[PATH_MAX + 32];
+	struct token *token;
+	FILE *fp;
+
+	if (fill_header(&hdr, name, fd))
+		return;
+
+	for (token = begin; ; token = token->next) {
+		if (!cacheable_token(token))
+			return;
+		hdr.nr_tokens++;
+		if (token == end)
+			break;
+	}
+
+	/* write it to the side and rename() it so the readers never see half a file */
+	get_cache_filename(name, filename, sizeof(filename));
+	snprintf(tmp, sizeof(tmp), "%s.%d", filename, getpid());
+	fp = fopen(tmp, "w");
+	if (!fp)
+		return;
+	fwrite(&hdr, sizeof(hdr), 1, fp);
+	fwrite(name, hdr.name_len, 1, fp);
+	for (token = begin; ; token = token->next) {
+		write_token(fp, token);
+		if (token == end)
+			break;
+	}
+	if (fclose(fp) || rename(tmp, filename))
+		unlink(tmp);
+}
+
+struct cache_reader {
+	const char *p, *end;
+};
+
+static const void *read_bytes(struct cache_reader *r, unsigned int len)
+{
+	const char *ret = r->p;
+
+	if (len > r->end - r->p)
+		return NULL;
+	r->p += len;
+	return ret;
+}
+
+static int read_len(struct cache_reader *r, unsigned int *len)
+{
+	const void *p;
+
+	p = read_bytes(r, sizeof(*len));
+	if (!p)
+		return -1;
+	memcpy(len, p, sizeof(*len));
+	return 0;
+}
+
+/* The stream number is left as it was when it was saved */
+static int read_token(struct cache_reader *r, struct token *token)
+{
+	const unsigned char *identlen;
+	const void *pos, *data;
+	struct string *string;
+	unsigned int len;
+
+	pos = read_bytes(r, sizeof(token->pos));
+	if (!pos)
+		return -1;
+	memcpy(&token->pos, pos, sizeof(token->pos));
+
+	switch (token_type(token)) {
+	case TOKEN_STREAMBEGIN:
+	case TOKEN_STREAMEND:
+		return 0;
+	case TOKEN_IDENT:
+		identlen = read_bytes(r, 1);
+		if (!identlen || !*identlen)
+			return -1;
+		data = read_bytes(r, *identlen);
+		if (!data)
+			return -1;
+		token->ident = create_ident(data, *identlen);
+		return 0;
+	case TOKEN_NUMBER:
+		if (read_len(r, &len) || !len)
+			return -1;
+		data = read_bytes(r, len);
+		if (!data || ((const char *)data)[len - 1] != '\0')
+			return -1;
+		token->number = xmemdup(data, len);
+		return 0;
+	case TOKEN_CHAR:
+	case TOKEN_WIDE_CHAR:
+	case TOKEN_STRING:
+	case TOKEN_WIDE_STRING:
+		if (read_len(r, &len) || len > MAX_STRING + 1)
+			return -1;
+		data = read_bytes(r, len);
+		if (!data)
+			return -1;
+		string = __alloc_string(len);
+		memcpy(string->data, data, len);
+		string->length = len;
+		token->string = string;
+		return 0;
+	case TOKEN_CHAR_EMBEDDED_0 ... TOKEN_CHAR_EMBEDDED_3:
+	case TOKEN_WIDE_CHAR_EMBEDDED_0 ... TOKEN_WIDE_CHAR_EMBEDDED_3:
+		data = read_bytes(r, 4);
+		if (!data)
+			return -1;
+		memcpy(token->embedded, data, 4);
+		return 0;
+	case TOKEN_SPECIAL:
+		data = read_bytes(r, sizeof(token->special));
+		if (!data)
+			return -1;
+		memcpy(&token->special, data, sizeof(token->special));
+		return 0;
+	}
+	return -1;
+}
+
+static struct token *read_tokens(struct cache_reader *r, int nr_tokens, int stream, struct token **endp)
+{
+	struct token *begin = NULL, *token;
+	struct token **next = &begin;
+	int i;
+
+	for (i = 0; i < nr_tokens; i++) {
+		token = __alloc_token(0);
+		token->next = NULL;
+		*next = token;
+		next = &token->next;
+		/* the idents and strings that were already made just leak */
+		if (read_token(r, token))
+			return NULL;
+		token->pos.stream = stream;
+	}
+	if (!begin || token_type(begin) != TOKEN_STREAMBEGIN ||
+	    token_type(token) != TOKEN_STREAMEND)
+		return NULL;
+
+	/* this is what mark_eof() does */
+	eof_token_entry.pos = token->pos;
+	token_type(&eof_token_entry) = TOKEN_EOF;
+	eof_token_entry.next = &eof_token_entry;
+	token->next = &eof_token_entry;
+
+	*endp = token;
+	return begin;
+}
+
+struct token *load_cached_tokens(const char *name, int fd, int stream, struct token **endp)
+{
+	struct token_cache_header want;
+	const struct token_cache_header *hdr;
+	struct cache_reader r;
+	char filename[PATH_MAX];
+	struct token *ret = NULL;
+	struct stat st;
+	void *map;
+	int cache_fd;
+
+	if (fill_header(&want, name, fd))
+		return NULL;
+
+	get_cache_filename(name, filename, sizeof(filename));
+	cache_fd = open(filename, O_RDONLY);
+	if (cache_fd < 0)
+		return NULL;
+	if (fstat(cache_fd, &st) || st.st_size < sizeof(*hdr)) {
+		close(cache_fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, cache_fd, 0);
+	close(cache_fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	hdr = map;
+	want.nr_tokens = hdr->nr_tokens;
+	if (memcmp(hdr, &want, sizeof(want)) != 0)
+		goto unmap;
+
+	r.p = (const char *)map + sizeof(*hdr);
+	r.end = (const char *)map + st.st_size;
+	if (hdr->name_len > r.end - r.p ||
+	    memcmp(r.p, name, hdr->name_len) != 0)
+		goto unmap;
+	r.p += hdr->name_len;
+
+	ret = read_tokens(&r, hdr->nr_tokens, stream, endp);
+unmap:
+	munmap(map, st.st_size);
+	return ret;
+}
+
+/*
+ * --save-snapshot=<file> saves what the front end needs to rebuild the
+ * preprocessed token stream for a file, and --snapshot=<file> loads it
+ * instead of opening the file so none of the headers are read or
+ * preprocessed.  The parser and evaluator still run on the loaded tokens;
+ * the symbols point into each other too much to be worth saving.
+ *
+ * A snapshot has the streams that were opened for the file, the raw tokens
+ * of the file for token_store.c, the positions of the macros which were
+ * expanded for get_macro_name(), the warnings from the tokenizer and the
+ * preprocessor so they are printed again, the object-like macros which are
+ * defined at the end for lookup_macro_symbol() and the preprocessed tokens.
+ * The stream numbers are moved if the command line opened a different
+ * number of streams than when it was saved.  The function-like macros are
+ * not saved.
+ */
+
+#define SNAPSHOT_MAGIC "smatch-snap-2"
+
+const char *save_snapshot_file;
+const char *load_snapshot_file;
+
+struct snapshot_header {
+	char magic[16];
+	unsigned int tabstop;
+	unsigned int no_lineno;
+	unsigned int first_stream;
+	unsigned int nr_streams;
+	unsigned int nr_raw;
+	unsigned int nr_macros;
+	unsigned int nr_diags;
+	unsigned int nr_defines;
+	unsigned int nr_tokens;
+	unsigned int name_len;
+};
+
+static struct snapshot_header snap;
+enum snapshot_diag_type {
+	SNAP_ERROR,
+	SNAP_WARNING,
+	SNAP_INFO,
+};
+
+static FILE *snap_raw, *snap_macros, *snap_diags, *snap_defines;
+static char *snap_raw_buf, *snap_macros_buf, *snap_diags_buf, *snap_defines_buf;
+static size_t snap_raw_size, snap_macros_size, snap_diags_size, snap_defines_size;
+static int snap_failed;
+
+/* This is called before the file is tokenized so we see all the warnings */
+void start_snapshot(void)
+{
+	memset(&snap, 0, sizeof(snap));
+	snap.first_stream = input_stream_nr;
+
+	snap_raw = open_memstream(&snap_raw_buf, &snap_raw_size);
+	snap_macros = open_memstream(&snap_macros_buf, &snap_macros_size);
+	snap_diags = open_memstream(&snap_diags_buf, &snap_diags_size);
+	if (!snap_raw || !snap_macros || !snap_diags)
+		die("cannot start snapshot");
+}
+
+void snapshot_raw_tokens(struct token *token)
+{
+	if (!snap_raw)
+		return;
+
+	for (;; token = token->next) {
+		if (!cacheable_token(token))
+			snap_failed = 1;
+		write_token(snap_raw, token);
+		snap.nr_raw++;
+		if (token_type(token) == TOKEN_STREAMEND)
+			break;
+	}
+}
+
+void snapshot_macro_pos(struct token *token)
+{
+	if (!snap_macros)
+		return;
+	fwrite(&token->pos, sizeof(token->pos), 1, snap_macros);
+	fwrite(&token->ident->len, 1, 1, snap_macros);
+	fwrite(token->ident->name, token->ident->len, 1, snap_macros);
+	snap.nr_macros++;
+}
+
+void snapshot_diagnostic(const char *type, struct position pos, const char *msg)
+{
+	unsigned char diag_type;
+	unsigned int len;
+
+	if (!snap_diags)
+		return;
+	if (strcmp(type, "error: ") == 0)
+		diag_type = SNAP_ERROR;
+	else if (strcmp(type, "warning: ") == 0)
+		diag_type = SNAP_WARNING;
+	else
+		diag_type = SNAP_INFO;
+	len = strlen(msg) + 1;
+
+	fwrite(&diag_type, 1, 1, snap_diags);
+	fwrite(&pos, sizeof(pos), 1, snap_diags);
+	fwrite(&len, sizeof(len), 1, snap_diags);
+	fwrite(msg, len, 1, snap_diags);
+	snap.nr_diags++;
+}
+
+/* The expansion ends with a TOKEN_UNTAINT which isn't saved */
+static void snapshot_define(struct symbol *sym)
+{
+	struct token *token;
+	unsigned int nr = 0;
+
+	for (token = sym->expansion; token_type(token) != TOKEN_UNTAINT; token = token->next) {
+		/* "##" is a TOKEN_CONCAT and those are rare enough to skip */
+		if (!cacheable_token(token))
+			return;
+		nr++;
+	}
+
+	fwrite(&sym->pos, sizeof(sym->pos), 1, snap_defines);
+	fwrite(&sym->ident->len, 1, 1, snap_defines);
+	fwrite(sym->ident->name, sym->ident->len, 1, snap_defines);
+	fwrite(&nr, sizeof(nr), 1, snap_defines);
+	for (token = sym->expansion; token_type(token) != TOKEN_UNTAINT; token = token->next)
+		write_token(snap_defines, token);
+	snap.nr_defines++;
+}
+
+void finish_snapshot(struct token *begin)
+{
+	struct token *token;
+	unsigned int len;
+	int i;
+	FILE *fp;
+
+	if (!snap_raw)
+		return;
+	snap_defines = open_memstream(&snap_defines_buf, &snap_defines_size);
+	if (!snap_defines)
+		die("cannot start snapshot");
+	for_each_object_macro(snapshot_define);
+	fclose(snap_raw);
+	fclose(snap_macros);
+	fclose(snap_diags);
+	fclose(snap_defines);
+	snap_raw = snap_macros = snap_diags = snap_defines = NULL;
+
+	for (token = begin; !eof_token(token); token = token->next) {
+		if (!cacheable_token(token))
+			snap_failed = 1;
+		snap.nr_tokens++;
+	}
+	if (snap_failed) {
+		sparse_error(begin->pos, "cannot save snapshot '%s'", save_snapshot_file);
+		goto free;
+	}
+
+	memcpy(snap.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	snap.tabstop = tabstop;
+	snap.no_lineno = no_lineno;
+	snap.nr_streams = input_stream_nr - snap.first_stream;
+	snap.name_len = strlen(base_filename);
+
+	fp = fopen(save_snapshot_file, "w");
+	if (!fp)
+		die("cannot open '%s'", save_snapshot_file);
+	fwrite(&snap, sizeof(snap), 1, fp);
+	fwrite(base_filename, snap.name_len, 1, fp);
+	for (i = snap.first_stream; i < input_stream_nr; i++) {
+		fwrite(&input_streams[i].pos, sizeof(struct position), 1, fp);
+		len = strlen(input_streams[i].name) + 1;
+		fwrite(&len, sizeof(len), 1, fp);
+		fwrite(input_streams[i].name, len, 1, fp);
+	}
+	fwrite(snap_raw_buf, snap_raw_size, 1, fp);
+	fwrite(snap_macros_buf, snap_macros_size, 1, fp);
+	fwrite(snap_diags_buf, snap_diags_size, 1, fp);
+	fwrite(snap_defines_buf, snap_defines_size, 1, fp);
+	for (token = begin; !eof_token(token); token = token->next)
+		write_token(fp, token);
+	if (fclose(fp))
+		die("cannot write '%s'", save_snapshot_file);
+free:
+	free(snap_raw_buf);
+	free(snap_macros_buf);
+	free(snap_diags_buf);
+	free(snap_defines_buf);
+}
+
+static void move_stream(struct position *pos, int delta)
+{
+	if (pos->stream >= snap.first_stream &&
+	    pos->stream < snap.first_stream + snap.nr_streams)
+		pos->stream += delta;
+}
+
+static struct token *read_snapshot_tokens(struct cache_reader *r, int nr, int delta)
+{
+	struct token *begin = NULL, *token = NULL;
+	struct token **next = &begin;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		token = __alloc_token(0);
+		token->next = NULL;
+		*next = token;
+		next = &token->next;
+		if (read_token(r, token))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		move_stream(&token->pos, delta);
+	}
+	if (token)
+		token->next = &eof_token_entry;
+	return begin;
+}
+
+static void replay_diagnostics(struct cache_reader *r, int delta)
+{
+	const unsigned char *diag_type;
+	struct position pos;
+	const char *msg;
+	unsigned int len;
+	int i;
+
+	for (i = 0; i < snap.nr_diags; i++) {
+		diag_type = read_bytes(r, 1);
+		if (!diag_type || !read_bytes(r, sizeof(pos)))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		memcpy(&pos, r->p - sizeof(pos), sizeof(pos));
+		move_stream(&pos, delta);
+		if (read_len(r, &len) || !len ||
+		    !(msg = read_bytes(r, len)) || msg[len - 1] != '\0')
+			die("corrupt snapshot '%s'", load_snapshot_file);
+
+		switch (*diag_type) {
+		case SNAP_ERROR:
+			sparse_error(pos, "%s", msg);
+			break;
+		case SNAP_WARNING:
+			warning(pos, "%s", msg);
+			break;
+		default:
+			info(pos, "%s", msg);
+		}
+	}
+}
+
+struct token *load_snapshot(const char *name)
+{
+	const unsigned char *identlen;
+	const char *stream_name;
+	struct cache_reader r;
+	struct ident *ident;
+	struct position pos;
+	struct token *token;
+	struct stat st;
+	unsigned int len;
+	int delta;
+	void *map;
+	int fd, i;
+
+	fd = open(load_snapshot_file, O_RDONLY);
+	if (fd < 0)
+		die("No such file: %s", load_snapshot_file);
+	if (fstat(fd, &st) || st.st_size < sizeof(snap))
+		die("corrupt snapshot '%s'", load_snapshot_file);
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		die("cannot read '%s'", load_snapshot_file);
+
+	memcpy(&snap, map, sizeof(snap));
+	if (memcmp(snap.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+	    snap.tabstop != tabstop || snap.no_lineno != no_lineno)
+		die("'%s' is not a snapshot for these options", load_snapshot_file);
+
+	r.p = (const char *)map + sizeof(snap);
+	r.end = (const char *)map + st.st_size;
+	if (snap.name_len != strlen(name) ||
+	    !read_bytes(&r, snap.name_len) ||
+	    memcmp(r.p - snap.name_len, name, snap.name_len) != 0)
+		die("snapshot '%s' is not for %s", load_snapshot_file, name);
+
+	delta = input_stream_nr - snap.first_stream;
+	for (i = 0; i < snap.nr_streams; i++) {
+		if (!read_bytes(&r, sizeof(pos)))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		memcpy(&pos, r.p - sizeof(pos), sizeof(pos));
+		move_stream(&pos, delta);
+		if (read_len(&r, &len) || !len ||
+		    !(stream_name = read_bytes(&r, len)) || stream_name[len - 1] != '\0')
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		/* lib.c checks for base_filename by pointer */
+		if (i == 0)
+			stream_name = name;
+		else
+			stream_name = xmemdup(stream_name, len);
+		init_stream(&pos, stream_name, -1, NULL);
+	}
+
+	token = read_snapshot_tokens(&r, snap.nr_raw, delta);
+	if (!token || token_type(token) != TOKEN_STREAMBEGIN)
+		die("corrupt snapshot '%s'", load_snapshot_file);
+	store_all_tokens(token);
+
+	for (i = 0; i < snap.nr_macros; i++) {
+		token = __alloc_token(0);
+		if (!read_bytes(&r, sizeof(token->pos)))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		memcpy(&token->pos, r.p - sizeof(token->pos), sizeof(token->pos));
+		move_stream(&token->pos, delta);
+		identlen = read_bytes(&r, 1);
+		if (!identlen || !read_bytes(&r, *identlen))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		token->ident = create_ident(r.p - *identlen, *identlen);
+		store_macro_pos(token);
+	}
+
+	replay_diagnostics(&r, delta);
+
+	for (i = 0; i < snap.nr_defines; i++) {
+		if (!read_bytes(&r, sizeof(pos)))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		memcpy(&pos, r.p - sizeof(pos), sizeof(pos));
+		move_stream(&pos, delta);
+		identlen = read_bytes(&r, 1);
+		if (!identlen || !read_bytes(&r, *identlen))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		ident = create_ident(r.p - *identlen, *identlen);
+		if (read_len(&r, &len))
+			die("corrupt snapshot '%s'", load_snapshot_file);
+		token = read_snapshot_tokens(&r, len, delta);
+		define_object_macro(pos, ident, token ? token : &eof_token_entry);
+	}
+
+	token = read_snapshot_tokens(&r, snap.nr_tokens, delta);
+	munmap(map, st.st_size);
+	if (!token)
+		return &eof_token_entry;
+	return token;
+}
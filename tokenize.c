@@ -906,6 +906,28 @@ struct ident *built_in_ident(const char *name)
 	return create_hashed_ident(name, len, hash_name(name, len));
 }
 
+struct ident *create_ident(const char *name, int len)
+{
+	return create_hashed_ident(name, len, hash_name(name, len));
+}
+
+/* Like built_in_ident() but it returns NULL instead of adding a new ident. */
+struct ident *lookup_ident(const char *name)
+{
+	struct ident *ident;
+	int len = strlen(name);
+
+	if (!len || len > 255)
+		return NULL;
+
+	ident = hash_table[hash_name(name, len)];
+	for (; ident; ident = ident->next) {
+		if (ident->len == len && strncmp(name, ident->name, len) == 0)
+			return ident;
+	}
+	return NULL;
+}
+
 struct token *built_in_token(int stream, struct ident *ident)
 {
 	struct token *token;
@@ -1025,6 +1047,7 @@ struct token * tokenize(const struct position *pos, const char *name, int fd, st
 	struct token *begin, *end;
 	stream_t stream;
 	unsigned char buffer[BUFSIZE];
+	unsigned int diagnostics = 0;
 	int idx;
 
 	idx = init_stream(pos, name, fd, next_path);
@@ -1033,8 +1056,19 @@ struct token * tokenize(const struct position *pos, const char *name, int fd, st
 		return endtoken;
 	}
 
+	/* only the headers are cached, see token_cache.c */
+	if (pos && token_cache_dir) {
+		begin = load_cached_tokens(name, fd, idx, &end);
+		if (begin)
+			goto done;
+		diagnostics = nr_diagnostics;
+	}
+
 	begin = setup_stream(&stream, idx, fd, buffer, 0);
 	end = tokenize_stream(&stream);
+	if (pos && token_cache_dir && diagnostics == nr_diagnostics)
+		save_cached_tokens(name, fd, begin, end);
+done:
 	if (endtoken)
 		end->next = endtoken;
 	return begin;
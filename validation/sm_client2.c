@@ -0,0 +1,11 @@
+/*
+ * check-name: smatch --client #2
+ * check-command: validation/smatch_client_test.sh -I.. sm_select.c
+ *
+ * check-output-start
+sm_select.c:17 func() error: we previously assumed 'a' could be null (see line 13)
+sm_select.c:18 func() error: we previously assumed 'b' could be null (see line 13)
+sm_select.c:21 func() warn: variable dereferenced before check 'e' (see line 19)
+sm_select.c:22 func() error: we previously assumed 'c' could be null (see line 21)
+ * check-output-end
+ */
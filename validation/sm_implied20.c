@@ -0,0 +1,31 @@
+#include "check_debug.h"
+
+int frob(void);
+
+int a, b;
+
+void func(void)
+{
+	a = 0;
+	b = 0;
+	if (frob())
+		a = 1;
+	if (frob())
+		b = 1;
+	if (frob())
+		a = 2;
+
+	if (a == 1) {
+		__smatch_implied_pools();
+		__smatch_implied(b);
+	}
+}
+/*
+ * check-name: smatch implied #20
+ * check-command: smatch -I.. sm_implied20.c
+ *
+ * check-output-start
+sm_implied20.c:19 func() implied pools: true = 1 false = 2 maybe = 1 visited = 5
+sm_implied20.c:20 func() implied: b = '0-1'
+ * check-output-end
+ */
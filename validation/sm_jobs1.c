@@ -0,0 +1,22 @@
+/*
+ * check-name: smatch --jobs #1
+ * check-command: validation/smatch_jobs_test.sh -I.. sm_skb2.c
+ *
+ * check-output-start
+sm_skb2.c:27 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:27 frob() user rl: '*skb->data' = '0-255'
+sm_skb2.c:28 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:28 frob() user rl: 'skb->data + 1' = ''
+sm_skb2.c:29 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:29 frob() user rl: '*skb->data' = 's32min-s32max'
+sm_skb2.c:30 frob() info: param_mapper 0 => skb_network_header 0
+sm_skb2.c:30 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:30 frob() user rl: 'skb->data - skb_network_header(skb)' = ''
+sm_skb2.c:36 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:36 frob() user rl: 'p->a' = ''
+sm_skb2.c:37 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:37 frob() user rl: 'x' = ''
+sm_skb2.c:38 frob() no user data for project = 'smatch_generic'
+sm_skb2.c:38 frob() user rl: 'y' = ''
+ * check-output-end
+ */
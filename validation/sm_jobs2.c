@@ -0,0 +1,15 @@
+/*
+ * check-name: smatch --jobs #2
+ * check-command: validation/smatch_jobs_test.sh -I.. sm_user_data4.c
+ *
+ * check-output-start
+sm_user_data4.c:14 returns_user_data() info: sizeof_param 'copy_from_user' 2
+sm_user_data4.c:21 returns_user_member() info: sizeof_param 'copy_from_user' 2
+sm_user_data4.c:30 test() no user data for project = 'smatch_generic'
+sm_user_data4.c:30 test() user rl: 'x' = ''
+sm_user_data4.c:32 test() no user data for project = 'smatch_generic'
+sm_user_data4.c:32 test() user rl: 'p' = ''
+sm_user_data4.c:33 test() no user data for project = 'smatch_generic'
+sm_user_data4.c:33 test() user rl: 'p->x' = ''
+ * check-output-end
+ */
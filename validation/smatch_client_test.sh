@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Checking a file through --client has to print the same thing as a normal
+# run.  The mtag_map rows are left out because the fresh mtags are random.
+
+sock=$(mktemp -u)
+normal=$(mktemp)
+client=$(mktemp)
+
+../smatch --info --server=$sock &
+server=$!
+for i in $(seq 50) ; do
+    [ -S $sock ] && break
+    sleep 0.1
+done
+
+../smatch --info $* | grep -v 'insert into mtag_map' > $normal
+../smatch --client=$sock $* | grep -v 'insert into mtag_map' > $client
+diff -u $normal $client
+grep -v "() SQL" $client
+
+kill $server
+wait $server 2>/dev/null
+rm -f $sock $normal $client
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# --jobs has to print the same thing as a normal run.  The SQL is left out
+# because the workers number the return_ids differently.
+
+serial=$(mktemp)
+jobs=$(mktemp)
+
+../smatch --info $* | grep -v '() SQL' > $serial
+../smatch --info --jobs=2 $* | grep -v '() SQL' > $jobs
+diff -u $serial $jobs
+cat $jobs
+
+rm -f $serial $jobs